@@ -5,6 +5,9 @@
 #include "classes/Othello.h"
 #include "classes/Connect4.h"
 #include "classes/Chess.h"
+#include "classes/TextureCache.h"
+#include "classes/FramePacer.h"
+#include <algorithm>
 
 namespace ClassGame {
         //
@@ -13,6 +16,7 @@ namespace ClassGame {
         Game *game = nullptr;
         bool gameOver = false;
         int gameWinner = -1;
+        FramePacer framePacer;
 
         //
         // game starting point
@@ -21,6 +25,8 @@ namespace ClassGame {
         void GameStartUp() 
         {
             game = nullptr;
+            // decode the images on worker threads while the window comes up
+            TextureCache::shared().preload();
         }
 
         //
@@ -29,8 +35,12 @@ namespace ClassGame {
         //
         void RenderGame() 
         {
+                framePacer.beginFrame();
                 ImGui::DockSpaceOverViewport();
 
+                // the preload's GPU upload happens here once its workers are done
+                TextureCache::shared().update();
+
                 //ImGui::ShowDemoWindow();
 
                 ImGui::Begin("Settings");
@@ -68,6 +78,12 @@ namespace ClassGame {
                     }
                 } else {
                     ImGui::Text("Current Player Number: %d", game->getCurrentPlayer()->playerNumber());
+                    if (Chess* chess = dynamic_cast<Chess*>(game)) {
+                        for (int player = 0; player < 2; player++) {
+                            int seconds = std::max(0, chess->clockMs(player)) / 1000;
+                            ImGui::Text("%s clock: %d:%02d", player == 0 ? "White" : "Black", seconds / 60, seconds % 60);
+                        }
+                    }
                     std::string stateString = game->stateString();
                     int stride = game->_gameOptions.rowX;
                     int height = game->_gameOptions.rowY;
@@ -79,15 +95,110 @@ namespace ClassGame {
                 }
                 ImGui::End();
 
+                if (Chess* chess = dynamic_cast<Chess*>(game)) {
+                    ImGui::Begin("Analysis");
+                    static int lineCount = 3;
+                    bool analysing = chess->analysing();
+                    if (ImGui::SliderInt("Lines", &lineCount, 1, 8) && analysing) {
+                        chess->startAnalysis(lineCount);
+                    }
+                    if (ImGui::Checkbox("Analyse", &analysing)) {
+                        if (analysing) {
+                            chess->startAnalysis(lineCount);
+                        } else {
+                            chess->stopAnalysis();
+                        }
+                    }
+                    // scores are from the side to move's point of view, in pawns
+                    auto lines = chess->analysisLines();
+                    for (const auto& line : lines) {
+                        int mateIn = MATE_SCORE - std::abs(line.score);
+                        if (mateIn < MAX_PLY) {
+                            ImGui::Text("%2d  %s#%d  %s", line.depth, line.score < 0 ? "-" : "", (mateIn + 1) / 2, line.moves.c_str());
+                        } else {
+                            ImGui::Text("%2d  %+6.2f  %s", line.depth, line.score / 100.0f, line.moves.c_str());
+                        }
+                    }
+                    if (!lines.empty()) {
+                        ImGui::Text("%llu nodes", (unsigned long long)lines[0].nodes);
+                    }
+                    ImGui::End();
+
+                    ImGui::Begin("Review");
+                    static int reviewDepth = 8;
+                    ImGui::SliderInt("Depth", &reviewDepth, 2, 14);
+                    if (ImGui::Button("Review Game")) {
+                        chess->startReview(reviewDepth);
+                    }
+                    const GameReview& review = chess->review();
+                    if (review.positionCount() > 0) {
+                        // results arrive a position at a time from the review threads
+                        chess->updateReview();
+                        ImGui::Text("reviewed %d / %d positions", review.completedCount(), review.positionCount());
+                        auto positions = review.positions();
+                        for (size_t i = 1; i < game->_turns.size() && i < positions.size(); i++) {
+                            const Turn* turn = game->_turns[i];
+                            if (!positions[i].done) {
+                                ImGui::Text("%3d%s %-7s ...", (int)(i + 1) / 2, i % 2 ? ". " : "...", turn->_move.c_str());
+                                continue;
+                            }
+                            ImGui::Text("%3d%s %-7s %+6.2f  %s", (int)(i + 1) / 2, i % 2 ? ". " : "...", turn->_move.c_str(),
+                                        std::clamp(turn->_score, -9999, 9999) / 100.0f, turn->_comment.c_str());
+                        }
+                    }
+                    ImGui::End();
+                }
+
+                if (Othello* othello = dynamic_cast<Othello*>(game)) {
+                    ImGui::Begin("Endgame");
+                    int empties = othello->endgameEmpties();
+                    if (ImGui::SliderInt("Solve at empties", &empties, 0, 30)) {
+                        othello->setEndgameEmpties(empties);
+                    }
+                    const EndgameResult& solved = othello->lastEndgame();
+                    if (solved.nodes) {
+                        ImGui::Text("%s %+d", solved.complete ? "solved" : "out of time", solved.score);
+                        ImGui::Text("%llu nodes in %d ms, %.1fM nodes/s", (unsigned long long)solved.nodes, solved.timeMs, solved.nodesPerSecond / 1e6);
+                    }
+                    ImGui::End();
+                }
+
+                ImGui::Begin("Frame Pacing");
+                FramePacing& pacing = framePacer.pacing();
+                ImGui::Checkbox("Redraw only on changes", &pacing.onDemand);
+                ImGui::SliderInt("Waiting fps", &pacing.waitingFps, 1, 60);
+                ImGui::SliderInt("Idle fps", &pacing.idleFps, 1, 30);
+                ImGui::Text("%.0f frames/s, CPU %.1f%%", framePacer.framesPerSecond(), framePacer.cpuPercent());
+                ImGui::Text("idle CPU %.1f%%", framePacer.idleCpuPercent());
+                ImGui::End();
+
+                // the next frame comes right away while pieces move, soon while something
+                // is being worked out in the background, and otherwise on input
+                FrameActivity activity = TextureCache::shared().preloading() ? FrameWaiting : FrameIdle;
                 ImGui::Begin("GameWindow");
                 if (game) {
                     if (game->gameHasAI() && (game->getCurrentPlayer()->isAIPlayer() || game->_gameOptions.AIvsAI))
                     {
                         game->updateAI();
+                        activity = FrameWaiting;
                     }
                     game->drawFrame();
+                    if (Chess* chess = dynamic_cast<Chess*>(game)) {
+                        if (chess->analysing() || chess->review().running()) {
+                            activity = FrameWaiting;
+                        }
+                    }
+                    if (game->animating()) {
+                        activity = FrameAnimating;
+                    }
                 }
                 ImGui::End();
+                framePacer.endFrame(activity);
+        }
+
+        double FrameTimeout()
+        {
+            return framePacer.timeout();
         }
 
         //
@@ -4,4 +4,6 @@ namespace ClassGame {
     void GameStartUp();
     void RenderGame();
     void EndOfTurn();
+    // seconds the main loop may wait for input before drawing again, 0 to draw now
+    double FrameTimeout();
 }
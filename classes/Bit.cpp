@@ -1,10 +1,33 @@
 
 #include "Bit.h"
 #include "BitHolder.h"
+#include "RenderList.h"
 #include <cmath>
 
 Bit::~Bit()
 {
+	RenderList::shared().remove(this);
+}
+
+void Bit::setZ(int z)
+{
+	if (z != getLocalZOrder())
+	{
+		setLocalZOrder(z);
+		RenderList::shared().restack(this);
+	}
+}
+
+void Bit::setRestingZ(int z)
+{
+	if (_pickedUp)
+	{
+		_restingZ = z;
+	}
+	else
+	{
+		setZ(z);
+	}
 }
 
 BitHolder *Bit::getHolder()
@@ -49,10 +72,10 @@ void Bit::setPickedUp(bool up)
 			scale = 1.0f;
 		}
 		setScale(scale); // todo: animate this
-		setLocalZOrder(z);
+		_pickedUp = up;
+		setZ(z);
 		setOpacity(opacity);
 		setRotation(rotation);
-		_pickedUp = up;
 	}
 }
 
@@ -83,14 +106,63 @@ void Bit::moveTo(const ImVec2 &point)
 	ImVec2 delta = ImVec2(_destinationPosition.x - getPosition().x, _destinationPosition.y - getPosition().y);
 	_destinationStep = ImVec2(delta.x * 0.05f, delta.y * 0.05f);
 	_moving = true;
+	setRestingZ(kMovingZ);
+	RenderList::shared().animate(this);
+}
+
+// frames a flip takes, the texture changes halfway
+#define kFlipFrames 16
+
+void Bit::flipTo(Player *player, const char *textureFile)
+{
+	_owner = player;
+	if (_flipFrame == 0)
+	{
+		_flipPosition = getPosition();
+		_flipSize = getSize();
+	}
+	_flipTexture = textureFile;
+	_flipFrame = 1;
+	setRestingZ(kMovingZ);
+	RenderList::shared().animate(this);
 }
 
 void Bit::update()
 {
-	if (!_moving)
+	if (_flipFrame > 0)
+	{
+		// already in the texture cache, so no file is read
+		if (_flipFrame == kFlipFrames / 2)
+		{
+			LoadTextureFromFile(_flipTexture);
+		}
+		if (_flipFrame >= kFlipFrames)
+		{
+			setSize(_flipSize.x, _flipSize.y);
+			setPosition(_flipPosition);
+			_flipFrame = 0;
+		}
+		else
+		{
+			// squeeze towards the vertical centre line and back out
+			float width = _flipSize.x * std::fabs(1.0f - 2.0f * _flipFrame / kFlipFrames);
+			setSize(width, _flipSize.y);
+			setPosition(_flipPosition.x + (_flipSize.x - width) / 2, _flipPosition.y);
+			_flipFrame++;
+		}
+	}
+	if (_moving)
 	{
-		return;
+		updateMove();
 	}
+	if (!_moving && _flipFrame == 0)
+	{
+		setRestingZ(kPieceZ);
+	}
+}
+
+void Bit::updateMove()
+{
 	ImVec2 pos = getPosition();
 	ImVec2 delta = ImVec2(_destinationPosition.x - pos.x, _destinationPosition.y - pos.y);
 	if (std::fabs(delta.x) >= 0.1f || std::fabs(delta.y) > 0.1f)
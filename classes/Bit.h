@@ -6,17 +6,19 @@ class Player;
 class BitHolder;
 
 //
-// these aren't used yet but will be used for dragging pieces
+// the scale and opacity aren't used yet but will be used for dragging pieces
 //
 #define kPickedUpScale 1.2f
 #define kPickedUpOpacity 255
 
+// drawing order of the bits, see RenderList. a piece that is picked up stays above
+// the ones that are moving.
 enum bitz
 {
 	kBoardZ = 0,
 	kPieceZ = 3,
-	kPickupUpZ = 9920,
-	kMovingZ = 9930
+	kMovingZ = 9910,
+	kPickupUpZ = 9920
 };
 
 class Bit : public Sprite
@@ -29,6 +31,10 @@ public:
 		_gameTag = 0;
 		_entityType = EntityBit;
 		_moving = false;
+		_flipFrame = 0;
+		_restingZ = kPieceZ;
+		_restingTransform = 0.0f;
+		setLocalZOrder(kPieceZ);
 	};
 
 	~Bit();
@@ -53,8 +59,18 @@ public:
 	void update();
 	void setOpacity(float opacity){};
 	bool getMoving() { return _moving; };
+	// turn over in place to a new owner: the bit narrows to an edge, swaps to the
+	// image in textureFile and widens again. the owner changes straight away.
+	void flipTo(Player *player, const char *textureFile);
+	bool getFlipping() { return _flipFrame > 0; };
 
 private:
+	// Z changes go through these so the render list stays sorted
+	void setZ(int z);
+	// the Z for when the bit isn't picked up
+	void setRestingZ(int z);
+	void updateMove();
+
 	int _restingZ;
 	float _restingTransform;
 	bool _pickedUp;
@@ -63,4 +79,9 @@ private:
 	ImVec2 _destinationPosition;
 	ImVec2 _destinationStep;
 	bool _moving;
+	// flip animation, frames so far (0 when not flipping) and the resting geometry
+	int _flipFrame;
+	const char *_flipTexture;
+	ImVec2 _flipPosition;
+	ImVec2 _flipSize;
 };
@@ -1,5 +1,6 @@
 #include "BitHolder.h"
 #include "Bit.h"
+#include "RenderList.h"
 
 BitHolder::~BitHolder()
 {
@@ -35,6 +36,7 @@ void BitHolder::setBit(Bit *abit)
 		if (_bit)
 		{
 			_bit->setParent(this);
+			RenderList::shared().add(_bit);
 		}
 	}
 }
@@ -4,6 +4,7 @@
 #include <intrin.h>
 #endif
 #include <iostream>
+#include <cstdint>
 
 enum ChessPiece
 {
@@ -16,6 +17,26 @@ enum ChessPiece
     King
 };
 
+enum AllBitBoards {
+    WHITE_PAWNS,
+    WHITE_KNIGHTS,
+    WHITE_BISHOPS,
+    WHITE_ROOKS,
+    WHITE_QUEENS,
+    WHITE_KING,
+    WHITE_ALL_PIECES,
+    BLACK_PAWNS,
+    BLACK_KNIGHTS,
+    BLACK_BISHOPS,
+    BLACK_ROOKS,
+    BLACK_QUEENS,
+    BLACK_KING,
+    BLACK_ALL_PIECES,
+    OCCUPANCY,
+    EMPTY_SQUARES,
+    e_numBitboards
+};
+
 class BitboardElement {
   public:
     // Constructors
@@ -103,19 +124,33 @@ private:
 
 };
 
+// extra information the engine needs to make and unmake a move
+enum BitMoveFlags
+{
+    MoveQuiet = 0,
+    MoveCapture = 1,
+    MoveEnPassant = 2,
+    MoveCastle = 4,
+    MoveDoublePush = 8
+};
+
 struct BitMove {
     uint8_t from;
     uint8_t to;
     uint8_t piece;
+    uint8_t flags;
+    uint8_t promotion;
     
-    BitMove(int from, int to, ChessPiece piece)
-        : from(from), to(to), piece(piece) { }
+    BitMove(int from, int to, ChessPiece piece, int flags = MoveQuiet, ChessPiece promotion = NoPiece)
+        : from(from), to(to), piece(piece), flags(flags), promotion(promotion) { }
         
-    BitMove() : from(0), to(0), piece(NoPiece) { }
+    BitMove() : from(0), to(0), piece(NoPiece), flags(MoveQuiet), promotion(NoPiece) { }
     
     bool operator==(const BitMove& other) const {
         return from == other.from && 
                to == other.to && 
-               piece == other.piece;
+               piece == other.piece &&
+               promotion == other.promotion;
     }
-};
\ No newline at end of file
+    bool isNull() const { return piece == NoPiece; }
+};
@@ -1,4 +1,5 @@
 #include "Checkers.h"
+#include "MCTS.h"
 
 Checkers::Checkers() : Game() {
     _grid = new Grid(8, 8);
@@ -9,6 +10,7 @@ Checkers::Checkers() : Game() {
 }
 
 Checkers::~Checkers() {
+    stopAI();
     delete _grid;
 }
 
@@ -38,6 +40,10 @@ void Checkers::setUpBoard() {
         }
     });
 
+    if (gameHasAI()) {
+        setAIPlayer(AI_PLAYER);
+    }
+
     startGame();
 }
 
@@ -250,6 +256,7 @@ bool Checkers::checkForDraw() {
 }
 
 void Checkers::stopGame() {
+    stopAI();
     _grid->forEachSquare([](ChessSquare* square, int x, int y) {
         square->destroyBit();
     });
@@ -290,5 +297,53 @@ void Checkers::setStateString(const std::string &s) {
     });
 }
 
-void Checkers::updateAI() {}
+void Checkers::updateAI() {
+    if (!_aiTask) {
+        // search a copy of the position while the UI keeps drawing, the move is played on a later frame
+        CheckersState state;
+        state.toMove = getCurrentPlayer()->playerNumber();
+        _grid->forEachEnabledSquare([&](ChessSquare* square, int x, int y) {
+            if (square->bit()) {
+                state.board[y * 8 + x] = (uint8_t)square->bit()->gameTag();
+            }
+            if (_mustContinueJumping && square == _jumpingPiece) {
+                state.continuing = y * 8 + x;
+            }
+        });
+
+        MCTSLimits limits;
+        limits.threads = std::max(1u, std::thread::hardware_concurrency());
+        limits.timeMs = 1000;
+        // without a capture for a long time a game is as good as drawn
+        limits.maxPlayoutMoves = 200;
+        _aiDone = false;
+        _aiTask = std::make_unique<TaskGroup>(ThreadPool::shared(), TaskInteractive);
+        limits.cancel = _aiTask->token().flag();
+        _aiTask->run([this, state, limits]() {
+            MCTS<CheckersState> mcts;
+            MCTSResult<CheckersState::Move> result = mcts.search(state, limits);
+            _aiFound = result.found;
+            _aiMove = result.bestMove;
+            _aiDone = true;
+        });
+        return;
+    }
+    if (!_aiDone) return;
+
+    _aiTask.reset();
+    if (!_aiFound) {
+        return;
+    }
+    ChessSquare* src = _grid->getSquare(_aiMove.from % 8, _aiMove.from / 8);
+    ChessSquare* dst = _grid->getSquare(_aiMove.to % 8, _aiMove.to / 8);
+    dst->dropBitAtPoint(src->bit(), ImVec2(0, 0));
+    src->setBit(nullptr);
+    bitMovedFromTo(*dst->bit(), *src, *dst);
+}
 
+void Checkers::stopAI() {
+    if (_aiTask) {
+        _aiTask->cancel();
+        _aiTask.reset();
+    }
+}
@@ -1,5 +1,9 @@
 #pragma once
 #include "Game.h"
+#include "CheckersState.h"
+#include "ThreadPool.h"
+#include <memory>
+#include <atomic>
 
 // NOTE: If Square class needs modifications to support colored squares for checkerboard pattern,
 // add a method like setColor(ImVec4 color) to Square class
@@ -25,7 +29,7 @@ public:
 
     // AI methods
     void        updateAI() override;
-    bool        gameHasAI() override { return false; } // Set to true when AI is implemented
+    bool        gameHasAI() override { return true; }
     Grid* getGrid() override { return _grid; }
 
 private:
@@ -41,6 +45,7 @@ private:
     static const int YELLOW_PLAYER = 1;
 
     // Helper methods
+    void        stopAI();
     Bit*        createPiece(int pieceType);
     int         getPieceType(const Bit& bit) const;
     bool        isKing(const Bit& bit) const;
@@ -61,4 +66,10 @@ private:
     BitHolder*  _jumpingPiece;
     int         _redPieces;
     int         _yellowPieces;
+
+    // AI search, run as an interactive task on the shared thread pool
+    std::unique_ptr<TaskGroup>  _aiTask;
+    std::atomic<bool>           _aiDone{false};
+    bool                        _aiFound = false;
+    CheckersState::Move         _aiMove;
 };
\ No newline at end of file
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+
+//
+// compact checkers position for the MCTS AI, following the rules of the Checkers class:
+// captures are compulsory, and a piece that can jump again after a capture keeps
+// moving before the turn passes. pieces use the Checkers constants, red (player 0)
+// moves down the Grid and promotes on row 7, yellow (player 1) moves up to row 0.
+//
+struct CheckersState
+{
+    struct Move
+    {
+        uint8_t from = 0;
+        uint8_t to = 0;
+    };
+
+    enum Piece : uint8_t { Empty, RedPiece, RedKing, YellowPiece, YellowKing };
+
+    uint8_t board[64] = {};         // y * 8 + x
+    int toMove = 0;
+    int continuing = -1;            // square of a piece in the middle of a multi-jump
+
+    static int owner(uint8_t piece) { return piece == Empty ? -1 : piece <= RedKing ? 0 : 1; }
+    static bool isKing(uint8_t piece) { return piece == RedKing || piece == YellowKing; }
+
+    int sideToMove() const { return toMove; }
+
+    // the player who can't move loses
+    int result(int player) const { return player == toMove ? 0 : 2; }
+
+    void generate(std::vector<Move>& moves) const
+    {
+        if(continuing >= 0) {
+            addMoves(continuing, &moves, true);
+            return;
+        }
+        for(int square = 0; square < 64; square++) {
+            if(owner(board[square]) == toMove) {
+                addMoves(square, &moves, true);
+            }
+        }
+        if(!moves.empty()) {
+            return;
+        }
+        for(int square = 0; square < 64; square++) {
+            if(owner(board[square]) == toMove) {
+                addMoves(square, &moves, false);
+            }
+        }
+    }
+
+    void make(const Move& move)
+    {
+        uint8_t piece = board[move.from];
+        board[move.from] = Empty;
+        bool jump = std::abs(move.to % 8 - move.from % 8) == 2;
+        if(jump) {
+            board[(move.from + move.to) / 2] = Empty;
+        }
+        int row = move.to / 8;
+        if(piece == RedPiece && row == 7) piece = RedKing;
+        if(piece == YellowPiece && row == 0) piece = YellowKing;
+        board[move.to] = piece;
+
+        if(jump && addMoves(move.to, nullptr, true)) {
+            continuing = move.to;
+        } else {
+            continuing = -1;
+            toMove ^= 1;
+        }
+    }
+
+private:
+    // the jumps or the plain moves of the piece on square, only counted when moves is null
+    int addMoves(int square, std::vector<Move>* moves, bool jumps) const
+    {
+        int count = 0;
+        uint8_t piece = board[square];
+        int x = square % 8;
+        int y = square / 8;
+        int player = owner(piece);
+        for(int dy = -1; dy <= 1; dy += 2) {
+            // men only move forwards: down the board for red, up for yellow
+            if(!isKing(piece) && dy != (player == 0 ? 1 : -1)) {
+                continue;
+            }
+            for(int dx = -1; dx <= 1; dx += 2) {
+                int step = jumps ? 2 : 1;
+                int tx = x + dx * step;
+                int ty = y + dy * step;
+                if(tx < 0 || tx > 7 || ty < 0 || ty > 7 || board[ty * 8 + tx] != Empty) {
+                    continue;
+                }
+                if(jumps) {
+                    int middle = owner(board[(y + dy) * 8 + x + dx]);
+                    if(middle < 0 || middle == player) {
+                        continue;
+                    }
+                }
+                count++;
+                if(moves) {
+                    Move move;
+                    move.from = (uint8_t)square;
+                    move.to = (uint8_t)(ty * 8 + tx);
+                    moves->push_back(move);
+                }
+            }
+        }
+        return count;
+    }
+};
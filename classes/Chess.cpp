@@ -1,55 +1,44 @@
 #include "Chess.h"
 #include "../Application.h"
-#include "./MagicBitboards.h"
 #include <limits>
 #include <cmath>
-#include <map>
+#include <cctype>
+#include <algorithm>
 
 #define WHITE 1
 #define BLACK -1
 
+// game clock: five minutes each plus two seconds a move
+constexpr int kClockMs = 5 * 60 * 1000;
+constexpr int kIncrementMs = 2000;
+
 Chess::Chess()
 {
     _grid = new Grid(8, 8);
-
-    initMagicBitboards();
-    for(int i = 0; i < 64; i++) {
-        knightBoards[i] = generateKnightMoveBitboard(i);
-        kingBoards[i] = generateKingMoveBitboard(i);
-    }
-    for(int i = 0; i < 128; i++) {bitboardLookup[i] = 0;}
-
-    bitboardLookup['P'] = WHITE_PAWNS;
-    bitboardLookup['N'] = WHITE_KNIGHTS;
-    bitboardLookup['B'] = WHITE_BISHOPS;
-    bitboardLookup['R'] = WHITE_ROOKS;
-    bitboardLookup['Q'] = WHITE_QUEENS;
-    bitboardLookup['K'] = WHITE_KING;
-    bitboardLookup['p'] = BLACK_PAWNS;
-    bitboardLookup['n'] = BLACK_KNIGHTS;
-    bitboardLookup['b'] = BLACK_BISHOPS;
-    bitboardLookup['r'] = BLACK_ROOKS;
-    bitboardLookup['q'] = BLACK_QUEENS;
-    bitboardLookup['k'] = BLACK_KING;
-    bitboardLookup['0'] = EMPTY_SQUARES;
-
+    _gameStatus = GameOngoing;
+    _clockMs[0] = _clockMs[1] = kClockMs;
+    _flaggedPlayer = -1;
+    _highlighted = 0;
+    for(auto& destinations : _destinations) {
+        destinations = 0;
+    }
+    _analysisLineCount = 0;
+    _reviewGeneration = -1;
+    _aiDone = false;
 }
 
 Chess::~Chess()
 {
+    _review.cancel();
+    joinAnalysis();
+    stopAI();
     delete _grid;
 }
 
-char Chess::pieceNotation(int x, int y) const
+// the sprite game tag for an engine piece character: piece type, plus 128 for black
+static int gameTagFor(char piece)
 {
-    const char *wpieces = { "0PNBRQK" };
-    const char *bpieces = { "0pnbrqk" };
-    Bit *bit = _grid->getSquare(x, y)->bit();
-    char notation = '0';
-    if (bit) {
-        notation = bit->gameTag() < 128 ? wpieces[bit->gameTag()] : bpieces[bit->gameTag()-128];
-    }
-    return notation;
+    return ChessEngine::pieceType(piece) + (std::islower((unsigned char)piece) ? 128 : 0);
 }
 
 Bit* Chess::PieceForPlayer(const int playerNumber, ChessPiece piece)
@@ -74,10 +63,17 @@ void Chess::setUpBoard()
     _gameOptions.rowY = 8;
 
     _grid->initializeChessSquares(pieceSize, "boardsquare.png");
-    FENtoBoard("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR");
+    _engine.setFEN(ChessEngine::startFEN());
+    for(int square = 0; square < 64; square++) {
+        syncSquare(square);
+    }
 
     _currentPlayer = WHITE;
-    _moves = generateAllMoves(stateString(), _currentPlayer);
+    _highlighted = 0;
+    refreshMoves();
+    _clockMs[0] = _clockMs[1] = kClockMs;
+    _flaggedPlayer = -1;
+    _turnStart = std::chrono::steady_clock::now();
 
     if(gameHasAI()) {
         setAIPlayer(AI_PLAYER);
@@ -87,15 +83,30 @@ void Chess::setUpBoard()
 }
 void Chess::endTurn()
 {
-    _grid->forEachSquare([&](ChessSquare* square, int x, int y) {
-        square->setHighlighted(false);
+    // only the destinations of the last piece picked up can be lit
+    BitboardElement(_highlighted).forEachBit([&](int square) {
+        _grid->getSquareByIndex(square)->setHighlighted(false);
     });
+    _highlighted = 0;
+    // charge the player who just moved for the turn, they only get the increment if they made it in time
+    int mover = _currentPlayer == WHITE ? 0 : 1;
+    _clockMs[mover] = clockMs(mover);
+    if(_clockMs[mover] <= 0) {
+        _flaggedPlayer = mover;
+    } else {
+        _clockMs[mover] += kIncrementMs;
+    }
+    _turnStart = std::chrono::steady_clock::now();
+
     _gameOptions.currentTurnNo++;
     _currentPlayer = -_currentPlayer;
-    _moves = generateAllMoves(stateString(), _currentPlayer);
-	std::string startState = stateString();
+    refreshMoves();
+    if(analysing()) {
+        launchAnalysis();
+    }
 	Turn *turn = new Turn;
 	turn->_boardState = stateString();
+	turn->_move = _lastMove;
 	turn->_date = (int)_gameOptions.currentTurnNo;
 	turn->_score = _gameOptions.score;
 	turn->_gameNumber = _gameOptions.gameNumber;
@@ -103,47 +114,65 @@ void Chess::endTurn()
     ClassGame::EndOfTurn();
 }
 
-void Chess::FENtoBoard(const std::string& fen) {
-    const std::unordered_map <char, int> pieceCodes = {
-        {'P', 1}, {'N', 2}, {'B', 3},
-        {'R', 4}, {'Q', 5}, {'K', 6}
-    };
-    // convert a FEN string to a board
-    // FEN is a space delimited string with 6 fields
-    // 1: piece placement (from white's perspective)
-    // NOT PART OF THIS ASSIGNMENT BUT OTHER THINGS THAT CAN BE IN A FEN STRING
-    // ARE BELOW
-    // 2: active color (W or B)
-    // 3: castling availability (KQkq or -)
-    // 4: en passant target square (in algebraic notation, or -)
-    // 5: halfmove clock (number of halfmoves since the last capture or pawn advance)
-    int x = 0;
-    int y = 0;
-    for(int i = 0; i < fen.length(); i++) {
-        const char current = fen[i];
-        if(current == 47) {x = 0; y++;} //break
-        else if(current >= 49 && current <= 57) //empty numbers
-            x += current - 48;
-        else if(current >= 66 && current <= 82) { //lowercase letters
-            ChessPiece newPiece = ChessPiece(pieceCodes.at(current));
-            Bit* piece = PieceForPlayer(1, newPiece);
-            ChessSquare* square = _grid->getSquare(x, y);
-            piece->setPosition(square->getPosition());
-            square->setBit(piece);
-            piece->setGameTag(newPiece + 128);
-            x++;
-        } else if (current >= 98 && current <= 122) { //uppercase numbers
-            char newCode = fen[i] - 32; //converting to our standard number
-            ChessPiece newPiece = ChessPiece(pieceCodes.at(newCode));
-            Bit* piece = PieceForPlayer(0, newPiece);
-            ChessSquare* square = _grid->getSquare(x, y);
-            piece->setPosition(square->getPosition());
-            square->setBit(piece);
-            piece->setGameTag(newPiece);
-            x++;
+//
+// the engine holds the position, the sprites only mirror it. after a move only the
+// squares it touched are brought back into line with the engine.
+//
+void Chess::syncSquare(int squareIndex)
+{
+    ChessSquare* square = _grid->getSquareByIndex(squareIndex);
+    char piece = _engine.pieceAt(squareIndex);
+    Bit* bit = square->bit();
+    if(piece == '0') {
+        if(bit) {
+            square->destroyBit();
         }
-        if(x == 8 && y == 7)
-            break;
+        return;
+    }
+    int tag = gameTagFor(piece);
+    if(bit && bit->gameTag() == tag) {
+        return;
+    }
+    // a new piece, or a pawn that has just promoted
+    Bit* sprite = PieceForPlayer(tag < 128 ? 0 : 1, ChessEngine::pieceType(piece));
+    sprite->setPosition(square->getPosition());
+    sprite->setGameTag(tag);
+    square->setBit(sprite);
+}
+
+void Chess::applyMove(const BitMove& move)
+{
+    _lastMove = _engine.moveToSAN(move);
+    _engine.makeMove(move);
+    if(move.flags & MoveCastle) {
+        // the king's sprite has already been moved, the rook follows it
+        bool kingside = move.to > move.from;
+        ChessSquare* rookSrc = _grid->getSquareByIndex(kingside ? move.from + 3 : move.from - 4);
+        ChessSquare* rookDst = _grid->getSquareByIndex(kingside ? move.from + 1 : move.from - 1);
+        if(Bit* rook = rookSrc->bit()) {
+            rookDst->dropBitAtPoint(rook, rookDst->getPosition());
+            rookSrc->setBit(nullptr);
+        }
+        syncSquare(rookSrc->getSquareIndex());
+        syncSquare(rookDst->getSquareIndex());
+    }
+    if(move.flags & MoveEnPassant) {
+        // the captured pawn is beside the moving one, on the rank it started from
+        syncSquare((move.from & ~7) | (move.to & 7));
+    }
+    syncSquare(move.from);
+    syncSquare(move.to);
+}
+
+void Chess::refreshMoves()
+{
+    _moves = _engine.generateAllMoves();
+    _gameStatus = _engine.gameStatus(_moves);
+    for(auto& destinations : _destinations) {
+        destinations = 0;
+    }
+    for(const auto& move : _moves) {
+        _destinations[move.from] |= 1ULL << move.to;
     }
 }
 
@@ -154,22 +183,21 @@ bool Chess::actionForEmptyHolder(BitHolder &holder)
 
 bool Chess::canBitMoveFrom(Bit &bit, BitHolder &src)
 {
+    if (_flaggedPlayer >= 0) {
+        return false;
+    }
     // need to implement friendly/unfriendly in bit so for now this hack
     int currentPlayer = getCurrentPlayer()->playerNumber() * 128;
     int pieceColor = bit.gameTag() & 128;
-    bool spacesAvailable = false;
-    if (pieceColor == currentPlayer) {
-        ChessSquare* square = (ChessSquare *)&src;
-        int squareIndex = square->getSquareIndex();
-        for(auto move : _moves) {
-            if(move.from == squareIndex) {
-                spacesAvailable = true;
-                auto dest = _grid->getSquareByIndex(move.to);
-                dest->setHighlighted(true);
-            }
-        }
+    if (pieceColor != currentPlayer) {
+        return false;
     }
-    return spacesAvailable;
+    uint64_t destinations = _destinations[((ChessSquare *)&src)->getSquareIndex()];
+    BitboardElement(destinations).forEachBit([&](int square) {
+        _grid->getSquareByIndex(square)->setHighlighted(true);
+    });
+    _highlighted |= destinations;
+    return destinations != 0;
 }
 
 bool Chess::canBitMoveFromTo(Bit &bit, BitHolder &src, BitHolder &dst)
@@ -179,18 +207,15 @@ bool Chess::canBitMoveFromTo(Bit &bit, BitHolder &src, BitHolder &dst)
 
     if (!srcSquare || !dstSquare) return false;
 
-    int dstIndex = dstSquare->getSquareIndex();
-    int srcIndex = srcSquare->getSquareIndex();
-    for(auto move : _moves) {
-        if(move.to == dstIndex && move.from == srcIndex) {
-            return true;
-        }
-    }
-    return false;
+    return (_destinations[srcSquare->getSquareIndex()] >> dstSquare->getSquareIndex()) & 1;
 }
 
 void Chess::stopGame()
 {
+    // background work first, so the AI's task isn't left queued behind it while we wait for it
+    _review.cancel();
+    stopAnalysis();
+    stopAI();
     _grid->forEachSquare([](ChessSquare* square, int x, int y) {
         square->destroyBit();
     });
@@ -209,14 +234,31 @@ Player* Chess::ownerAt(int x, int y) const
     return square->bit()->getOwner();
 }
 
+int Chess::clockMs(int playerNumber) const
+{
+    int current = _currentPlayer == WHITE ? 0 : 1;
+    if(playerNumber != current || _flaggedPlayer >= 0) {
+        return _clockMs[playerNumber];
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _turnStart).count();
+    return _clockMs[playerNumber] - (int)elapsed;
+}
+
 Player* Chess::checkForWinner()
 {
+    if(_flaggedPlayer >= 0) {
+        return getPlayerAt(1 - _flaggedPlayer);
+    }
+    // the side to move has been mated, so the winner is the player who just moved
+    if(_gameStatus == GameCheckmate) {
+        return getPlayerAt(_currentPlayer == WHITE ? 1 : 0);
+    }
     return nullptr;
 }
 
 bool Chess::checkForDraw()
 {
-    return false;
+    return _gameStatus != GameOngoing && _gameStatus != GameCheckmate;
 }
 
 std::string Chess::initialStateString()
@@ -226,269 +268,210 @@ std::string Chess::initialStateString()
 
 std::string Chess::stateString()
 {
-    std::string s;
-    s.reserve(64);
-    _grid->forEachSquare([&](ChessSquare* square, int x, int y) {
-            s += pieceNotation( x, y );
-        }
-    );
-    return s;}
+    return _engine.stateString();
+}
 
 void Chess::setStateString(const std::string &s)
 {
-    _grid->forEachSquare([&](ChessSquare* square, int x, int y) {
-        int index = y * 8 + x;
-        char playerNumber = s[index] - '0';
-        if (playerNumber) {
-            square->setBit(PieceForPlayer(playerNumber - 1, Pawn));
-        } else {
-            square->setBit(nullptr);
-        }
-    });
+    _engine.setStateString(s, _currentPlayer);
+    for(int square = 0; square < 64; square++) {
+        syncSquare(square);
+    }
+    refreshMoves();
 }
 
-std::vector<BitMove> Chess::generateAllMoves(const std::string& state, int playerColor)
+void Chess::bitMovedFromTo(Bit &bit, BitHolder &src, BitHolder &dst)
 {
-    //std::cout <<"I think I am " << (playerColor == 1 ? "White!" : "Black!") << std::endl;
-    // for(auto move : moves) {
-    //     delete move;
-    // }
-    std::vector<BitMove> moves;
-    moves.reserve(32);
-
-    for(int i = 0; i < e_numBitboards; i++) {
-        _bitboards[i] = 0;
-    }
-
-    for(int i = 0; i < 64; i++) {
-        int bitIndex = bitboardLookup[state[i]];
-        _bitboards[bitIndex] |= 1ULL << i;
+    int srcIndex = ((ChessSquare *)&src)->getSquareIndex();
+    int dstIndex = ((ChessSquare *)&dst)->getSquareIndex();
+    // the board has no promotion picker yet, so pawns reaching the last rank become queens
+    for(const auto& move : _moves) {
+        if(move.from == srcIndex && move.to == dstIndex && (move.promotion == NoPiece || move.promotion == Queen)) {
+            applyMove(move);
+            break;
+        }
     }
-
-    _bitboards[WHITE_ALL_PIECES] = _bitboards[WHITE_PAWNS].getData() | _bitboards[WHITE_BISHOPS].getData() | _bitboards[WHITE_ROOKS].getData() | _bitboards[WHITE_KNIGHTS].getData() | _bitboards[WHITE_QUEENS].getData() |  _bitboards[WHITE_KING].getData(); 
-    _bitboards[BLACK_ALL_PIECES] = _bitboards[BLACK_PAWNS].getData() | _bitboards[BLACK_BISHOPS].getData() | _bitboards[BLACK_ROOKS].getData() | _bitboards[BLACK_KNIGHTS].getData() | _bitboards[BLACK_QUEENS].getData() |  _bitboards[BLACK_KING].getData(); 
-    _bitboards[OCCUPANCY] = _bitboards[WHITE_ALL_PIECES].getData() | _bitboards[BLACK_ALL_PIECES].getData();
-
-    int bitIndex = playerColor == WHITE ? WHITE_PAWNS : BLACK_PAWNS;
-    int oppBitIndex = playerColor == WHITE ? BLACK_PAWNS : WHITE_PAWNS;
-
-    generateKnightMoves(moves, _bitboards[WHITE_KNIGHTS + bitIndex], ~_bitboards[WHITE_ALL_PIECES + bitIndex].getData());
-    generateKingMoves(moves, _bitboards[WHITE_KING + bitIndex], ~_bitboards[WHITE_ALL_PIECES + bitIndex].getData());
-    generateBishopMoves(moves, _bitboards[WHITE_BISHOPS + bitIndex], _bitboards[OCCUPANCY].getData(), _bitboards[WHITE_ALL_PIECES + bitIndex].getData());
-    generateRookMoves(moves, _bitboards[WHITE_ROOKS + bitIndex], _bitboards[OCCUPANCY].getData(), _bitboards[WHITE_ALL_PIECES + bitIndex].getData());
-    generateQueenMoves(moves, _bitboards[WHITE_QUEENS + bitIndex], _bitboards[OCCUPANCY].getData(), _bitboards[WHITE_ALL_PIECES + bitIndex].getData());
-    generatePawnMoves(moves, _bitboards[WHITE_PAWNS + bitIndex], ~_bitboards[OCCUPANCY].getData(), _bitboards[WHITE_ALL_PIECES + oppBitIndex].getData(), playerColor);
-
-    return moves;
+    Game::bitMovedFromTo(*dst.bit(), src, dst);
 }
-void Chess::generateKnightMoves(std::vector<BitMove>& moves, BitboardElement knightBoard, uint64_t emptySquares) {
-    knightBoard.forEachBit([&](int fromSquare) {
-        BitboardElement moveBitboard = BitboardElement(knightBoards[fromSquare].getData() & emptySquares);
-        // Efficiently iterate through only the set bits
-        moveBitboard.forEachBit([&](int toSquare) {
-           moves.emplace_back(fromSquare, toSquare, Knight);
-        });
-    });
-}
-void Chess::generateBishopMoves(std::vector<BitMove>& moves, BitboardElement bishopBoard, uint64_t occupancy, uint64_t friendlies) {
-    bishopBoard.forEachBit([&](int fromSquare) {
-        BitboardElement moveBitboard = BitboardElement(getBishopAttacks(fromSquare, occupancy) & ~friendlies);
-        // Efficiently iterate through only the set bits
-        moveBitboard.forEachBit([&](int toSquare) {
-           moves.emplace_back(fromSquare, toSquare, Bishop);
-        });
-    });
+
+//
+// analysis
+//
+void Chess::startAnalysis(int lines)
+{
+    _analysisLineCount = std::max(1, lines);
+    launchAnalysis();
 }
-void Chess::generateRookMoves(std::vector<BitMove>& moves, BitboardElement rookBoard, uint64_t occupancy, uint64_t friendlies) {
-    rookBoard.forEachBit([&](int fromSquare) {
-        BitboardElement moveBitboard = BitboardElement(getRookAttacks(fromSquare, occupancy) & ~friendlies);
-        // Efficiently iterate through only the set bits
-        moveBitboard.forEachBit([&](int toSquare) {
-           moves.emplace_back(fromSquare, toSquare, Rook);
-        });
-    });
+
+void Chess::stopAnalysis()
+{
+    _analysisLineCount = 0;
+    joinAnalysis();
+    std::lock_guard<std::mutex> lock(_analysisMutex);
+    _analysisLines.clear();
 }
-void Chess::generateQueenMoves(std::vector<BitMove>& moves, BitboardElement queenBoard, uint64_t occupancy, uint64_t friendlies) {
-    queenBoard.forEachBit([&](int fromSquare) {
-        BitboardElement moveBitboard = BitboardElement(getQueenAttacks(fromSquare, occupancy) & ~friendlies);
-        // Efficiently iterate through only the set bits
-        moveBitboard.forEachBit([&](int toSquare) {
-           moves.emplace_back(fromSquare, toSquare, Queen);
-        });
-    });
+
+void Chess::joinAnalysis()
+{
+    if(_analysisTask) {
+        _analysisTask->cancel();
+        _analysisEngine->stop();
+        _analysisTask.reset();
+    }
 }
-void Chess::generateKingMoves(std::vector<BitMove>& moves, BitboardElement kingBoard, uint64_t emptySquares) {
-    kingBoard.forEachBit([&](int fromSquare) {
-        BitboardElement moveBitboard = BitboardElement(kingBoards[fromSquare].getData() & emptySquares);
-        // Efficiently iterate through only the set bits
-        moveBitboard.forEachBit([&](int toSquare) {
-           moves.emplace_back(fromSquare, toSquare, King);
+
+void Chess::launchAnalysis()
+{
+    joinAnalysis();
+    {
+        std::lock_guard<std::mutex> lock(_analysisMutex);
+        _analysisLines.clear();
+    }
+    if(_gameStatus != GameOngoing) {
+        return;
+    }
+    if(!_analysisEngine) {
+        _analysisEngine = std::make_unique<ChessEngine>();
+    }
+    // with the moves played, so the analysis sees repetitions the same as the game
+    _analysisEngine->copyPosition(_engine);
+    _analysisTask = std::make_unique<TaskGroup>(ThreadPool::shared(), TaskBackground);
+    SearchLimits limits;
+    limits.multiPV = _analysisLineCount;
+    limits.cancel = _analysisTask->token().flag();
+
+    ChessEngine* engine = _analysisEngine.get();
+    _analysisTask->run([this, engine, limits]() {
+        engine->search(limits, [&](const SearchResult& iteration) {
+            // turn the lines into text here, on the worker, while it owns the position
+            std::vector<AnalysisLine> lines;
+            auto addLine = [&](int score, const std::vector<BitMove>& pv) {
+                AnalysisLine line;
+                line.depth = iteration.depth;
+                line.score = score;
+                line.nodes = iteration.nodes;
+                for(const auto& move : pv) {
+                    line.moves += engine->moveToSAN(move) + " ";
+                    engine->makeMove(move);
+                }
+                for(size_t i = 0; i < pv.size(); i++) {
+                    engine->unmakeMove();
+                }
+                lines.push_back(line);
+            };
+            if(iteration.lines.empty()) {
+                addLine(iteration.score, iteration.pv);
+            }
+            for(const auto& line : iteration.lines) {
+                addLine(line.score, line.pv);
+            }
+            std::lock_guard<std::mutex> lock(_analysisMutex);
+            _analysisLines = std::move(lines);
         });
     });
 }
-void Chess::generatePawnMoves(std::vector<BitMove>& moves, BitboardElement pawnBoard, uint64_t emptySquares, uint64_t enemySquares, int playerColor) {
-    constexpr uint64_t NotAFile(0xFEFEFEFEFEFEFEFEULL);
-    constexpr uint64_t NotHFile(0x7F7F7F7F7F7F7F7FULL);
-    constexpr uint64_t Rank3(0x0000000000FF0000ULL);
-    constexpr uint64_t Rank6(0x0000FF0000000000ULL);
-
-    BitboardElement singleMoves = (playerColor == WHITE) ? (pawnBoard.getData() << 8) & emptySquares : (pawnBoard.getData() >> 8) & emptySquares;
-
-    BitboardElement doubleMoves = (playerColor == WHITE) ? ((singleMoves.getData() & Rank3) << 8) & emptySquares : ((singleMoves.getData() & Rank6) >> 8) & emptySquares;
-
-    BitboardElement capturesLeft = (playerColor == WHITE) ? ((pawnBoard.getData() & NotAFile) << 7) & enemySquares : ((pawnBoard.getData() & NotAFile) >> 9) & enemySquares;
-    BitboardElement capturesRight = (playerColor == WHITE) ? ((pawnBoard.getData() & NotHFile) << 9) & enemySquares : ((pawnBoard.getData() & NotHFile) >> 7) & enemySquares;
-    
-    int shiftForward = (playerColor == WHITE) ? 8: -8;
-    int doubleShift = (playerColor == WHITE) ? 16: -16;
-    int captureLeftShift = (playerColor == WHITE) ? 7: -9;
-    int captureRightShift = (playerColor == WHITE) ? 9: -7;
-
-    addPawnBitboardMovesToList(moves, singleMoves, shiftForward);
-    addPawnBitboardMovesToList(moves, doubleMoves, doubleShift);
-    addPawnBitboardMovesToList(moves, capturesLeft, captureLeftShift);
-    addPawnBitboardMovesToList(moves, capturesRight, captureRightShift);
-}
-//index is 0-63
-BitboardElement Chess::generateKnightMoveBitboard(int index) {
-    BitboardElement board = 0ULL;
-    int rank = index / 8;
-    int file = index % 8;
-
-    std::pair<int,int> knightOffsets[] = {
-        {2, 1}, {2, -1}, {-2, 1}, {-2, -1},
-        {1, 2}, {1, -2}, {-1, 2}, {-1, -2}
-    };
-
-    constexpr uint64_t oneBit = 1;
-    for(auto [dr, df] : knightOffsets) {
-        int r = rank + dr, f = file + df;
-        if(r >= 0 && r < 8 && f >= 0 && f < 8) {
-            board |= oneBit << (r * 8 + f);
-        }
-    }
-    return board;
+
+std::vector<AnalysisLine> Chess::analysisLines()
+{
+    std::lock_guard<std::mutex> lock(_analysisMutex);
+    return _analysisLines;
 }
-BitboardElement Chess::generateKingMoveBitboard(int index) {
-    BitboardElement board = 0ULL;
-    int rank = index / 8;
-    int file = index % 8;
-
-    std::pair<int,int> kingOffsets[] = {
-        {1, 1}, {-1, -1}, {-1, 1}, {1, -1},
-        {0, 1}, {0, -1}, {-1, 0}, {1, 0}
-    };
-
-    constexpr uint64_t oneBit = 1;
-    for(auto [dr, df] : kingOffsets) {
-        int r = rank + dr, f = file + df;
-        if(r >= 0 && r < 8 && f >= 0 && f < 8) {
-            board |= oneBit << (r * 8 + f);
-        }
+
+//
+// game review
+//
+void Chess::startReview(int depth)
+{
+    std::vector<std::string> moves;
+    for(size_t i = 1; i < _turns.size(); i++) {
+        moves.push_back(_turns[i]->_move);
     }
-    return board;
-}
-void Chess::addPawnBitboardMovesToList(std::vector<BitMove>& moves, BitboardElement bitboard, int shift) {
-    if(bitboard.getData() == 0)
-        return;
-    bitboard.forEachBit([&](int toSquare) {
-        int fromSquare = toSquare - shift;
-        moves.emplace_back(fromSquare, toSquare, Pawn);
-    });
+    _reviewGeneration = _review.start(ChessEngine::startFEN(), moves, depth);
 }
-int negInf = -1000000;
-void Chess::updateAI() 
+
+void Chess::updateReview()
 {
-    int bestVal = negInf;
-    BitMove bestMove;
-    std::string state = stateString();
-    _countMoves = 0;
-
-    for(auto move : _moves) {
-        int srcSquare = move.from;
-        int dstSquare = move.to;
-
-        char oldDst = state[dstSquare];
-        char srcPce = state[srcSquare];
-        state[dstSquare] = srcPce;
-        state[srcSquare] = '0';
-        int moveVal = -negamax(state, 4, WHITE, negInf, -negInf);
-        // Undo the move
-        state[dstSquare] = oldDst;
-        state[srcSquare] = srcPce;
-
-        if(moveVal > bestVal) {
-            bestMove = move;
-            bestVal = moveVal;
+    // a review that was cancelled or replaced belongs to another game
+    if(_review.generation() != _reviewGeneration) {
+        return;
+    }
+    // turn i holds the position after i moves, which is review position i
+    auto positions = _review.positions();
+    for(size_t i = 0; i < positions.size() && i < _turns.size(); i++) {
+        if(!positions[i].done) {
+            continue;
+        }
+        _turns[i]->_score = positions[i].score;
+        ReviewedMove move;
+        if(i > 0 && _review.judgeMove((int)i - 1, move)) {
+            _turns[i]->_comment = move.comment;
         }
     }
+}
 
-    if(bestVal != negInf) {
-        std::cout <<"Moves checked: " << _countMoves << std::endl;
-        int srcSquare = bestMove.from;
-        int dstSquare = bestMove.to;
-        BitHolder& src = getHolderAt(srcSquare&7, srcSquare/8);
-        BitHolder& dst = getHolderAt(dstSquare&7, dstSquare/8);
-        Bit* bit = src.bit();
-        dst.dropBitAtPoint(bit, ImVec2(0, 0));
-        src.setBit(nullptr);
-        bitMovedFromTo(*bit, src, dst);
+void Chess::drawFrame()
+{
+    // a player whose clock runs out loses straight away, not when they next move
+    int current = _currentPlayer == WHITE ? 0 : 1;
+    if(_flaggedPlayer < 0 && _gameStatus == GameOngoing && clockMs(current) <= 0) {
+        stopAI();
+        _clockMs[current] = 0;
+        _flaggedPlayer = current;
+        ClassGame::EndOfTurn();
     }
+    Game::drawFrame();
 }
 
-static std::map<char, int> evaluateScores = {
-    {'P', 100}, {'p', -100},    // Pawns
-    {'N', 200}, {'n', -200},    // Knights
-    {'B', 230}, {'b', -230},    // Bishops
-    {'R', 400}, {'r', -400},    // Rooks
-    {'Q', 900}, {'q', -900},    // Queens
-    {'K', 2000}, {'k', -2000},  // Kings
-    {'0', 0}                     // Empty squares
-};
-
-int Chess::evaluateBoard(const std::string& state) {
-    int value = 0;
-    for(char ch : state) {
-        value += evaluateScores[ch];
-    }
-    return value;
+void Chess::stopAI()
+{
+    if(_aiTask) {
+        // the token stops a search that hasn't started yet too
+        _aiTask->cancel();
+        _aiEngine.stop();
+        _aiTask.reset();
+    }
 }
 
-
-//
-// player is the current player's number (AI or human)
-//
-int Chess::negamax(std::string& state, int depth, int playerColor, int alpha, int beta)
+void Chess::updateAI() 
 {
-    _countMoves++;
-    // Check if AI wins, human wins, or draw
-    if(depth == 0) { 
-        // A winning state is a loss for the player whose turn it is.
-        // The previous player made the winning move.
-        return evaluateBoard(state) * playerColor; 
-    }
-
-    auto newMoves = generateAllMoves(state, playerColor);
-
-    int bestVal = negInf; // Min value
-    BitMove bestMove;
-    for(auto move : newMoves) {
-        int srcSquare = move.from;
-        int dstSquare = move.to;
-
-        char oldDst = state[dstSquare];
-        char srcPce = state[srcSquare];
-        state[dstSquare] = srcPce;
-        state[srcSquare] = '0';
-        bestVal = std::max(bestVal, -negamax(state, depth - 1, -playerColor, -beta, -alpha));
-        // Undo the move
-        state[dstSquare] = oldDst;
-        state[srcSquare] = srcPce;
-        alpha = std::max(alpha, bestVal);
-        if (alpha >= beta) {
-            break;  // Beta cutoff
-        }
+    if(_gameStatus != GameOngoing || _flaggedPlayer >= 0) {
+        return;
+    }
+    if(!_aiTask) {
+        ChessClock clock;
+        clock.remainingMs = clockMs(_currentPlayer == WHITE ? 0 : 1);
+        clock.incrementMs = kIncrementMs;
+        _timeManager.start(clock);
+        _aiEngine.copyPosition(_engine);
+        _aiDone = false;
+        _aiTask = std::make_unique<TaskGroup>(ThreadPool::shared(), TaskInteractive);
+        SearchLimits limits = _timeManager.searchLimits();
+        limits.cancel = _aiTask->token().flag();
+        _aiTask->run([this, limits]() {
+            _aiResult = _aiEngine.search(limits, [this](const SearchResult& iteration) {
+                if(_timeManager.shouldStop(iteration)) {
+                    _aiEngine.stop();
+                }
+            });
+            _aiDone = true;
+        });
+        return;
+    }
+    if(!_aiDone) {
+        return;
+    }
+    _aiTask.reset();
+    if(_aiResult.bestMove.isNull()) {
+        return;
     }
 
-    return bestVal;
-}
\ No newline at end of file
+    BitMove bestMove = _aiResult.bestMove;
+    int srcSquare = bestMove.from;
+    int dstSquare = bestMove.to;
+    BitHolder& src = getHolderAt(srcSquare&7, srcSquare/8);
+    BitHolder& dst = getHolderAt(dstSquare&7, dstSquare/8);
+    dst.dropBitAtPoint(src.bit(), ImVec2(0, 0));
+    src.setBit(nullptr);
+    applyMove(bestMove);
+    Game::bitMovedFromTo(*dst.bit(), src, dst);
+}
@@ -2,28 +2,25 @@
 
 #include "Game.h"
 #include "Grid.h"
-#include "Bitboard.h"
+#include "ChessEngine.h"
+#include "TimeManager.h"
+#include "GameReview.h"
+#include "ThreadPool.h"
+#include <thread>
+#include <mutex>
+#include <memory>
 
 constexpr int pieceSize = 80;
-enum AllBitBoards {
-    WHITE_PAWNS,
-    WHITE_KNIGHTS,
-    WHITE_BISHOPS,
-    WHITE_ROOKS,
-    WHITE_QUEENS,
-    WHITE_KING,
-    WHITE_ALL_PIECES,
-    BLACK_PAWNS,
-    BLACK_KNIGHTS,
-    BLACK_BISHOPS,
-    BLACK_ROOKS,
-    BLACK_QUEENS,
-    BLACK_KING,
-    BLACK_ALL_PIECES,
-    OCCUPANCY,
-    EMPTY_SQUARES,
-    e_numBitboards
+
+// one line of the analysis window, already in SAN so the UI thread doesn't need an engine
+struct AnalysisLine
+{
+    int depth = 0;
+    int score = 0;              // from the side to move's point of view
+    uint64_t nodes = 0;
+    std::string moves;
 };
+
 class Chess : public Game
 {
 public:
@@ -31,6 +28,8 @@ public:
     ~Chess();
 
     void setUpBoard() override;
+    // flags a player whose clock has run out, then draws the board
+    void drawFrame() override;
 
     bool canBitMoveFrom(Bit &bit, BitHolder &src) override;
     bool canBitMoveFromTo(Bit &bit, BitHolder &src, BitHolder &dst) override;
@@ -46,38 +45,72 @@ public:
     std::string stateString() override;
     void setStateString(const std::string &s) override;
 
-    std::vector<BitMove> generateAllMoves(const std::string& state, int playerColor);
-
-    void generateKnightMoves(std::vector<BitMove>& moves, BitboardElement knightBoard, uint64_t emptySquares);
-    BitboardElement generateKnightMoveBitboard(int index);
+    Grid* getGrid() override { return _grid; }
+    // the AI searches on the shared pool while the board keeps drawing, a later call
+    // plays the move once the search is done
+    void updateAI() override;
+    void bitMovedFromTo(Bit &bit, BitHolder &src, BitHolder &dst) override;
 
-    void generateKingMoves(std::vector<BitMove>& moves, BitboardElement kingBoard, uint64_t emptySquares);
-    BitboardElement generateKingMoveBitboard(int index);
+    // time left on a player's clock, including the turn in progress
+    int clockMs(int playerNumber) const;
 
-    void generateBishopMoves(std::vector<BitMove>& moves, BitboardElement bishopBoard, uint64_t occupancy, uint64_t friendlies);
-    void generateRookMoves(std::vector<BitMove>& moves, BitboardElement rookBoard, uint64_t occupancy, uint64_t friendlies);
-    void generateQueenMoves(std::vector<BitMove>& moves, BitboardElement queenBoard, uint64_t occupancy, uint64_t friendlies);
+    // multi-PV analysis of the current position, searched as a background task on the
+    // shared pool so the board stays responsive. it follows the game, restarting after every move.
+    void startAnalysis(int lines);
+    void stopAnalysis();
+    bool analysing() const { return _analysisLineCount > 0; }
+    // the lines from the most recent completed iteration
+    std::vector<AnalysisLine> analysisLines();
 
-    void generatePawnMoves(std::vector<BitMove>& moves, BitboardElement pawnBoard, uint64_t emptySquares, uint64_t enemySquares, int playerColor);
-    void addPawnBitboardMovesToList(std::vector<BitMove>& moves, BitboardElement bitboard, int shift);
-
-    Grid* getGrid() override { return _grid; }
-    void updateAI() override;
-    int evaluateBoard(const std::string& state);
-    int negamax(std::string& state, int depth, int playerColor, int alpha, int beta);
+    // review the moves played so far on background threads. updateReview copies
+    // finished positions into each Turn's _score (white's point of view) and _comment.
+    void startReview(int depth);
+    void updateReview();
+    const GameReview& review() const { return _review; }
 
 private:
     Bit* PieceForPlayer(const int playerNumber, ChessPiece piece);
     Player* ownerAt(int x, int y) const;
-    void FENtoBoard(const std::string& fen);
-    char pieceNotation(int x, int y) const;
+    // make the sprite on one square match the engine
+    void syncSquare(int squareIndex);
+    // play a move on the engine and update the sprites on the squares it touched
+    void applyMove(const BitMove& move);
+    // legal moves for the side to move, and where each piece can go as a bitboard
+    void refreshMoves();
+    // cancels a search in progress and waits for its task
+    void stopAI();
 
     int _currentPlayer;
-    int _countMoves;
-    BitboardElement knightBoards[64];
-    BitboardElement kingBoards[64];
-    BitboardElement _bitboards[e_numBitboards];
-    int bitboardLookup[128];
+    // the engine's position is the source of truth, the Grid's sprites follow it
+    ChessEngine _engine;
+    GameStatus _gameStatus;
+    // both players play on a clock, the AI budgets its moves with the time manager
+    TimeManager _timeManager;
+    int _clockMs[2];
+    int _flaggedPlayer;
+    std::chrono::steady_clock::time_point _turnStart;
+    void launchAnalysis();
+    void joinAnalysis();
+
+    // the AI's copy of the position, its task and what it found
+    ChessEngine _aiEngine;
+    std::unique_ptr<TaskGroup> _aiTask;
+    std::atomic<bool> _aiDone;
+    SearchResult _aiResult;
+
     std::vector<BitMove> _moves;
+    uint64_t _destinations[64];
+    uint64_t _highlighted;
     Grid* _grid;
+
+    // the task searches its own copy of the position, only _analysisLines is shared
+    int _analysisLineCount;
+    std::unique_ptr<ChessEngine> _analysisEngine;
+    std::unique_ptr<TaskGroup> _analysisTask;
+    std::mutex _analysisMutex;
+    std::vector<AnalysisLine> _analysisLines;
+
+    GameReview _review;
+    // the generation of the review this game started, updateReview ignores any other
+    int _reviewGeneration;
 };
\ No newline at end of file
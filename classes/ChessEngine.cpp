@@ -0,0 +1,1144 @@
+#include "ChessEngine.h"
+#include "ChessEvalParams.h"
+#include "MagicBitboards.h"
+#include "KPKBitbase.h"
+#include <cctype>
+#include <bit>
+#include <algorithm>
+
+#define WHITE 1
+#define BLACK -1
+
+constexpr int INFINITE_SCORE = MATE_SCORE + 1;
+constexpr size_t DEFAULT_TT_ENTRIES = 1 << 18;
+// history scores order quiet moves below killers, the table is halved when one reaches this
+constexpr int HISTORY_MAX = 80000;
+
+enum TTBound
+{
+    BoundExact,
+    BoundLower,
+    BoundUpper
+};
+
+// castling rights bits
+constexpr int WHITE_KINGSIDE = 1;
+constexpr int WHITE_QUEENSIDE = 2;
+constexpr int BLACK_KINGSIDE = 4;
+constexpr int BLACK_QUEENSIDE = 8;
+
+static const char* kPieceChars = "0PNBRQK";
+
+//
+// zobrist keys are shared by every engine instance. they are built once and never
+// written again, so reading them from several searching threads is safe.
+//
+struct ZobristKeys
+{
+    uint64_t pieces[128][64];
+    uint64_t castling[16];
+    uint64_t enPassant[8];
+    uint64_t side;
+};
+
+static const ZobristKeys& zobrist()
+{
+    static const ZobristKeys keys = []() {
+        ZobristKeys k = {};
+        uint64_t seed = 0x9E3779B97F4A7C15ULL;
+        auto next = [&seed]() {
+            // xorshift64*
+            seed ^= seed >> 12;
+            seed ^= seed << 25;
+            seed ^= seed >> 27;
+            return seed * 0x2545F4914F6CDD1DULL;
+        };
+        for(const char* piece = "PNBRQKpnbrqk"; *piece; piece++) {
+            for(int square = 0; square < 64; square++) {
+                k.pieces[(int)*piece][square] = next();
+            }
+        }
+        for(auto& key : k.castling) key = next();
+        for(auto& key : k.enPassant) key = next();
+        k.side = next();
+        return k;
+    }();
+    return keys;
+}
+
+// which castling rights survive a move touching each square
+static int castlingMask(int square)
+{
+    switch(square) {
+        case 0:  return ~WHITE_QUEENSIDE;
+        case 4:  return ~(WHITE_KINGSIDE | WHITE_QUEENSIDE);
+        case 7:  return ~WHITE_KINGSIDE;
+        case 56: return ~BLACK_QUEENSIDE;
+        case 60: return ~(BLACK_KINGSIDE | BLACK_QUEENSIDE);
+        case 63: return ~BLACK_KINGSIDE;
+    }
+    return ~0;
+}
+
+ChessEngine::ChessEngine()
+{
+    // the magic attack tables are built by whichever instance gets here first, then only read
+    initMagicBitboards();
+    setPieceValues(kPieceValues);
+    _nodes = 0;
+    _stop = false;
+    clear();
+}
+
+void ChessEngine::setPieceValues(const int pieceValues[7])
+{
+    for(int piece = NoPiece; piece <= King; piece++) {
+        _pieceValues[piece] = pieceValues[piece];
+    }
+}
+
+void ChessEngine::clear()
+{
+    for(int i = 0; i < 64; i++) {
+        _squares[i] = '0';
+    }
+    for(int i = 0; i < e_numBitboards; i++) {
+        _bitboards[i] = 0;
+    }
+    _bitboards[EMPTY_SQUARES] = ~0ULL;
+    _sideToMove = WHITE;
+    _castlingRights = 0;
+    _enPassantSquare = -1;
+    _halfMoveClock = 0;
+    _fullMoveNumber = 1;
+    _hash = 0;
+    _undo.clear();
+    _history.clear();
+}
+
+ChessPiece ChessEngine::pieceType(char piece)
+{
+    switch(std::toupper((unsigned char)piece)) {
+        case 'P': return Pawn;
+        case 'N': return Knight;
+        case 'B': return Bishop;
+        case 'R': return Rook;
+        case 'Q': return Queen;
+        case 'K': return King;
+    }
+    return NoPiece;
+}
+
+void ChessEngine::putPiece(int square, char piece)
+{
+    ChessPiece type = pieceType(piece);
+    if(type == NoPiece) {
+        return;
+    }
+    uint64_t bit = 1ULL << square;
+    int board = (std::isupper((unsigned char)piece) ? (int)WHITE_PAWNS : (int)BLACK_PAWNS) + type - 1;
+    int allBoard = std::isupper((unsigned char)piece) ? WHITE_ALL_PIECES : BLACK_ALL_PIECES;
+    _squares[square] = piece;
+    _bitboards[board] |= bit;
+    _bitboards[allBoard] |= bit;
+    _bitboards[OCCUPANCY] |= bit;
+    _bitboards[EMPTY_SQUARES] &= ~bit;
+    _hash ^= zobrist().pieces[(int)piece][square];
+}
+
+void ChessEngine::removePiece(int square)
+{
+    char piece = _squares[square];
+    ChessPiece type = pieceType(piece);
+    if(type == NoPiece) {
+        return;
+    }
+    uint64_t bit = 1ULL << square;
+    int board = (std::isupper((unsigned char)piece) ? (int)WHITE_PAWNS : (int)BLACK_PAWNS) + type - 1;
+    int allBoard = std::isupper((unsigned char)piece) ? WHITE_ALL_PIECES : BLACK_ALL_PIECES;
+    _squares[square] = '0';
+    _bitboards[board] &= ~bit;
+    _bitboards[allBoard] &= ~bit;
+    _bitboards[OCCUPANCY] &= ~bit;
+    _bitboards[EMPTY_SQUARES] |= bit;
+    _hash ^= zobrist().pieces[(int)piece][square];
+}
+
+void ChessEngine::movePiece(int from, int to)
+{
+    char piece = _squares[from];
+    removePiece(from);
+    putPiece(to, piece);
+}
+
+void ChessEngine::setStateString(const std::string& state, int playerColor)
+{
+    clear();
+    for(int i = 0; i < 64 && i < (int)state.length(); i++) {
+        putPiece(i, state[i]);
+    }
+    _sideToMove = playerColor;
+    if(_sideToMove == BLACK) {
+        _hash ^= zobrist().side;
+    }
+    _hash ^= zobrist().castling[0];
+    _history.push_back(_hash);
+}
+
+bool ChessEngine::setFEN(const std::string& fen)
+{
+    clear();
+    // 1: piece placement, rank 8 first
+    int file = 0;
+    int rank = 7;
+    size_t i = 0;
+    for(; i < fen.length() && fen[i] != ' '; i++) {
+        const char current = fen[i];
+        if(current == '/') {
+            file = 0;
+            rank--;
+        } else if(current >= '1' && current <= '8') {
+            file += current - '0';
+        } else if(pieceType(current) != NoPiece && file < 8 && rank >= 0) {
+            putPiece(rank * 8 + file, current);
+            file++;
+        } else {
+            return false;
+        }
+    }
+    if(rank != 0) {
+        return false;
+    }
+
+    // the remaining fields are optional, EPD lines only carry the first three
+    std::string fields[5];
+    for(int field = 0; field < 5 && i < fen.length(); field++) {
+        while(i < fen.length() && fen[i] == ' ') {
+            i++;
+        }
+        while(i < fen.length() && fen[i] != ' ') {
+            fields[field] += fen[i++];
+        }
+    }
+    // 2: active color
+    _sideToMove = fields[0] == "b" ? BLACK : WHITE;
+    // 3: castling availability, only kept when the king and rook are still at home
+    for(char right : fields[1]) {
+        if(right == 'K' && _squares[4] == 'K' && _squares[7] == 'R') _castlingRights |= WHITE_KINGSIDE;
+        if(right == 'Q' && _squares[4] == 'K' && _squares[0] == 'R') _castlingRights |= WHITE_QUEENSIDE;
+        if(right == 'k' && _squares[60] == 'k' && _squares[63] == 'r') _castlingRights |= BLACK_KINGSIDE;
+        if(right == 'q' && _squares[60] == 'k' && _squares[56] == 'r') _castlingRights |= BLACK_QUEENSIDE;
+    }
+    // 4: en passant target square
+    const std::string& ep = fields[2];
+    if(ep.length() == 2 && ep[0] >= 'a' && ep[0] <= 'h' && (ep[1] == '3' || ep[1] == '6')) {
+        _enPassantSquare = (ep[1] - '1') * 8 + (ep[0] - 'a');
+    }
+    // 5, 6: halfmove clock and fullmove number
+    if(!fields[3].empty() && std::isdigit((unsigned char)fields[3][0])) {
+        _halfMoveClock = std::stoi(fields[3]);
+    }
+    if(!fields[4].empty() && std::isdigit((unsigned char)fields[4][0])) {
+        _fullMoveNumber = std::max(1, std::stoi(fields[4]));
+    }
+
+    if(_sideToMove == BLACK) {
+        _hash ^= zobrist().side;
+    }
+    _hash ^= zobrist().castling[_castlingRights];
+    if(_enPassantSquare >= 0) {
+        _hash ^= zobrist().enPassant[_enPassantSquare & 7];
+    }
+    _history.push_back(_hash);
+    return true;
+}
+
+void ChessEngine::copyPosition(const ChessEngine& other)
+{
+    std::copy(std::begin(other._squares), std::end(other._squares), _squares);
+    std::copy(std::begin(other._bitboards), std::end(other._bitboards), _bitboards);
+    _sideToMove = other._sideToMove;
+    _castlingRights = other._castlingRights;
+    _enPassantSquare = other._enPassantSquare;
+    _halfMoveClock = other._halfMoveClock;
+    _fullMoveNumber = other._fullMoveNumber;
+    _hash = other._hash;
+    _undo = other._undo;
+    _history = other._history;
+    std::copy(std::begin(other._pieceValues), std::end(other._pieceValues), _pieceValues);
+}
+
+std::string ChessEngine::getFEN() const
+{
+    std::string fen;
+    for(int rank = 7; rank >= 0; rank--) {
+        int empty = 0;
+        for(int file = 0; file < 8; file++) {
+            char piece = _squares[rank * 8 + file];
+            if(piece == '0') {
+                empty++;
+                continue;
+            }
+            if(empty) {
+                fen += char('0' + empty);
+                empty = 0;
+            }
+            fen += piece;
+        }
+        if(empty) {
+            fen += char('0' + empty);
+        }
+        if(rank) {
+            fen += '/';
+        }
+    }
+    fen += _sideToMove == WHITE ? " w " : " b ";
+    if(_castlingRights & WHITE_KINGSIDE) fen += 'K';
+    if(_castlingRights & WHITE_QUEENSIDE) fen += 'Q';
+    if(_castlingRights & BLACK_KINGSIDE) fen += 'k';
+    if(_castlingRights & BLACK_QUEENSIDE) fen += 'q';
+    if(!_castlingRights) fen += '-';
+    if(_enPassantSquare >= 0) {
+        fen += ' ';
+        fen += char('a' + (_enPassantSquare & 7));
+        fen += char('1' + (_enPassantSquare >> 3));
+    } else {
+        fen += " -";
+    }
+    fen += ' ';
+    fen += std::to_string(_halfMoveClock);
+    fen += ' ';
+    fen += std::to_string(_fullMoveNumber);
+    return fen;
+}
+
+void ChessEngine::evaluationTerms(int terms[7]) const
+{
+    for(int piece = NoPiece; piece <= King; piece++) {
+        terms[piece] = 0;
+    }
+    for(int piece = Pawn; piece <= King; piece++) {
+        int whiteCount = std::popcount(_bitboards[WHITE_PAWNS + piece - 1].getData());
+        int blackCount = std::popcount(_bitboards[BLACK_PAWNS + piece - 1].getData());
+        terms[piece] = whiteCount - blackCount;
+    }
+}
+
+int ChessEngine::evaluate(const int* pieceValues) const
+{
+    int terms[7];
+    evaluationTerms(terms);
+    int value = 0;
+    for(int piece = Pawn; piece <= King; piece++) {
+        value += terms[piece] * pieceValues[piece];
+    }
+    return value;
+}
+
+int ChessEngine::evaluate() const
+{
+    return evaluate(_pieceValues);
+}
+
+int ChessEngine::kingSquare(int color) const
+{
+    uint64_t king = _bitboards[color == WHITE ? WHITE_KING : BLACK_KING].getData();
+    return king ? std::countr_zero(king) : -1;
+}
+
+bool ChessEngine::isSquareAttacked(int square, int byColor) const
+{
+    if(square < 0) {
+        return false;
+    }
+    int bitIndex = byColor == WHITE ? WHITE_PAWNS : BLACK_PAWNS;
+    uint64_t occupancy = _bitboards[OCCUPANCY].getData();
+    uint64_t squareBit = 1ULL << square;
+
+    // a pawn attacks this square if an opposing pawn standing here would attack it back
+    uint64_t pawnSources = byColor == WHITE ? BLACK_PAWN_ATTACKS(squareBit) : WHITE_PAWN_ATTACKS(squareBit);
+    if(pawnSources & _bitboards[bitIndex + WHITE_PAWNS].getData()) return true;
+    if(KnightAttacks[square] & _bitboards[bitIndex + WHITE_KNIGHTS].getData()) return true;
+    if(KingAttacks[square] & _bitboards[bitIndex + WHITE_KING].getData()) return true;
+    uint64_t diagonals = _bitboards[bitIndex + WHITE_BISHOPS].getData() | _bitboards[bitIndex + WHITE_QUEENS].getData();
+    if(diagonals && (getBishopAttacks(square, occupancy) & diagonals)) return true;
+    uint64_t straights = _bitboards[bitIndex + WHITE_ROOKS].getData() | _bitboards[bitIndex + WHITE_QUEENS].getData();
+    if(straights && (getRookAttacks(square, occupancy) & straights)) return true;
+    return false;
+}
+
+//
+// move generation
+//
+std::vector<BitMove> ChessEngine::generateAllMoves()
+{
+    std::vector<BitMove> moves;
+    moves.reserve(64);
+    generatePseudoMoves(moves, false);
+    filterLegalMoves(moves);
+    return moves;
+}
+
+void ChessEngine::generatePseudoMoves(std::vector<BitMove>& moves, bool capturesOnly)
+{
+    int bitIndex = _sideToMove == WHITE ? WHITE_PAWNS : BLACK_PAWNS;
+    int oppBitIndex = _sideToMove == WHITE ? BLACK_PAWNS : WHITE_PAWNS;
+    uint64_t friendlies = _bitboards[WHITE_ALL_PIECES + bitIndex].getData();
+    uint64_t enemies = _bitboards[WHITE_ALL_PIECES + oppBitIndex].getData();
+    uint64_t targets = capturesOnly ? enemies : ~friendlies;
+
+    generateKnightMoves(moves, _bitboards[WHITE_KNIGHTS + bitIndex], targets);
+    generateSliderMoves(moves, _bitboards[WHITE_BISHOPS + bitIndex], Bishop, targets);
+    generateSliderMoves(moves, _bitboards[WHITE_ROOKS + bitIndex], Rook, targets);
+    generateSliderMoves(moves, _bitboards[WHITE_QUEENS + bitIndex], Queen, targets);
+    generateKingMoves(moves, _bitboards[WHITE_KING + bitIndex], targets);
+    generatePawnMoves(moves, _bitboards[WHITE_PAWNS + bitIndex], capturesOnly);
+    if(!capturesOnly) {
+        generateCastlingMoves(moves);
+    }
+}
+
+void ChessEngine::generateKnightMoves(std::vector<BitMove>& moves, BitboardElement knightBoard, uint64_t targets)
+{
+    uint64_t occupancy = _bitboards[OCCUPANCY].getData();
+    knightBoard.forEachBit([&](int fromSquare) {
+        BitboardElement moveBitboard = BitboardElement(KnightAttacks[fromSquare] & targets);
+        moveBitboard.forEachBit([&](int toSquare) {
+            moves.emplace_back(fromSquare, toSquare, Knight, (occupancy >> toSquare) & 1 ? MoveCapture : MoveQuiet);
+        });
+    });
+}
+
+void ChessEngine::generateKingMoves(std::vector<BitMove>& moves, BitboardElement kingBoard, uint64_t targets)
+{
+    uint64_t occupancy = _bitboards[OCCUPANCY].getData();
+    kingBoard.forEachBit([&](int fromSquare) {
+        BitboardElement moveBitboard = BitboardElement(KingAttacks[fromSquare] & targets);
+        moveBitboard.forEachBit([&](int toSquare) {
+            moves.emplace_back(fromSquare, toSquare, King, (occupancy >> toSquare) & 1 ? MoveCapture : MoveQuiet);
+        });
+    });
+}
+
+void ChessEngine::generateSliderMoves(std::vector<BitMove>& moves, BitboardElement board, ChessPiece piece, uint64_t targets)
+{
+    uint64_t occupancy = _bitboards[OCCUPANCY].getData();
+    board.forEachBit([&](int fromSquare) {
+        uint64_t attacks = piece == Bishop ? getBishopAttacks(fromSquare, occupancy) :
+                           piece == Rook ? getRookAttacks(fromSquare, occupancy) :
+                           getQueenAttacks(fromSquare, occupancy);
+        BitboardElement moveBitboard = BitboardElement(attacks & targets);
+        moveBitboard.forEachBit([&](int toSquare) {
+            moves.emplace_back(fromSquare, toSquare, piece, (occupancy >> toSquare) & 1 ? MoveCapture : MoveQuiet);
+        });
+    });
+}
+
+void ChessEngine::generatePawnMoves(std::vector<BitMove>& moves, BitboardElement pawnBoard, bool capturesOnly)
+{
+    constexpr uint64_t NotAFile(0xFEFEFEFEFEFEFEFEULL);
+    constexpr uint64_t NotHFile(0x7F7F7F7F7F7F7F7FULL);
+    constexpr uint64_t Rank3(0x0000000000FF0000ULL);
+    constexpr uint64_t Rank6(0x0000FF0000000000ULL);
+    constexpr uint64_t PromotionRanks(0xFF000000000000FFULL);
+
+    const bool white = _sideToMove == WHITE;
+    uint64_t pawns = pawnBoard.getData();
+    uint64_t emptySquares = _bitboards[EMPTY_SQUARES].getData();
+    uint64_t enemySquares = _bitboards[white ? BLACK_ALL_PIECES : WHITE_ALL_PIECES].getData();
+    uint64_t enPassant = _enPassantSquare >= 0 ? 1ULL << _enPassantSquare : 0;
+
+    uint64_t singleMoves = (white ? pawns << 8 : pawns >> 8) & emptySquares;
+    uint64_t doubleMoves = (white ? (singleMoves & Rank3) << 8 : (singleMoves & Rank6) >> 8) & emptySquares;
+    uint64_t leftTargets = white ? (pawns & NotAFile) << 7 : (pawns & NotAFile) >> 9;
+    uint64_t rightTargets = white ? (pawns & NotHFile) << 9 : (pawns & NotHFile) >> 7;
+
+    int shiftForward = white ? 8 : -8;
+    int doubleShift = white ? 16 : -16;
+    int captureLeftShift = white ? 7 : -9;
+    int captureRightShift = white ? 9 : -7;
+
+    addPawnBitboardMovesToList(moves, leftTargets & enemySquares, captureLeftShift, MoveCapture, capturesOnly);
+    addPawnBitboardMovesToList(moves, rightTargets & enemySquares, captureRightShift, MoveCapture, capturesOnly);
+    addPawnBitboardMovesToList(moves, leftTargets & enPassant, captureLeftShift, MoveCapture | MoveEnPassant, capturesOnly);
+    addPawnBitboardMovesToList(moves, rightTargets & enPassant, captureRightShift, MoveCapture | MoveEnPassant, capturesOnly);
+    if(capturesOnly) {
+        // a queen promotion swings the material as much as a capture does
+        addPawnBitboardMovesToList(moves, singleMoves & PromotionRanks, shiftForward, MoveQuiet, true);
+        return;
+    }
+    addPawnBitboardMovesToList(moves, singleMoves, shiftForward, MoveQuiet, false);
+    addPawnBitboardMovesToList(moves, doubleMoves, doubleShift, MoveDoublePush, false);
+}
+
+void ChessEngine::addPawnBitboardMovesToList(std::vector<BitMove>& moves, BitboardElement bitboard, int shift, int flags, bool queenOnly)
+{
+    if(bitboard.getData() == 0)
+        return;
+    bitboard.forEachBit([&](int toSquare) {
+        int fromSquare = toSquare - shift;
+        if(toSquare < 8 || toSquare >= 56) {
+            moves.emplace_back(fromSquare, toSquare, Pawn, flags, Queen);
+            if(!queenOnly) {
+                moves.emplace_back(fromSquare, toSquare, Pawn, flags, Knight);
+                moves.emplace_back(fromSquare, toSquare, Pawn, flags, Rook);
+                moves.emplace_back(fromSquare, toSquare, Pawn, flags, Bishop);
+            }
+        } else {
+            moves.emplace_back(fromSquare, toSquare, Pawn, flags);
+        }
+    });
+}
+
+void ChessEngine::generateCastlingMoves(std::vector<BitMove>& moves)
+{
+    uint64_t occupancy = _bitboards[OCCUPANCY].getData();
+    int them = -_sideToMove;
+    // the king may not castle out of, through or into check
+    if(_sideToMove == WHITE) {
+        if((_castlingRights & WHITE_KINGSIDE) && !(occupancy & 0x60ULL) &&
+           !isSquareAttacked(4, them) && !isSquareAttacked(5, them) && !isSquareAttacked(6, them)) {
+            moves.emplace_back(4, 6, King, MoveCastle);
+        }
+        if((_castlingRights & WHITE_QUEENSIDE) && !(occupancy & 0x0EULL) &&
+           !isSquareAttacked(4, them) && !isSquareAttacked(3, them) && !isSquareAttacked(2, them)) {
+            moves.emplace_back(4, 2, King, MoveCastle);
+        }
+    } else {
+        if((_castlingRights & BLACK_KINGSIDE) && !(occupancy & (0x60ULL << 56)) &&
+           !isSquareAttacked(60, them) && !isSquareAttacked(61, them) && !isSquareAttacked(62, them)) {
+            moves.emplace_back(60, 62, King, MoveCastle);
+        }
+        if((_castlingRights & BLACK_QUEENSIDE) && !(occupancy & (0x0EULL << 56)) &&
+           !isSquareAttacked(60, them) && !isSquareAttacked(59, them) && !isSquareAttacked(58, them)) {
+            moves.emplace_back(60, 58, King, MoveCastle);
+        }
+    }
+}
+
+void ChessEngine::filterLegalMoves(std::vector<BitMove>& moves)
+{
+    size_t legal = 0;
+    for(size_t i = 0; i < moves.size(); i++) {
+        makeMove(moves[i]);
+        bool leavesKingInCheck = isSquareAttacked(kingSquare(-_sideToMove), _sideToMove);
+        unmakeMove();
+        if(!leavesKingInCheck) {
+            moves[legal++] = moves[i];
+        }
+    }
+    moves.resize(legal);
+}
+
+//
+// make and unmake
+//
+void ChessEngine::makeMove(const BitMove& move)
+{
+    const ZobristKeys& keys = zobrist();
+    UndoState undo = { move, '0', _castlingRights, _enPassantSquare, _halfMoveClock, _hash };
+    int from = move.from;
+    int to = move.to;
+
+    _hash ^= keys.castling[_castlingRights];
+    if(_enPassantSquare >= 0) {
+        _hash ^= keys.enPassant[_enPassantSquare & 7];
+    }
+
+    if(move.flags & MoveEnPassant) {
+        int capturedSquare = to - 8 * _sideToMove;
+        undo.captured = _squares[capturedSquare];
+        removePiece(capturedSquare);
+    } else if(_squares[to] != '0') {
+        undo.captured = _squares[to];
+        removePiece(to);
+    }
+    movePiece(from, to);
+    if(move.promotion != NoPiece) {
+        char promoted = kPieceChars[move.promotion];
+        removePiece(to);
+        putPiece(to, _sideToMove == WHITE ? promoted : (char)std::tolower((unsigned char)promoted));
+    }
+    if(move.flags & MoveCastle) {
+        // the rook jumps over to the other side of the king
+        if(to == 6) movePiece(7, 5);
+        else if(to == 2) movePiece(0, 3);
+        else if(to == 62) movePiece(63, 61);
+        else if(to == 58) movePiece(56, 59);
+    }
+
+    _castlingRights &= castlingMask(from) & castlingMask(to);
+    _enPassantSquare = (move.flags & MoveDoublePush) ? (from + to) / 2 : -1;
+    _halfMoveClock = (move.piece == Pawn || undo.captured != '0') ? 0 : _halfMoveClock + 1;
+    if(_sideToMove == BLACK) {
+        _fullMoveNumber++;
+    }
+    _sideToMove = -_sideToMove;
+
+    _hash ^= keys.side;
+    _hash ^= keys.castling[_castlingRights];
+    if(_enPassantSquare >= 0) {
+        _hash ^= keys.enPassant[_enPassantSquare & 7];
+    }
+    _undo.push_back(undo);
+    _history.push_back(_hash);
+}
+
+void ChessEngine::unmakeMove()
+{
+    if(_undo.empty()) {
+        return;
+    }
+    UndoState undo = _undo.back();
+    _undo.pop_back();
+    _history.pop_back();
+
+    _sideToMove = -_sideToMove;
+    if(_sideToMove == BLACK) {
+        _fullMoveNumber--;
+    }
+    const BitMove& move = undo.move;
+    if(move.promotion != NoPiece) {
+        removePiece(move.to);
+        putPiece(move.to, _sideToMove == WHITE ? 'P' : 'p');
+    }
+    movePiece(move.to, move.from);
+    if(move.flags & MoveCastle) {
+        if(move.to == 6) movePiece(5, 7);
+        else if(move.to == 2) movePiece(3, 0);
+        else if(move.to == 62) movePiece(61, 63);
+        else if(move.to == 58) movePiece(59, 56);
+    }
+    if(undo.captured != '0') {
+        int capturedSquare = (move.flags & MoveEnPassant) ? move.to - 8 * _sideToMove : move.to;
+        putPiece(capturedSquare, undo.captured);
+    }
+    _castlingRights = undo.castlingRights;
+    _enPassantSquare = undo.enPassantSquare;
+    _halfMoveClock = undo.halfMoveClock;
+    _hash = undo.hash;
+}
+
+//
+// game state
+//
+bool ChessEngine::isRepetition() const
+{
+    // only positions since the last capture or pawn move can repeat, and only with the same side to move
+    int last = (int)_history.size() - 1;
+    int oldest = std::max(0, last - _halfMoveClock);
+    for(int i = last - 2; i >= oldest; i -= 2) {
+        if(_history[i] == _hash) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ChessEngine::insufficientMaterial() const
+{
+    uint64_t mating = _bitboards[WHITE_PAWNS].getData() | _bitboards[BLACK_PAWNS].getData() |
+                      _bitboards[WHITE_ROOKS].getData() | _bitboards[BLACK_ROOKS].getData() |
+                      _bitboards[WHITE_QUEENS].getData() | _bitboards[BLACK_QUEENS].getData();
+    if(mating) {
+        return false;
+    }
+    // a lone minor piece can't force mate
+    uint64_t minors = _bitboards[WHITE_KNIGHTS].getData() | _bitboards[BLACK_KNIGHTS].getData() |
+                      _bitboards[WHITE_BISHOPS].getData() | _bitboards[BLACK_BISHOPS].getData();
+    return std::popcount(minors) <= 1;
+}
+
+//
+// king and pawn against king is looked up instead of searched. a win is scored
+// below a queen, so the search still prefers actually promoting, and pushing the
+// pawn scores a little more so it makes progress rather than shuffling.
+//
+bool ChessEngine::probeEndgame(int& score) const
+{
+    if(std::popcount(_bitboards[OCCUPANCY].getData()) != 3) {
+        return false;
+    }
+    uint64_t whitePawns = _bitboards[WHITE_PAWNS].getData();
+    uint64_t pawns = whitePawns | _bitboards[BLACK_PAWNS].getData();
+    if(!pawns) {
+        return false;
+    }
+    int strongColor = whitePawns ? WHITE : BLACK;
+    int pawn = std::countr_zero(pawns);
+    if(!probeKPK(strongColor, kingSquare(strongColor), pawn, kingSquare(-strongColor), _sideToMove)) {
+        score = 0;
+        return true;
+    }
+    int rank = strongColor == WHITE ? pawn / 8 : 7 - pawn / 8;
+    score = (_pieceValues[Queen] / 2 + rank * 10) * strongColor * _sideToMove;
+    return true;
+}
+
+GameStatus ChessEngine::gameStatus()
+{
+    return gameStatus(generateAllMoves());
+}
+
+GameStatus ChessEngine::gameStatus(const std::vector<BitMove>& legalMoves)
+{
+    if(legalMoves.empty()) {
+        return inCheck() ? GameCheckmate : GameStalemate;
+    }
+    if(_halfMoveClock >= 100) {
+        return GameDrawFiftyMove;
+    }
+    int repeats = 0;
+    int last = (int)_history.size() - 1;
+    int oldest = std::max(0, last - _halfMoveClock);
+    for(int i = last; i >= oldest; i -= 2) {
+        if(_history[i] == _hash) {
+            repeats++;
+        }
+    }
+    if(repeats >= 3) {
+        return GameDrawRepetition;
+    }
+    if(insufficientMaterial()) {
+        return GameDrawMaterial;
+    }
+    return GameOngoing;
+}
+
+//
+// move text
+//
+std::string ChessEngine::moveToString(const BitMove& move)
+{
+    std::string text;
+    text += char('a' + (move.from & 7));
+    text += char('1' + (move.from >> 3));
+    text += char('a' + (move.to & 7));
+    text += char('1' + (move.to >> 3));
+    if(move.promotion != NoPiece) {
+        text += "0pnbrqk"[move.promotion];
+    }
+    return text;
+}
+
+std::string ChessEngine::moveToSAN(const BitMove& move)
+{
+    std::string san;
+    if(move.flags & MoveCastle) {
+        san = (move.to & 7) == 6 ? "O-O" : "O-O-O";
+    } else {
+        bool capture = (move.flags & MoveCapture) != 0;
+        if(move.piece == Pawn) {
+            if(capture) {
+                san += char('a' + (move.from & 7));
+            }
+        } else {
+            san += kPieceChars[move.piece];
+            // disambiguate between identical pieces that can reach the same square
+            bool ambiguous = false, sameFile = false, sameRank = false;
+            for(const auto& other : generateAllMoves()) {
+                if(other.piece == move.piece && other.to == move.to && other.from != move.from) {
+                    ambiguous = true;
+                    sameFile |= (other.from & 7) == (move.from & 7);
+                    sameRank |= (other.from >> 3) == (move.from >> 3);
+                }
+            }
+            if(ambiguous) {
+                if(!sameFile) {
+                    san += char('a' + (move.from & 7));
+                } else if(!sameRank) {
+                    san += char('1' + (move.from >> 3));
+                } else {
+                    san += char('a' + (move.from & 7));
+                    san += char('1' + (move.from >> 3));
+                }
+            }
+        }
+        if(capture) {
+            san += 'x';
+        }
+        san += char('a' + (move.to & 7));
+        san += char('1' + (move.to >> 3));
+        if(move.promotion != NoPiece) {
+            san += '=';
+            san += kPieceChars[move.promotion];
+        }
+    }
+    makeMove(move);
+    if(inCheck()) {
+        san += generateAllMoves().empty() ? '#' : '+';
+    }
+    unmakeMove();
+    return san;
+}
+
+bool ChessEngine::parseMove(const std::string& text, BitMove& move)
+{
+    // strip check marks and annotations, and accept 0-0 for O-O
+    std::string clean;
+    for(char c : text) {
+        if(c == '+' || c == '#' || c == '!' || c == '?') {
+            continue;
+        }
+        clean += c == '0' ? 'O' : c;
+    }
+    if(clean.empty()) {
+        return false;
+    }
+    auto moves = generateAllMoves();
+    for(const auto& candidate : moves) {
+        if(moveToString(candidate) == text) {
+            move = candidate;
+            return true;
+        }
+    }
+    for(const auto& candidate : moves) {
+        std::string san = moveToSAN(candidate);
+        while(!san.empty() && (san.back() == '+' || san.back() == '#')) {
+            san.pop_back();
+        }
+        if(san == clean) {
+            move = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+//
+// search
+//
+void ChessEngine::setTranspositionTableSize(size_t entries)
+{
+    // keep the size a power of two so the index is a mask
+    size_t size = 1;
+    while(size * 2 <= entries) {
+        size *= 2;
+    }
+    _tt.assign(size, TTEntry());
+}
+
+void ChessEngine::clearTranspositionTable()
+{
+    if(_tt.empty()) {
+        setTranspositionTableSize(DEFAULT_TT_ENTRIES);
+    }
+    std::fill(_tt.begin(), _tt.end(), TTEntry());
+}
+
+ChessEngine::TTEntry* ChessEngine::probeTT(uint64_t key)
+{
+    TTEntry& entry = _tt[key & (_tt.size() - 1)];
+    return entry.key == key ? &entry : nullptr;
+}
+
+void ChessEngine::storeTT(uint64_t key, int depth, int score, int bound, const BitMove& move, int ply)
+{
+    TTEntry& entry = _tt[key & (_tt.size() - 1)];
+    if(entry.key == key && depth < entry.depth) {
+        return;
+    }
+    // mate scores are stored relative to this node rather than to the root
+    if(score > MATE_SCORE - MAX_PLY) score += ply;
+    else if(score < -MATE_SCORE + MAX_PLY) score -= ply;
+    entry.key = key;
+    entry.move = move;
+    entry.score = score;
+    entry.depth = (int8_t)depth;
+    entry.bound = (uint8_t)bound;
+}
+
+bool ChessEngine::checkLimits()
+{
+    if(_limits.cancel && *_limits.cancel) {
+        _stop = true;
+    }
+    if(_stop) {
+        return true;
+    }
+    if(_limits.nodes && _nodes >= _limits.nodes) {
+        _stop = true;
+    } else if(_limits.timeMs && (_nodes & 1023) == 0) {
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _searchStart).count();
+        if(elapsed >= _limits.timeMs) {
+            _stop = true;
+        }
+    }
+    return _stop;
+}
+
+void ChessEngine::orderMoves(std::vector<BitMove>& moves, const BitMove& ttMove, int ply)
+{
+    int colorIndex = _sideToMove == WHITE ? 0 : 1;
+    std::vector<std::pair<int, BitMove>> scored;
+    scored.reserve(moves.size());
+    for(const auto& move : moves) {
+        int score;
+        if(move == ttMove) {
+            score = 1000000;
+        } else if(move.flags & MoveCapture) {
+            // most valuable victim, least valuable attacker
+            int victim = (move.flags & MoveEnPassant) ? Pawn : pieceType(_squares[move.to]);
+            score = 100000 + victim * 10 - move.piece;
+        } else if(move.promotion == Queen) {
+            score = 95000;
+        } else if(ply < MAX_PLY && (move == _killers[ply][0] || move == _killers[ply][1])) {
+            score = 90000;
+        } else {
+            score = std::min(_historyScores[colorIndex][move.from][move.to], HISTORY_MAX);
+        }
+        scored.emplace_back(score, move);
+    }
+    std::stable_sort(scored.begin(), scored.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+    for(size_t i = 0; i < moves.size(); i++) {
+        moves[i] = scored[i].second;
+    }
+}
+
+SearchResult ChessEngine::search(const SearchLimits& limits, std::function<void(const SearchResult&)> onIteration)
+{
+    _limits = limits;
+    _nodes = 0;
+    _stop = false;
+    _searchStart = std::chrono::steady_clock::now();
+    if(_tt.empty()) {
+        setTranspositionTableSize(DEFAULT_TT_ENTRIES);
+    }
+    for(auto& killers : _killers) {
+        killers[0] = killers[1] = BitMove();
+    }
+    for(auto& color : _historyScores) {
+        for(auto& from : color) {
+            for(int& score : from) {
+                score = 0;
+            }
+        }
+    }
+
+    SearchResult result;
+    auto rootMoves = generateAllMoves();
+    if(rootMoves.empty()) {
+        result.score = inCheck() ? -MATE_SCORE : 0;
+        return result;
+    }
+    result.bestMove = rootMoves[0];
+    result.pv.push_back(rootMoves[0]);
+
+    int lineCount = std::clamp(limits.multiPV, 1, (int)rootMoves.size());
+    for(int depth = 1; depth <= std::min(limits.depth, MAX_PLY - 1); depth++) {
+        // multi-PV searches the root again for each line, leaving out the moves
+        // already reported. the transposition table filled by the first line makes
+        // the later ones cheap.
+        std::vector<SearchLine> lines;
+        _rootExcluded.clear();
+        int score = 0;
+        for(int line = 0; line < lineCount; line++) {
+            int lineScore = negamax(depth, 0, -INFINITE_SCORE, INFINITE_SCORE);
+            if(_stop || _pvLength[0] == 0) {
+                break;
+            }
+            if(line == 0) {
+                score = lineScore;
+            }
+            lines.push_back({ lineScore, std::vector<BitMove>(_pvTable[0], _pvTable[0] + _pvLength[0]) });
+            _rootExcluded.push_back(_pvTable[0][0]);
+        }
+        _rootExcluded.clear();
+        // an iteration that was cut off part way through can't be trusted
+        if(_stop) {
+            break;
+        }
+        result.score = score;
+        result.depth = depth;
+        if(!lines.empty()) {
+            result.bestMove = lines[0].pv[0];
+            result.pv = lines[0].pv;
+        }
+        if(lineCount > 1) {
+            result.lines = std::move(lines);
+        }
+        result.nodes = _nodes;
+        result.timeMs = (int)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _searchStart).count();
+        if(onIteration) {
+            onIteration(result);
+            if(_stop) {
+                break;
+            }
+        }
+        // a forced mate found at this depth won't get any shorter, though the other lines might still change
+        if(lineCount == 1 && std::abs(score) > MATE_SCORE - MAX_PLY && MATE_SCORE - std::abs(score) <= depth) {
+            break;
+        }
+        // the next iteration takes several times longer than this one, so don't start it
+        int softTimeMs = limits.softTimeMs ? limits.softTimeMs : limits.timeMs / 2;
+        if(softTimeMs && result.timeMs > softTimeMs) {
+            break;
+        }
+    }
+    result.nodes = _nodes;
+    result.timeMs = (int)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _searchStart).count();
+    return result;
+}
+
+int ChessEngine::negamax(int depth, int ply, int alpha, int beta)
+{
+    _pvLength[ply] = 0;
+    if(checkLimits()) {
+        return 0;
+    }
+    _nodes++;
+
+    if(ply > 0) {
+        if(_halfMoveClock >= 100 || isRepetition() || insufficientMaterial()) {
+            return 0;
+        }
+        // nothing from here can beat a mate already found closer to the root
+        alpha = std::max(alpha, -MATE_SCORE + ply);
+        beta = std::min(beta, MATE_SCORE - ply - 1);
+        if(alpha >= beta) {
+            return alpha;
+        }
+        int endgameScore;
+        if(probeEndgame(endgameScore)) {
+            return endgameScore;
+        }
+    }
+    if(ply >= MAX_PLY - 1) {
+        return evaluate() * _sideToMove;
+    }
+
+    bool check = inCheck();
+    if(check) {
+        depth++;
+    }
+    if(depth <= 0) {
+        return quiesce(ply, alpha, beta);
+    }
+
+    BitMove ttMove;
+    if(TTEntry* entry = probeTT(_hash)) {
+        ttMove = entry->move;
+        if(ply > 0 && entry->depth >= depth) {
+            int score = entry->score;
+            if(score > MATE_SCORE - MAX_PLY) score -= ply;
+            else if(score < -MATE_SCORE + MAX_PLY) score += ply;
+            if(entry->bound == BoundExact ||
+               (entry->bound == BoundLower && score >= beta) ||
+               (entry->bound == BoundUpper && score <= alpha)) {
+                return score;
+            }
+        }
+    }
+
+    auto moves = generateAllMoves();
+    if(moves.empty()) {
+        return check ? -MATE_SCORE + ply : 0;
+    }
+    orderMoves(moves, ttMove, ply);
+
+    int bestVal = -INFINITE_SCORE;
+    BitMove bestMove;
+    int bound = BoundUpper;
+    bool first = true;
+    for(const auto& move : moves) {
+        if(ply == 0 && std::find(_rootExcluded.begin(), _rootExcluded.end(), move) != _rootExcluded.end()) {
+            continue;
+        }
+        makeMove(move);
+        int score;
+        if(first) {
+            score = -negamax(depth - 1, ply + 1, -beta, -alpha);
+        } else {
+            // principal variation search: try to prove the move is no better with a null window
+            score = -negamax(depth - 1, ply + 1, -alpha - 1, -alpha);
+            if(score > alpha && score < beta) {
+                score = -negamax(depth - 1, ply + 1, -beta, -alpha);
+            }
+        }
+        unmakeMove();
+        if(_stop) {
+            return 0;
+        }
+        first = false;
+
+        if(score > bestVal) {
+            bestVal = score;
+            bestMove = move;
+            if(score > alpha) {
+                alpha = score;
+                bound = BoundExact;
+                _pvTable[ply][0] = move;
+                for(int i = 0; i < _pvLength[ply + 1]; i++) {
+                    _pvTable[ply][i + 1] = _pvTable[ply + 1][i];
+                }
+                _pvLength[ply] = _pvLength[ply + 1] + 1;
+            }
+        }
+        if(alpha >= beta) {
+            bound = BoundLower;
+            if(!(move.flags & MoveCapture)) {
+                if(!(move == _killers[ply][0])) {
+                    _killers[ply][1] = _killers[ply][0];
+                    _killers[ply][0] = move;
+                }
+                int& history = _historyScores[_sideToMove == WHITE ? 0 : 1][move.from][move.to];
+                history += depth * depth;
+                if(history >= HISTORY_MAX) {
+                    // ageing keeps the order between moves while an endless analysis can't overflow it
+                    for(auto& color : _historyScores) {
+                        for(auto& from : color) {
+                            for(int& score : from) {
+                                score /= 2;
+                            }
+                        }
+                    }
+                }
+            }
+            break;  // Beta cutoff
+        }
+    }
+
+    // a root searched without some of its moves doesn't have its real score
+    if(ply > 0 || _rootExcluded.empty()) {
+        storeTT(_hash, depth, bestVal, bound, bestMove, ply);
+    }
+    return bestVal;
+}
+
+int ChessEngine::quiesce(int ply, int alpha, int beta)
+{
+    _pvLength[ply] = 0;
+    if(checkLimits()) {
+        return 0;
+    }
+    _nodes++;
+
+    int endgameScore;
+    if(probeEndgame(endgameScore)) {
+        return endgameScore;
+    }
+    // the side to move can usually do at least as well as standing still
+    int standPat = evaluate() * _sideToMove;
+    if(ply >= MAX_PLY - 1 || standPat >= beta) {
+        return standPat;
+    }
+    alpha = std::max(alpha, standPat);
+
+    std::vector<BitMove> moves;
+    generatePseudoMoves(moves, true);
+    filterLegalMoves(moves);
+    orderMoves(moves, BitMove(), MAX_PLY);
+    for(const auto& move : moves) {
+        makeMove(move);
+        int score = -quiesce(ply + 1, -beta, -alpha);
+        unmakeMove();
+        if(_stop) {
+            return 0;
+        }
+        if(score >= beta) {
+            return score;
+        }
+        alpha = std::max(alpha, score);
+    }
+    return alpha;
+}
@@ -0,0 +1,194 @@
+#pragma once
+
+#include "Bitboard.h"
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <functional>
+
+//
+// headless chess position, move generator and search
+// this has no dependency on the Grid, sprites or ImGui so it can be used by
+// offline tools as well as by the Chess game class. every instance owns all of
+// its search state, so separate instances can search on separate threads.
+//
+// squares are indexed 0-63 with a1 = 0, the same layout as Chess::stateString()
+// pieces are stored as state characters: "PNBRQK" for white, "pnbrqk" for black, '0' for empty
+//
+// colors follow the rest of the chess code: 1 is white, -1 is black
+//
+
+// score for delivering mate at the root, mate in n plies scores MATE_SCORE - n
+constexpr int MATE_SCORE = 100000;
+constexpr int MAX_PLY = 128;
+
+enum GameStatus
+{
+    GameOngoing,
+    GameCheckmate,
+    GameStalemate,
+    GameDrawFiftyMove,
+    GameDrawRepetition,
+    GameDrawMaterial
+};
+
+struct SearchLimits
+{
+    int depth = MAX_PLY - 1;
+    uint64_t nodes = 0;         // 0 = no node limit
+    int timeMs = 0;             // 0 = no time limit, the search is abandoned when this runs out
+    int softTimeMs = 0;         // don't start another iteration after this, 0 = half of timeMs
+    int multiPV = 1;            // number of best root moves to report a line for
+    // stops the search once set. unlike stop() the search never clears it, so a
+    // cancellation that comes before the search starts isn't lost
+    const std::atomic<bool>* cancel = nullptr;
+};
+
+struct SearchLine
+{
+    int score = 0;
+    std::vector<BitMove> pv;
+};
+
+struct SearchResult
+{
+    BitMove bestMove;
+    int score = 0;
+    int depth = 0;
+    uint64_t nodes = 0;
+    int timeMs = 0;
+    std::vector<BitMove> pv;
+    // with multiPV > 1, the best lines of the last completed iteration, best first.
+    // the first line is the same as bestMove/score/pv above.
+    std::vector<SearchLine> lines;
+};
+
+class ChessEngine
+{
+public:
+    ChessEngine();
+
+    // load a position from a 64 character state string, with no castling or en passant rights
+    void setStateString(const std::string& state, int playerColor);
+    // load a position from a FEN string, returns false if the placement field is malformed
+    bool setFEN(const std::string& fen);
+    std::string stateString() const { return std::string(_squares, 64); }
+    std::string getFEN() const;
+    // the position of another engine, with the moves that led to it so repetitions
+    // are still seen. the search state (transposition table and so on) is kept.
+    void copyPosition(const ChessEngine& other);
+    static const char* startFEN() { return "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"; }
+
+    char pieceAt(int square) const { return _squares[square]; }
+    int sideToMove() const { return _sideToMove; }
+    uint64_t hash() const { return _hash; }
+    int fullMoveNumber() const { return _fullMoveNumber; }
+    const BitboardElement& bitboard(AllBitBoards board) const { return _bitboards[board]; }
+
+    // static evaluation from white's point of view
+    int evaluate() const;
+    int evaluate(const int* pieceValues) const;
+    // white minus black piece counts, indexed by ChessPiece. evaluate() is the dot
+    // product of these with the piece values, which is what the tuner fits.
+    void evaluationTerms(int terms[7]) const;
+    // override the tuned piece values for this instance (used to match variants against each other)
+    void setPieceValues(const int pieceValues[7]);
+
+    // legal moves for the side to move
+    std::vector<BitMove> generateAllMoves();
+    void makeMove(const BitMove& move);
+    void unmakeMove();
+    bool inCheck() const { return isSquareAttacked(kingSquare(_sideToMove), -_sideToMove); }
+    bool isSquareAttacked(int square, int byColor) const;
+    GameStatus gameStatus();
+    // the same, for callers that already have the legal moves
+    GameStatus gameStatus(const std::vector<BitMove>& legalMoves);
+
+    // move text: coordinate notation ("e2e4", "e7e8q") and standard algebraic notation
+    static std::string moveToString(const BitMove& move);
+    std::string moveToSAN(const BitMove& move);
+    // accepts SAN or coordinate notation, returns false if no legal move matches
+    bool parseMove(const std::string& text, BitMove& move);
+
+    // iterative deepening alpha-beta search of the current position. onIteration is
+    // called once per completed depth, from the searching thread.
+    SearchResult search(const SearchLimits& limits, std::function<void(const SearchResult&)> onIteration = nullptr);
+    // stop a search running on another thread, or from the onIteration callback
+    void stop() { _stop = true; }
+    void clearTranspositionTable();
+    void setTranspositionTableSize(size_t entries);
+
+    static ChessPiece pieceType(char piece);
+
+private:
+    struct UndoState
+    {
+        BitMove move;
+        char captured;
+        int castlingRights;
+        int enPassantSquare;
+        int halfMoveClock;
+        uint64_t hash;
+    };
+
+    struct TTEntry
+    {
+        uint64_t key;
+        BitMove move;
+        int32_t score;
+        int8_t depth;
+        uint8_t bound;
+    };
+
+    void clear();
+    void putPiece(int square, char piece);
+    void removePiece(int square);
+    void movePiece(int from, int to);
+    int kingSquare(int color) const;
+    bool isRepetition() const;
+    bool insufficientMaterial() const;
+    // exact result from an endgame bitbase, from the side to move's point of view
+    bool probeEndgame(int& score) const;
+
+    void generatePseudoMoves(std::vector<BitMove>& moves, bool capturesOnly);
+    void generateKnightMoves(std::vector<BitMove>& moves, BitboardElement knightBoard, uint64_t targets);
+    void generateKingMoves(std::vector<BitMove>& moves, BitboardElement kingBoard, uint64_t targets);
+    void generateSliderMoves(std::vector<BitMove>& moves, BitboardElement board, ChessPiece piece, uint64_t targets);
+    void generatePawnMoves(std::vector<BitMove>& moves, BitboardElement pawnBoard, bool capturesOnly);
+    void generateCastlingMoves(std::vector<BitMove>& moves);
+    void addPawnBitboardMovesToList(std::vector<BitMove>& moves, BitboardElement bitboard, int shift, int flags, bool queenOnly);
+    void filterLegalMoves(std::vector<BitMove>& moves);
+
+    int negamax(int depth, int ply, int alpha, int beta);
+    int quiesce(int ply, int alpha, int beta);
+    void orderMoves(std::vector<BitMove>& moves, const BitMove& ttMove, int ply);
+    bool checkLimits();
+    TTEntry* probeTT(uint64_t key);
+    void storeTT(uint64_t key, int depth, int score, int bound, const BitMove& move, int ply);
+
+    char _squares[64];
+    BitboardElement _bitboards[e_numBitboards];
+    int _sideToMove;
+    int _castlingRights;
+    int _enPassantSquare;
+    int _halfMoveClock;
+    int _fullMoveNumber;
+    uint64_t _hash;
+    std::vector<UndoState> _undo;
+    std::vector<uint64_t> _history;
+    int _pieceValues[7];
+
+    // search state
+    std::vector<TTEntry> _tt;
+    BitMove _killers[MAX_PLY][2];
+    int _historyScores[2][64][64];
+    BitMove _pvTable[MAX_PLY][MAX_PLY];
+    int _pvLength[MAX_PLY];
+    SearchLimits _limits;
+    // multi-PV: root moves already reported this iteration, skipped by the next root search
+    std::vector<BitMove> _rootExcluded;
+    uint64_t _nodes;
+    std::chrono::steady_clock::time_point _searchStart;
+    std::atomic<bool> _stop;
+};
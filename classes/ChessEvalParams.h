@@ -0,0 +1,16 @@
+#pragma once
+
+//
+// evaluation weights for the chess engine
+// this file is written by `enginetool tune` -- rerun the tuner rather than editing by hand
+// the values below are the original hand-picked material scores
+//
+constexpr int kPieceValues[7] = {
+    0,      // NoPiece
+    100,    // Pawn
+    200,    // Knight
+    230,    // Bishop
+    400,    // Rook
+    900,    // Queen
+    2000,   // King (not tuned)
+};
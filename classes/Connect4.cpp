@@ -9,6 +9,7 @@ Connect4::Connect4()
 
 Connect4::~Connect4()
 {
+    stopAI();
     delete _grid;
 }
 
@@ -28,6 +29,10 @@ void Connect4::setUpBoard()
 
     _grid->initializeSquares(80, "square.png");
 
+    if (gameHasAI()) {
+        setAIPlayer(AI_PLAYER);
+    }
+
     startGame();
 }
 
@@ -73,6 +78,38 @@ bool Connect4::actionForEmptyHolder(BitHolder &holder)
     return false;
 }
 
+void Connect4::updateAI()
+{
+    if (!_aiTask) {
+        // the board keeps drawing while the search runs, a later frame plays the move
+        Connect4State state = Connect4State::fromString(stateString(), getCurrentPlayer()->playerNumber());
+        GameSearchLimits limits;
+        limits.timeMs = 1000;
+        _aiDone = false;
+        _aiTask = std::make_unique<TaskGroup>(ThreadPool::shared(), TaskInteractive);
+        limits.cancel = _aiTask->token().flag();
+        _aiTask->run([this, state, limits]() mutable {
+            _aiResult = _search.run(state, limits);
+            _aiDone = true;
+        });
+        return;
+    }
+    if (!_aiDone) return;
+
+    _aiTask.reset();
+    if (_aiResult.found) {
+        actionForEmptyHolder(*_grid->getSquare(_aiResult.bestMove, 0));
+    }
+}
+
+void Connect4::stopAI()
+{
+    if (_aiTask) {
+        _aiTask->cancel();
+        _aiTask.reset();
+    }
+}
+
 int Connect4::getLowestEmptyRow(int col)
 {
     for (int row = CONNECT4_ROWS - 1; row >= 0; row--) {
@@ -102,6 +139,7 @@ bool Connect4::canBitMoveFromTo(Bit &bit, BitHolder &src, BitHolder &dst)
 
 void Connect4::stopGame()
 {
+    stopAI();
     _grid->forEachSquare([](ChessSquare* square, int x, int y) {
         square->destroyBit();
     });
@@ -2,6 +2,10 @@
 
 #include "Game.h"
 #include "Grid.h"
+#include "Connect4State.h"
+#include "ThreadPool.h"
+#include <memory>
+#include <atomic>
 
 const int CONNECT4_COLS = 7;
 const int CONNECT4_ROWS = 6;
@@ -27,6 +31,8 @@ public:
     std::string stateString() override;
     void setStateString(const std::string &s) override;
 
+    void updateAI() override;
+    bool gameHasAI() override { return true; }
     Grid* getGrid() override { return _grid; }
 
 private:
@@ -35,6 +41,13 @@ private:
     bool isColumnFull(int col);
     Player* ownerAt(int x, int y) const;
     bool checkDirection(int startX, int startY, int dx, int dy, Player* player);
+    // cancels a search in progress and waits for its task
+    void stopAI();
 
     Grid* _grid;
+    // the AI searches a copy of the position as an interactive task on the shared pool
+    Search<Connect4State> _search;
+    std::unique_ptr<TaskGroup> _aiTask;
+    std::atomic<bool> _aiDone{false};
+    GameSearchResult<int> _aiResult;
 };
\ No newline at end of file
@@ -0,0 +1,149 @@
+#pragma once
+
+#include "Search.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+//
+// compact Connect 4 position for the AI, without any sprites. it works with both
+// the alpha-beta search in Search.h and the MCTS in MCTS.h.
+// rows are numbered from the top like the Grid, players are 0 and 1
+//
+struct Connect4State
+{
+    typedef int Move;       // a column
+
+    static const int Columns = 7;
+    static const int Rows = 6;
+
+    uint8_t cells[Rows][Columns] = {};      // 0 empty, otherwise player + 1
+    int8_t top[Columns];                    // the row a piece dropped in the column lands on, -1 when full
+    int toMove = 0;
+    int winner = -1;
+    int pieces = 0;
+    uint64_t key = 0;
+
+    Connect4State()
+    {
+        for(auto& row : top) {
+            row = Rows - 1;
+        }
+    }
+
+    // from Connect4::stateString(): row by row from the top, '1'/'2' for players 0/1
+    static Connect4State fromString(const std::string& state, int playerToMove)
+    {
+        Connect4State position;
+        position.toMove = playerToMove;
+        position.key = playerToMove ? sideKey() : 0;
+        for(int x = 0; x < Columns; x++) {
+            position.top[x] = -1;
+            for(int y = Rows - 1; y >= 0; y--) {
+                char cell = state[y * Columns + x];
+                if(cell == '0') {
+                    if(position.top[x] < 0) {
+                        position.top[x] = (int8_t)y;
+                    }
+                    continue;
+                }
+                position.cells[y][x] = (uint8_t)(cell - '0');
+                position.key ^= cellKey(cell - '1', y, x);
+                position.pieces++;
+            }
+        }
+        return position;
+    }
+
+    int sideToMove() const { return toMove; }
+    uint64_t hash() const { return key; }
+    int result(int player) const { return winner < 0 ? 1 : winner == player ? 2 : 0; }
+
+    void generate(std::vector<Move>& moves) const
+    {
+        if(winner >= 0) {
+            return;
+        }
+        // centre columns first, they take part in the most lines
+        static const int order[Columns] = { 3, 2, 4, 1, 5, 0, 6 };
+        for(int x : order) {
+            if(top[x] >= 0) {
+                moves.push_back(x);
+            }
+        }
+    }
+
+    void make(const Move& column)
+    {
+        int row = top[column]--;
+        cells[row][column] = (uint8_t)(toMove + 1);
+        key ^= cellKey(toMove, row, column) ^ sideKey();
+        pieces++;
+        // only lines through the new piece can have been completed
+        static const int directions[4][2] = { { 1, 0 }, { 0, 1 }, { 1, 1 }, { 1, -1 } };
+        for(const auto& direction : directions) {
+            int count = 1 + runLength(row, column, direction[0], direction[1]) + runLength(row, column, -direction[0], -direction[1]);
+            if(count >= 4) {
+                winner = toMove;
+                break;
+            }
+        }
+        toMove ^= 1;
+    }
+
+    void unmake(const Move& column)
+    {
+        int row = ++top[column];
+        toMove ^= 1;
+        cells[row][column] = 0;
+        key ^= cellKey(toMove, row, column) ^ sideKey();
+        pieces--;
+        winner = -1;
+    }
+
+    // counts the lines of four that only one player has pieces in, more pieces count more
+    int evaluate() const
+    {
+        if(winner >= 0) {
+            return winner == toMove ? kSearchWin : -kSearchWin;
+        }
+        if(pieces == Rows * Columns) {
+            return 0;
+        }
+        static const int weights[5] = { 0, 1, 5, 50, 0 };
+        static const int directions[4][2] = { { 1, 0 }, { 0, 1 }, { 1, 1 }, { 1, -1 } };
+        int score = 0;
+        for(int y = 0; y < Rows; y++) {
+            for(int x = 0; x < Columns; x++) {
+                for(const auto& direction : directions) {
+                    int endX = x + 3 * direction[0];
+                    int endY = y + 3 * direction[1];
+                    if(endX >= Columns || endY < 0 || endY >= Rows) {
+                        continue;
+                    }
+                    int counts[3] = { 0, 0, 0 };
+                    for(int i = 0; i < 4; i++) {
+                        counts[cells[y + i * direction[1]][x + i * direction[0]]]++;
+                    }
+                    if(!counts[2]) score += weights[counts[1]];
+                    else if(!counts[1]) score -= weights[counts[2]];
+                }
+            }
+        }
+        return toMove == 0 ? score : -score;
+    }
+
+private:
+    static uint64_t cellKey(int player, int row, int column) { return zobristKey((player * Rows + row) * Columns + column); }
+    static uint64_t sideKey() { return zobristKey(2 * Rows * Columns); }
+
+    int runLength(int row, int column, int dx, int dy) const
+    {
+        int count = 0;
+        uint8_t piece = cells[row][column];
+        for(int x = column + dx, y = row + dy; x >= 0 && x < Columns && y >= 0 && y < Rows && cells[y][x] == piece; x += dx, y += dy) {
+            count++;
+        }
+        return count;
+    }
+};
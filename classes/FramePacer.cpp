@@ -0,0 +1,112 @@
+#include "FramePacer.h"
+#include <chrono>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+// frames drawn at the full rate after input
+constexpr int kSettleFrames = 3;
+// a wait that ends this much before its timeout was ended by input
+constexpr double kWakeSlack = 0.002;
+// how much time the rates are averaged over
+constexpr double kSampleSeconds = 2.0;
+
+FramePacer::FramePacer()
+{
+    _activity = FrameAnimating;
+    // the first frames lay out the windows
+    _settleFrames = kSettleFrames;
+    _waitStart = wallSeconds();
+    _waitTimeout = 0;
+    _lastWall = _waitStart;
+    _lastCpu = cpuSeconds();
+    _framesPerSecond = 0;
+    _cpuPercent = 0;
+    _idleCpuPercent = 0;
+}
+
+double FramePacer::wallSeconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+double FramePacer::cpuSeconds()
+{
+#ifdef _WIN32
+    FILETIME created, exited, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user)) {
+        return 0;
+    }
+    ULARGE_INTEGER kernelTime, userTime;
+    kernelTime.LowPart = kernel.dwLowDateTime;
+    kernelTime.HighPart = kernel.dwHighDateTime;
+    userTime.LowPart = user.dwLowDateTime;
+    userTime.HighPart = user.dwHighDateTime;
+    // in 100ns units
+    return (double)(kernelTime.QuadPart + userTime.QuadPart) * 1e-7;
+#else
+    timespec time;
+    if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time) != 0) {
+        return 0;
+    }
+    return (double)time.tv_sec + (double)time.tv_nsec * 1e-9;
+#endif
+}
+
+void FramePacer::beginFrame()
+{
+    double waited = wallSeconds() - _waitStart;
+    if (_waitTimeout > 0 && waited < _waitTimeout - kWakeSlack) {
+        _settleFrames = kSettleFrames;
+    }
+}
+
+void FramePacer::endFrame(FrameActivity activity)
+{
+    // the time since the last frame was spent waiting as that frame decided, then on this one
+    bool idle = _activity == FrameIdle && _settleFrames == 0;
+    double wall = wallSeconds();
+    double cpu = cpuSeconds();
+    double framesPerSecond;
+    accumulate(_all, wall - _lastWall, cpu - _lastCpu, _cpuPercent, _framesPerSecond);
+    if (idle) {
+        accumulate(_idle, wall - _lastWall, cpu - _lastCpu, _idleCpuPercent, framesPerSecond);
+    }
+    _lastWall = wall;
+    _lastCpu = cpu;
+
+    _activity = activity;
+    if (_settleFrames > 0) {
+        _settleFrames--;
+    }
+    _waitStart = wall;
+    _waitTimeout = timeout();
+}
+
+double FramePacer::timeout() const
+{
+    if (!_pacing.onDemand || _settleFrames > 0 || _activity == FrameAnimating) {
+        return 0;
+    }
+    int fps = _activity == FrameWaiting ? _pacing.waitingFps : _pacing.idleFps;
+    return 1.0 / (fps > 0 ? fps : 1);
+}
+
+bool FramePacer::accumulate(Sample &sample, double wall, double cpu, double &cpuPercent, double &framesPerSecond)
+{
+    sample.wall += wall;
+    sample.cpu += cpu;
+    sample.frames++;
+    if (sample.wall < kSampleSeconds) {
+        return false;
+    }
+    cpuPercent = 100.0 * sample.cpu / sample.wall;
+    framesPerSecond = sample.frames / sample.wall;
+    sample = Sample();
+    return true;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+//
+// decides when the main loop draws the next frame
+//
+// redrawing a board that hasn't changed at the display's refresh rate keeps a core
+// busy for nothing. instead the main loop asks timeout() how long it may block waiting
+// for input, and a frame is drawn when input arrives or the time runs out:
+//   animating   pieces are moving, flipping or being dragged, every frame
+//   waiting     something will change without input (the AI is thinking, an
+//               analysis or review is running), waitingFps frames a second
+//   idle        nothing to show until there is input, idleFps frames a second so
+//               clocks still tick
+// a few frames follow any input at the full rate so ImGui can settle its hover and
+// click states.
+//
+// the process CPU time is sampled every frame and reported separately for the idle
+// periods, which is what an unattended machine spends.
+//
+
+enum FrameActivity
+{
+    FrameIdle,
+    FrameWaiting,
+    FrameAnimating
+};
+
+struct FramePacing
+{
+    bool onDemand = true;           // false draws every frame, as before
+    int waitingFps = 30;
+    int idleFps = 2;
+};
+
+class FramePacer
+{
+public:
+    FramePacer();
+
+    FramePacing &pacing() { return _pacing; }
+
+    // at the start of a frame, once the events are in
+    void beginFrame();
+    // at the end of a frame, with what it showed
+    void endFrame(FrameActivity activity);
+    // seconds the main loop may wait for input before the next frame, 0 to draw now
+    double timeout() const;
+
+    // measured over the last couple of seconds
+    double framesPerSecond() const { return _framesPerSecond; }
+    // CPU time over wall time, in percent of one core. the whole process is counted,
+    // worker threads included.
+    double cpuPercent() const { return _cpuPercent; }
+    double idleCpuPercent() const { return _idleCpuPercent; }
+
+private:
+    struct Sample
+    {
+        double wall = 0;
+        double cpu = 0;
+        int frames = 0;
+    };
+
+    static double wallSeconds();
+    static double cpuSeconds();
+    // adds to the sample and reports its rates once it covers enough time
+    static bool accumulate(Sample &sample, double wall, double cpu, double &cpuPercent, double &framesPerSecond);
+
+    FramePacing _pacing;
+    FrameActivity _activity;
+    int _settleFrames;
+    double _waitStart;
+    double _waitTimeout;
+
+    double _lastWall;
+    double _lastCpu;
+    Sample _all;
+    Sample _idle;
+    double _framesPerSecond;
+    double _cpuPercent;
+    double _idleCpuPercent;
+};
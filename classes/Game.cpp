@@ -2,6 +2,7 @@
 #include "Bit.h"
 #include "BitHolder.h"
 #include "Turn.h"
+#include "RenderList.h"
 #include "../Application.h"
 
 Game::Game()
@@ -28,6 +29,7 @@ Game::Game()
 	_dragStartPos = ImVec2(0, 0);
 	_dragOffset = ImVec2(0, 0);
 	_oldPos = ImVec2(0, 0);
+	_animating = false;
 }
 
 Game::~Game()
@@ -180,36 +182,32 @@ void Game::drawFrame()
 	scanForMouse();
 
 	Grid* grid = getGrid();
+	RenderList& renderList = RenderList::shared();
 
-	// Paint squares
-	grid->forEachEnabledSquare([](ChessSquare* square, int x, int y) {
-		square->paintSprite();
-	});
+	// only the bits that are moving or flipping get updated
+	renderList.update();
 
-	// Paint stationary pieces
-	grid->forEachEnabledSquare([](ChessSquare* square, int x, int y) {
-		if (square->bit() && !square->bit()->getPickedUp() && !square->bit()->getMoving())
-		{
-			square->bit()->paintSprite();
-		}
-	});
-
-	// Paint moving pieces
-	grid->forEachEnabledSquare([](ChessSquare* square, int x, int y) {
-		if (square->bit() && square->bit()->getMoving() && !square->bit()->getPickedUp())
-		{
-			square->bit()->update();
-			square->bit()->paintSprite();
-		}
+	// the board, then the bits in their Z order (see RenderList), each layer goes to the
+	// window's draw list as one batch
+	grid->forEachEnabledSquare([this](ChessSquare* square, int x, int y) {
+		_layers[BoardLayer].add(*square);
 	});
+	for (Bit* bit : renderList.bits())
+	{
+		_layers[PieceLayer].add(*bit);
+	}
+	_animating = renderList.animating() || _dragBit != nullptr;
 
-	// Paint picked up pieces
-	grid->forEachEnabledSquare([](ChessSquare* square, int x, int y) {
-		if (square->bit() && square->bit()->getPickedUp())
-		{
-			square->bit()->paintSprite();
-		}
-	});
+	ImVec2 extent(0, 0);
+	for (SpriteBatch& layer : _layers)
+	{
+		layer.flush();
+		ImVec2 layerExtent = layer.takeExtent();
+		extent = ImVec2(std::max(extent.x, layerExtent.x), std::max(extent.y, layerExtent.y));
+	}
+	// the draw list doesn't tell the window how big its contents are, this does
+	ImGui::SetCursorPos(ImVec2(0, 0));
+	ImGui::Dummy(extent);
 }
 
 void Game::bitMovedFromTo(Bit &bit, BitHolder &src, BitHolder &dst)
@@ -22,6 +22,7 @@
 #include "Bit.h"
 #include "BitHolder.h"
 #include "Grid.h"
+#include "SpriteBatch.h"
 
 
 const int AI_PLAYER = 1;
@@ -106,6 +107,9 @@ public:
 	virtual int getAIDepathSearches() { return _gameOptions.AIDepthSearches; };
 	virtual int getAIMAXDepth() { return _gameOptions.AIMAXDepth; };
 
+	// whether the last drawFrame had pieces moving, flipping or picked up
+	bool animating() const { return _animating; }
+
 	// mouse functions
 	void scanForMouse();
 	// grid access - replaces getHolderAt
@@ -151,4 +155,15 @@ protected:
 	BitHolder *_dropTarget;
 	BitHolder *_oldHolder;
 	bool _dragMoved;
+
+	// drawFrame's layers, kept between frames so their buffers are reused. the pieces
+	// come from the render list already in Z order, moving and picked up ones last.
+	enum DrawLayer
+	{
+		BoardLayer,
+		PieceLayer,
+		DrawLayerCount
+	};
+	SpriteBatch _layers[DrawLayerCount];
+	bool _animating;
 };
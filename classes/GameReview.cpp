@@ -0,0 +1,168 @@
+#include "GameReview.h"
+#include <memory>
+#include <algorithm>
+#include <cstdio>
+
+// evaluation drops, in centipawns for the side that moved
+constexpr int kInaccuracyLoss = 70;
+constexpr int kMistakeLoss = 150;
+constexpr int kBlunderLoss = 300;
+// beyond this both sides are clearly winning or losing, so drops are clamped to it
+constexpr int kDecidedScore = 1000;
+
+GameReview::~GameReview()
+{
+    cancel();
+}
+
+int GameReview::start(const std::string& startFEN, const std::vector<std::string>& moves, int depth)
+{
+    cancel();
+    int generation = ++_generation;
+
+    // replay the game once up front, the workers only need the FEN of their position
+    ChessEngine game;
+    _fens.clear();
+    _moves.clear();
+    _sideToMove.clear();
+    if(!game.setFEN(startFEN)) {
+        return generation;
+    }
+    _fens.push_back(game.getFEN());
+    _sideToMove.push_back(game.sideToMove());
+    for(const auto& text : moves) {
+        BitMove move;
+        if(!game.parseMove(text, move)) {
+            break;
+        }
+        _moves.push_back(game.moveToSAN(move));
+        game.makeMove(move);
+        _fens.push_back(game.getFEN());
+        _sideToMove.push_back(game.sideToMove());
+    }
+
+    _positions.assign(_fens.size(), ReviewedPosition());
+    _depth = depth;
+    _next = 0;
+    _remaining = (int)_fens.size();
+    // one short task per position rather than a loop per thread, the pool caps how many
+    // background tasks run at once and keeps a worker free for the AI
+    _workers = std::make_unique<TaskGroup>(ThreadPool::shared(), TaskBackground);
+    for(size_t i = 0; i < _fens.size(); i++) {
+        _workers->run([this, generation]() { reviewNext(generation); });
+    }
+    return generation;
+}
+
+void GameReview::cancel()
+{
+    if(_workers) {
+        // the token stops a search that hasn't started yet, stop() the ones in progress
+        _workers->cancel();
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            for(auto& engine : _engines) {
+                engine->stop();
+            }
+        }
+        _workers->wait();
+        _workers.reset();
+    }
+    _generation++;
+    std::lock_guard<std::mutex> lock(_mutex);
+    _engines.clear();
+    _idleEngines.clear();
+    _fens.clear();
+    _moves.clear();
+    _sideToMove.clear();
+    _positions.clear();
+    _remaining = 0;
+}
+
+void GameReview::reviewNext(int generation)
+{
+    // tasks take positions in game order, whichever order the pool runs them in
+    size_t index = _next++;
+    if(index >= _fens.size()) {
+        return;
+    }
+    ChessEngine* engine;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if(_idleEngines.empty()) {
+            _engines.push_back(std::make_unique<ChessEngine>());
+            _idleEngines.push_back(_engines.back().get());
+        }
+        engine = _idleEngines.back();
+        _idleEngines.pop_back();
+    }
+
+    SearchLimits limits;
+    limits.depth = _depth;
+    limits.cancel = _workers->token().flag();
+    engine->setFEN(_fens[index]);
+    ReviewedPosition result;
+    result.done = true;
+    GameStatus status = engine->gameStatus();
+    if(status == GameCheckmate) {
+        result.score = -MATE_SCORE * engine->sideToMove();
+    } else if(status == GameOngoing) {
+        SearchResult search = engine->search(limits);
+        result.score = search.score * engine->sideToMove();
+        result.depth = search.depth;
+        result.bestMove = engine->moveToSAN(search.bestMove);
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _idleEngines.push_back(engine);
+    if(generation != _generation || _workers->token().cancelled()) {
+        // a cut short search, its score means nothing
+        return;
+    }
+    _positions[index] = result;
+    _remaining--;
+}
+
+std::vector<ReviewedPosition> GameReview::positions() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _positions;
+}
+
+bool GameReview::judgeMove(int index, ReviewedMove& result) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if(index < 0 || index + 1 >= (int)_positions.size() || !_positions[index].done || !_positions[index + 1].done) {
+        return false;
+    }
+    const ReviewedPosition& before = _positions[index];
+    const ReviewedPosition& after = _positions[index + 1];
+    int mover = _sideToMove[index];
+    int scoreBefore = std::clamp(before.score * mover, -kDecidedScore, kDecidedScore);
+    int scoreAfter = std::clamp(after.score * mover, -kDecidedScore, kDecidedScore);
+
+    result = ReviewedMove();
+    result.move = _moves[index];
+    result.loss = std::max(0, scoreBefore - scoreAfter);
+    if(result.move == before.bestMove) {
+        // the engine's own choice can only look worse because the second search saw further
+        result.loss = 0;
+    }
+    const char* label = nullptr;
+    if(result.loss >= kBlunderLoss) {
+        result.judgement = JudgementBlunder;
+        label = "blunder";
+    } else if(result.loss >= kMistakeLoss) {
+        result.judgement = JudgementMistake;
+        label = "mistake";
+    } else if(result.loss >= kInaccuracyLoss) {
+        result.judgement = JudgementInaccuracy;
+        label = "inaccuracy";
+    }
+    if(label) {
+        char text[96];
+        std::snprintf(text, sizeof(text), "%s (-%.2f), best was %s", label, result.loss / 100.0, before.bestMove.c_str());
+        result.comment = text;
+    }
+    return true;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "ChessEngine.h"
+#include "ThreadPool.h"
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <string>
+
+//
+// post-game review
+//
+// every position of a finished game is searched to a fixed depth by a background task
+// of its own on the shared thread pool. results come back one position at a
+// time, so a UI can show them as they arrive instead of waiting for the whole game.
+//
+// a move is judged by how much the evaluation drops from the mover's point of view
+// between the position before it and the position after it.
+//
+
+enum MoveJudgement
+{
+    JudgementNone,
+    JudgementInaccuracy,    // ?!
+    JudgementMistake,       // ?
+    JudgementBlunder        // ??
+};
+
+struct ReviewedPosition
+{
+    bool done = false;
+    int score = 0;              // centipawns from white's point of view
+    int depth = 0;
+    std::string bestMove;       // SAN, empty for a finished game
+};
+
+struct ReviewedMove
+{
+    std::string move;           // SAN of the move played
+    MoveJudgement judgement = JudgementNone;
+    int loss = 0;               // centipawns the mover gave away
+    std::string comment;
+};
+
+class GameReview
+{
+public:
+    GameReview() = default;
+    ~GameReview();
+
+    // review the game starting at startFEN with the given SAN moves. positions are
+    // handed out in order so the start of the game fills in first. returns the review's
+    // generation, results are only ever for the generation that is current.
+    int start(const std::string& startFEN, const std::vector<std::string>& moves, int depth);
+    // stops the searches in progress and forgets the game, positionCount() is 0 afterwards
+    void cancel();
+    // goes up with every start and cancel, so a caller can tell its review from a later one
+    int generation() const { return _generation; }
+
+    bool running() const { return _remaining > 0; }
+    int positionCount() const { return (int)_fens.size(); }
+    int completedCount() const { return positionCount() - _remaining; }
+
+    // snapshot of the results so far, position i is the one before move i
+    std::vector<ReviewedPosition> positions() const;
+    // judgement of move i, once both positions around it are done
+    bool judgeMove(int index, ReviewedMove& result) const;
+
+private:
+    // one task: searches the next position not yet taken
+    void reviewNext(int generation);
+
+    std::vector<std::string> _fens;
+    std::vector<std::string> _moves;
+    std::vector<int> _sideToMove;
+    std::vector<ReviewedPosition> _positions;
+    int _depth = 0;
+    std::atomic<int> _generation{0};
+
+    // engines are made as tasks need them and reused by later tasks, kept here so
+    // cancel() can stop their searches
+    std::vector<std::unique_ptr<ChessEngine>> _engines;
+    std::vector<ChessEngine*> _idleEngines;
+    std::unique_ptr<TaskGroup> _workers;
+    mutable std::mutex _mutex;
+    std::atomic<size_t> _next{0};
+    std::atomic<int> _remaining{0};
+};
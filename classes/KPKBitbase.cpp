@@ -0,0 +1,226 @@
+#include "KPKBitbase.h"
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <cstdlib>
+#include <algorithm>
+
+constexpr int KPK_POSITIONS = 2 * 24 * 64 * 64;
+
+enum KPKResult : uint8_t
+{
+    KPKUnknown,
+    KPKInvalid,
+    KPKDraw,
+    KPKWin
+};
+
+static std::vector<uint64_t> kpkWins;
+static KPKStats kpkStats;
+static std::once_flag kpkInitFlag;
+
+static const int kKingSteps[8] = { -9, -8, -7, -1, 1, 7, 8, 9 };
+
+static int distance(int a, int b)
+{
+    return std::max(std::abs(a % 8 - b % 8), std::abs(a / 8 - b / 8));
+}
+
+// the square a king step lands on, or -1 if it leaves the board
+static int kingStep(int square, int step)
+{
+    int to = square + step;
+    if(to < 0 || to > 63 || distance(square, to) != 1) {
+        return -1;
+    }
+    return to;
+}
+
+static bool pawnAttacks(int pawn, int square)
+{
+    return (pawn % 8 > 0 && square == pawn + 7) || (pawn % 8 < 7 && square == pawn + 9);
+}
+
+// the pawn is white and on files a-d, ranks 2-7
+static int kpkIndex(int strongToMove, int strongKing, int weakKing, int pawn)
+{
+    int pawnIndex = (pawn / 8 - 1) * 4 + pawn % 8;
+    return ((strongToMove * 24 + pawnIndex) * 64 + strongKing) * 64 + weakKing;
+}
+
+// positions that are illegal, or decided without looking at any successor
+static KPKResult initialResult(int strongToMove, int strongKing, int weakKing, int pawn)
+{
+    if(strongKing == weakKing || strongKing == pawn || weakKing == pawn || distance(strongKing, weakKing) <= 1) {
+        return KPKInvalid;
+    }
+    if(strongToMove) {
+        if(pawnAttacks(pawn, weakKing)) {
+            return KPKInvalid;
+        }
+        // the pawn queens and the defending king can't take the queen
+        int queening = pawn + 8;
+        if(pawn / 8 == 6 && queening != strongKing && queening != weakKing &&
+           (distance(weakKing, queening) > 1 || distance(strongKing, queening) == 1)) {
+            return KPKWin;
+        }
+        return KPKUnknown;
+    }
+
+    bool canMove = false;
+    for(int step : kKingSteps) {
+        int to = kingStep(weakKing, step);
+        if(to < 0 || distance(to, strongKing) <= 1 || pawnAttacks(pawn, to)) {
+            continue;
+        }
+        if(to == pawn) {
+            // the pawn is undefended
+            return KPKDraw;
+        }
+        canMove = true;
+    }
+    if(!canMove) {
+        return pawnAttacks(pawn, weakKing) ? KPKWin : KPKDraw;
+    }
+    return KPKUnknown;
+}
+
+//
+// one pass over an undecided position. the side with the pawn wins if any move
+// wins, the defender draws if any move draws. a position where every move has been
+// decided the other way is decided too.
+//
+static KPKResult resolve(const std::vector<uint8_t>& table, int strongToMove, int strongKing, int weakKing, int pawn)
+{
+    bool allDecided = true;
+    auto consider = [&](int index, KPKResult good) {
+        uint8_t result = table[index];
+        if(result == good) {
+            return true;
+        }
+        if(result == KPKUnknown) {
+            allDecided = false;
+        }
+        return false;
+    };
+
+    if(strongToMove) {
+        for(int step : kKingSteps) {
+            int to = kingStep(strongKing, step);
+            if(to < 0 || to == pawn || distance(to, weakKing) <= 1) {
+                continue;
+            }
+            if(consider(kpkIndex(0, to, weakKing, pawn), KPKWin)) {
+                return KPKWin;
+            }
+        }
+        // promotion was already scored by initialResult, so only pawn moves that stay a pawn are left
+        int push = pawn + 8;
+        if(pawn / 8 < 6 && push != strongKing && push != weakKing) {
+            if(consider(kpkIndex(0, strongKing, weakKing, push), KPKWin)) {
+                return KPKWin;
+            }
+            int doublePush = pawn + 16;
+            if(pawn / 8 == 1 && doublePush != strongKing && doublePush != weakKing &&
+               consider(kpkIndex(0, strongKing, weakKing, doublePush), KPKWin)) {
+                return KPKWin;
+            }
+        }
+        return allDecided ? KPKDraw : KPKUnknown;
+    }
+
+    for(int step : kKingSteps) {
+        int to = kingStep(weakKing, step);
+        if(to < 0 || distance(to, strongKing) <= 1 || pawnAttacks(pawn, to)) {
+            continue;
+        }
+        if(consider(kpkIndex(1, strongKing, to, pawn), KPKDraw)) {
+            return KPKDraw;
+        }
+    }
+    return allDecided ? KPKWin : KPKUnknown;
+}
+
+static void buildKPKBitbase()
+{
+    auto start = std::chrono::steady_clock::now();
+    std::vector<uint8_t> table(KPK_POSITIONS, KPKUnknown);
+
+    auto forEachPosition = [](auto&& visit) {
+        for(int strongToMove = 0; strongToMove < 2; strongToMove++) {
+            for(int rank = 1; rank <= 6; rank++) {
+                for(int file = 0; file < 4; file++) {
+                    int pawn = rank * 8 + file;
+                    for(int strongKing = 0; strongKing < 64; strongKing++) {
+                        for(int weakKing = 0; weakKing < 64; weakKing++) {
+                            visit(strongToMove, strongKing, weakKing, pawn);
+                        }
+                    }
+                }
+            }
+        }
+    };
+
+    forEachPosition([&](int strongToMove, int strongKing, int weakKing, int pawn) {
+        table[kpkIndex(strongToMove, strongKing, weakKing, pawn)] = initialResult(strongToMove, strongKing, weakKing, pawn);
+    });
+
+    int iterations = 0;
+    bool changed = true;
+    while(changed) {
+        changed = false;
+        iterations++;
+        forEachPosition([&](int strongToMove, int strongKing, int weakKing, int pawn) {
+            uint8_t& result = table[kpkIndex(strongToMove, strongKing, weakKing, pawn)];
+            if(result == KPKUnknown) {
+                result = resolve(table, strongToMove, strongKing, weakKing, pawn);
+                changed |= result != KPKUnknown;
+            }
+        });
+    }
+
+    // nothing left undecided can be won, the defender just keeps shuffling
+    kpkWins.assign(KPK_POSITIONS / 64, 0);
+    kpkStats = KPKStats();
+    for(int i = 0; i < KPK_POSITIONS; i++) {
+        if(table[i] == KPKWin) {
+            kpkWins[i / 64] |= 1ULL << (i % 64);
+            kpkStats.wins++;
+        } else if(table[i] != KPKInvalid) {
+            kpkStats.draws++;
+        }
+    }
+    kpkStats.iterations = iterations;
+    kpkStats.bytes = kpkWins.size() * sizeof(uint64_t);
+    kpkStats.workBytes = table.size() * sizeof(uint8_t);
+    kpkStats.generationMs = (int)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+void initKPKBitbase()
+{
+    std::call_once(kpkInitFlag, buildKPKBitbase);
+}
+
+bool probeKPK(int strongColor, int strongKing, int strongPawn, int weakKing, int sideToMove)
+{
+    initKPKBitbase();
+    // mirror so the pawn is white and on the queenside
+    if(strongColor != 1) {
+        strongKing ^= 56;
+        strongPawn ^= 56;
+        weakKing ^= 56;
+    }
+    if(strongPawn % 8 > 3) {
+        strongKing ^= 7;
+        strongPawn ^= 7;
+        weakKing ^= 7;
+    }
+    int index = kpkIndex(sideToMove == strongColor ? 1 : 0, strongKing, weakKing, strongPawn);
+    return (kpkWins[index / 64] >> (index % 64)) & 1;
+}
+
+const KPKStats& kpkBitbaseStats()
+{
+    initKPKBitbase();
+    return kpkStats;
+}
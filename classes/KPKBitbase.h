@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+//
+// king and pawn against king bitbase
+//
+// every KPK position is classified as a win for the side with the pawn or a draw.
+// the table is built by retrograde iteration the first time it is needed: positions
+// that are decided outright (the pawn queens safely, the pawn is lost, stalemate)
+// are marked first, then the rest are resolved from their successors, over and over,
+// until a pass changes nothing. whatever is still undecided at that point is a draw.
+//
+// the pawn is normalised to white and to files a-d, which leaves
+// 2 sides to move * 24 pawn squares * 64 * 64 king squares = 196608 positions,
+// one bit each in the finished table.
+//
+
+struct KPKStats
+{
+    int generationMs = 0;
+    int iterations = 0;
+    size_t bytes = 0;           // size of the finished bit array
+    size_t workBytes = 0;       // peak size of the temporary table used while building it
+    int wins = 0;
+    int draws = 0;              // legal positions only
+};
+
+// build the table, only the first call does any work
+void initKPKBitbase();
+
+// squares are a1 = 0, colors are 1 white / -1 black as in ChessEngine.
+// returns true if the side with the pawn wins with best play.
+bool probeKPK(int strongColor, int strongKing, int strongPawn, int weakKing, int sideToMove);
+
+const KPKStats& kpkBitbaseStats();
@@ -0,0 +1,263 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include "ThreadPool.h"
+#include <chrono>
+#include <memory>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+//
+// tree parallel Monte Carlo tree search (UCT)
+//
+// every playout thread walks the same tree. a thread counts its visit on each node
+// on the way down, before the playout result is known, which makes the node look
+// like a loss to the other threads until the result comes back (virtual loss). that
+// spreads the threads over different lines without any locking on the way down.
+// a node is expanded by the first thread to claim it, the others just play out
+// from it in the meantime.
+//
+// nodes come from a pool allocated once and handed out with an atomic counter, so a
+// search doesn't touch the heap. when the pool is full the tree stops growing and
+// the playouts carry on from its leaves.
+//
+// the game is described by a State type with value semantics, using the same names as
+// the positions of the alpha-beta search in Search.h:
+//
+//     typedef ... Move;
+//     void generate(std::vector<Move>& moves) const;  appends, none exactly when the game is over
+//     void make(const Move& move);
+//     int  sideToMove() const;                        0 or 1
+//     int  result(int player) const;                  for a finished game: 2 win, 1 draw, 0 loss
+//
+// a player may move several times in a row (a pass for the other side, a multi-jump),
+// each node remembers who made its move.
+//
+
+struct MCTSLimits
+{
+    int threads = 1;
+    int timeMs = 1000;              // 0 = no time limit
+    uint64_t playouts = 0;          // 0 = no playout limit
+    size_t maxNodes = 1 << 20;
+    float exploration = 1.4f;
+    int maxPlayoutMoves = 1000;     // a playout this long is scored as a draw
+    const std::atomic<bool>* cancel = nullptr;  // stops the search once set, never cleared here
+};
+
+template<typename Move>
+struct MCTSResult
+{
+    Move bestMove{};
+    bool found = false;             // false when the root has no legal moves
+    uint64_t playouts = 0;
+    size_t nodes = 0;
+    int timeMs = 0;
+    double playoutsPerSecond = 0;
+    float winRate = 0;              // of the best move, for the player to move at the root
+};
+
+template<typename State>
+class MCTS
+{
+public:
+    typedef typename State::Move Move;
+
+    MCTSResult<Move> search(const State& root, const MCTSLimits& limits)
+    {
+        MCTSResult<Move> result;
+        std::vector<Move> rootMoves;
+        root.generate(rootMoves);
+        if(rootMoves.empty()) {
+            return result;
+        }
+        result.found = true;
+        result.bestMove = rootMoves[0];
+        if(rootMoves.size() == 1) {
+            return result;
+        }
+
+        // at least room for the root's children. compared after clamping, so a small maxNodes
+        // doesn't reallocate the pool on every search
+        size_t capacity = std::max<size_t>(limits.maxNodes, rootMoves.size() + 1);
+        if(!_nodes || _capacity != capacity) {
+            _capacity = capacity;
+            _nodes.reset(new Node[_capacity]);
+        }
+        _used = 1;
+        _playouts = 0;
+        _stop = false;
+        _nodes[0].reset(Move(), 1 - root.sideToMove());
+        _limits = limits;
+        _start = std::chrono::steady_clock::now();
+
+        // the calling thread plays out too, the others are interactive tasks on the shared pool
+        TaskGroup workers(ThreadPool::shared(), TaskInteractive);
+        for(int t = 1; t < limits.threads; t++) {
+            workers.run([this, &root, t]() { playoutLoop(root, (uint64_t)t); });
+        }
+        playoutLoop(root, 0);
+        workers.wait();
+
+        // the most visited move is the most reliable one
+        const Node& rootNode = _nodes[0];
+        if(rootNode.expansion == Expanded) {
+            int bestVisits = -1;
+            for(uint32_t i = 0; i < rootNode.childCount; i++) {
+                const Node& child = _nodes[rootNode.firstChild + i];
+                if(child.visits > bestVisits) {
+                    bestVisits = child.visits;
+                    result.bestMove = child.move;
+                    result.winRate = child.visits ? child.score / (2.0f * child.visits) : 0.0f;
+                }
+            }
+        }
+        result.playouts = _playouts;
+        result.nodes = std::min(_used.load(), _capacity);
+        result.timeMs = elapsedMs();
+        result.playoutsPerSecond = _playouts * 1000.0 / std::max(1, result.timeMs);
+        return result;
+    }
+
+private:
+    enum Expansion : uint8_t
+    {
+        Unexpanded,
+        Expanding,          // claimed by a thread, or the pool ran out
+        Expanded
+    };
+
+    struct Node
+    {
+        Move move;
+        int8_t player;                      // who made move
+        std::atomic<uint8_t> expansion;
+        std::atomic<uint32_t> firstChild;
+        std::atomic<uint32_t> childCount;
+        std::atomic<int> visits;
+        std::atomic<int64_t> score;         // half points for player
+
+        void reset(const Move& m, int p)
+        {
+            move = m;
+            player = (int8_t)p;
+            expansion = Unexpanded;
+            firstChild = 0;
+            childCount = 0;
+            visits = 0;
+            score = 0;
+        }
+    };
+
+    int elapsedMs() const
+    {
+        return (int)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _start).count();
+    }
+
+    uint32_t selectChild(uint32_t parent) const
+    {
+        const Node& node = _nodes[parent];
+        float logVisits = std::log((float)std::max(1, node.visits.load(std::memory_order_relaxed)));
+        uint32_t best = node.firstChild;
+        float bestValue = -1.0f;
+        for(uint32_t i = 0; i < node.childCount; i++) {
+            const Node& child = _nodes[node.firstChild + i];
+            int visits = child.visits.load(std::memory_order_relaxed);
+            if(visits == 0) {
+                return node.firstChild + i;
+            }
+            float value = child.score.load(std::memory_order_relaxed) / (2.0f * visits) +
+                          _limits.exploration * std::sqrt(logVisits / visits);
+            if(value > bestValue) {
+                bestValue = value;
+                best = node.firstChild + i;
+            }
+        }
+        return best;
+    }
+
+    void playoutLoop(const State& root, uint64_t seed)
+    {
+        uint64_t random = 0x9E3779B97F4A7C15ULL * (seed + 1);
+        auto nextRandom = [&random]() {
+            random ^= random << 13;
+            random ^= random >> 7;
+            random ^= random << 17;
+            return random;
+        };
+        std::vector<uint32_t> path;
+        std::vector<Move> moves;
+
+        while(!_stop) {
+            State state = root;
+            uint32_t node = 0;
+            path.clear();
+            path.push_back(0);
+            _nodes[0].visits++;
+
+            // selection, counting the visits on the way down as virtual losses
+            while(_nodes[node].expansion.load(std::memory_order_acquire) == Expanded) {
+                node = selectChild(node);
+                state.make(_nodes[node].move);
+                path.push_back(node);
+                _nodes[node].visits++;
+            }
+
+            // expansion
+            uint8_t unexpanded = Unexpanded;
+            moves.clear();
+            state.generate(moves);
+            if(!moves.empty() && _nodes[node].expansion.compare_exchange_strong(unexpanded, Expanding)) {
+                size_t first = _used.fetch_add(moves.size());
+                if(first + moves.size() <= _capacity) {
+                    int player = state.sideToMove();
+                    for(size_t i = 0; i < moves.size(); i++) {
+                        _nodes[first + i].reset(moves[i], player);
+                    }
+                    _nodes[node].firstChild = (uint32_t)first;
+                    _nodes[node].childCount = (uint32_t)moves.size();
+                    _nodes[node].expansion.store(Expanded, std::memory_order_release);
+
+                    node = (uint32_t)(first + nextRandom() % moves.size());
+                    state.make(_nodes[node].move);
+                    path.push_back(node);
+                    _nodes[node].visits++;
+                }
+            }
+
+            // simulation
+            bool finished = false;
+            for(int playoutMoves = 0; playoutMoves < _limits.maxPlayoutMoves; playoutMoves++) {
+                moves.clear();
+                state.generate(moves);
+                if(moves.empty()) {
+                    finished = true;
+                    break;
+                }
+                state.make(moves[nextRandom() % moves.size()]);
+            }
+
+            // backpropagation
+            for(uint32_t visited : path) {
+                Node& n = _nodes[visited];
+                n.score.fetch_add(finished ? state.result(n.player) : 1, std::memory_order_relaxed);
+            }
+
+            uint64_t playouts = ++_playouts;
+            if((_limits.playouts && playouts >= _limits.playouts) || (_limits.timeMs && elapsedMs() >= _limits.timeMs) ||
+               (_limits.cancel && *_limits.cancel)) {
+                _stop = true;
+            }
+        }
+    }
+
+    std::unique_ptr<Node[]> _nodes;
+    size_t _capacity = 0;
+    std::atomic<size_t> _used{0};
+    std::atomic<uint64_t> _playouts{0};
+    std::atomic<bool> _stop{false};
+    MCTSLimits _limits;
+    std::chrono::steady_clock::time_point _start;
+};
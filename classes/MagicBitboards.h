@@ -2,6 +2,7 @@
 #define MAGIC_BITBOARDS_H
 
 #include <stdint.h>
+#include <mutex>
 
 // Generate rook attacks for a given square and blocking pieces
 static inline uint64_t ratt(int sq, uint64_t block) {
@@ -262,9 +263,10 @@ const int BAttackSize[64] = {
   64,
 };
 
-// Attack lookup tables
-static uint64_t* RAttacks[64];
-static uint64_t* BAttacks[64];
+// Attack lookup tables, shared by every translation unit and read only once built
+inline uint64_t* RAttacks[64];
+inline uint64_t* BAttacks[64];
+inline std::once_flag MagicInitFlag;
 
 // Magic bitboard shift amounts
 const int RShifts[64] = {
@@ -827,8 +829,8 @@ static inline uint64_t getQueenAttacks(int square, uint64_t occupied) {
     return getRookAttacks(square, occupied) | getBishopAttacks(square, occupied);
 }
 
-// Initialize magic bitboards
-void initMagicBitboards(void) {
+// Internal: fills the attack tables, not thread safe. Call initMagicBitboards instead
+inline void buildMagicBitboards(void) {
     int square, i;
     uint64_t subset, index;
 
@@ -861,12 +863,19 @@ void initMagicBitboards(void) {
     }
 }
 
-// Cleanup magic bitboard tables
-void cleanupMagicBitboards(void) {
+// Initialize magic bitboards, safe to call from any number of threads
+inline void initMagicBitboards(void) {
+    std::call_once(MagicInitFlag, buildMagicBitboards);
+}
+
+// Cleanup magic bitboard tables, only once no thread is using them
+inline void cleanupMagicBitboards(void) {
     int square;
     for (square = 0; square < 64; square++) {
         delete[] RAttacks[square];
         delete[] BAttacks[square];
+        RAttacks[square] = nullptr;
+        BAttacks[square] = nullptr;
     }
 }
 
@@ -0,0 +1,211 @@
+#include "MateSolver.h"
+#include <chrono>
+#include <algorithm>
+
+constexpr uint32_t PN_INFINITY = 1u << 30;
+
+MateSolver::MateSolver(size_t ttEntries)
+{
+    // keep the size a power of two so the index is a mask
+    size_t size = 1;
+    while(size * 2 <= ttEntries) {
+        size *= 2;
+    }
+    _tt.assign(size, Entry());
+    _nodes = 0;
+    _nodeLimit = 0;
+}
+
+uint64_t MateSolver::keyFor(const ChessEngine& position, int plies) const
+{
+    // the same position with a different horizon is a different problem
+    return position.hash() ^ (0x9E3779B97F4A7C15ULL * (uint64_t)(plies + 1));
+}
+
+bool MateSolver::lookup(uint64_t key, uint32_t& phi, uint32_t& delta) const
+{
+    const Entry& entry = _tt[key & (_tt.size() - 1)];
+    if(entry.key != key) {
+        return false;
+    }
+    phi = entry.phi;
+    delta = entry.delta;
+    return true;
+}
+
+void MateSolver::store(uint64_t key, uint32_t phi, uint32_t delta)
+{
+    Entry& entry = _tt[key & (_tt.size() - 1)];
+    entry.key = key;
+    entry.phi = phi;
+    entry.delta = delta;
+}
+
+//
+// expand the node until its phi or delta reaches the threshold, the caller then
+// knows another sibling has become the more promising one
+//
+void MateSolver::mid(ChessEngine& position, int plies, uint32_t thresholdPhi, uint32_t thresholdDelta)
+{
+    uint64_t key = keyFor(position, plies);
+    if(_nodes >= _nodeLimit) {
+        return;
+    }
+    _nodes++;
+
+    bool orNode = (plies & 1) == 1;
+    auto moves = position.generateAllMoves();
+    if(moves.empty()) {
+        // being mated loses for either side, stalemate only loses for the attacker
+        if(position.inCheck() || orNode) {
+            store(key, PN_INFINITY, 0);
+        } else {
+            store(key, 0, PN_INFINITY);
+        }
+        return;
+    }
+    if(plies == 0) {
+        // the defender is still standing after the attacker's last move
+        store(key, 0, PN_INFINITY);
+        return;
+    }
+
+    std::vector<uint64_t> childKeys;
+    childKeys.reserve(moves.size());
+    for(const auto& move : moves) {
+        position.makeMove(move);
+        childKeys.push_back(keyFor(position, plies - 1));
+        position.unmakeMove();
+    }
+
+    while(true) {
+        // phi is the smallest child delta, delta the sum of the child phis
+        uint32_t bestDelta = PN_INFINITY;
+        uint32_t secondDelta = PN_INFINITY;
+        uint32_t bestPhi = PN_INFINITY;
+        uint64_t sumPhi = 0;
+        size_t best = 0;
+        for(size_t i = 0; i < childKeys.size(); i++) {
+            uint32_t childPhi = 1, childDelta = 1;
+            lookup(childKeys[i], childPhi, childDelta);
+            sumPhi = std::min<uint64_t>(PN_INFINITY, sumPhi + childPhi);
+            if(childDelta < bestDelta) {
+                secondDelta = bestDelta;
+                bestDelta = childDelta;
+                bestPhi = childPhi;
+                best = i;
+            } else if(childDelta < secondDelta) {
+                secondDelta = childDelta;
+            }
+        }
+        uint32_t phi = bestDelta;
+        uint32_t delta = (uint32_t)sumPhi;
+        if(phi >= thresholdPhi || delta >= thresholdDelta || _nodes >= _nodeLimit) {
+            store(key, phi, delta);
+            return;
+        }
+        store(key, phi, delta);
+
+        // search the most promising child until it stops being the most promising
+        uint64_t childPhiThreshold = (uint64_t)thresholdDelta + bestPhi - delta;
+        uint32_t childDeltaThreshold = std::min<uint64_t>(thresholdPhi, (uint64_t)secondDelta + 1);
+        position.makeMove(moves[best]);
+        mid(position, plies - 1, (uint32_t)std::min<uint64_t>(PN_INFINITY, childPhiThreshold), childDeltaThreshold);
+        position.unmakeMove();
+    }
+}
+
+//
+// follow the proof down from a proven node. the table may have lost entries to
+// replacement, so any child we can't read is simply solved again.
+//
+bool MateSolver::extractLine(ChessEngine& position, int plies, std::vector<BitMove>& line)
+{
+    auto moves = position.generateAllMoves();
+    if(moves.empty()) {
+        return position.inCheck() && (plies & 1) == 0;
+    }
+    if(plies == 0) {
+        return false;
+    }
+    bool orNode = (plies & 1) == 1;
+
+    auto solved = [&](uint32_t& phi, uint32_t& delta) {
+        uint64_t key = keyFor(position, plies - 1);
+        if(!lookup(key, phi, delta) || (phi != 0 && delta != 0)) {
+            _nodeLimit = std::max(_nodeLimit, _nodes + 1000000);
+            mid(position, plies - 1, PN_INFINITY, PN_INFINITY);
+            if(!lookup(key, phi, delta)) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    const BitMove* chosen = nullptr;
+    for(const auto& move : moves) {
+        position.makeMove(move);
+        uint32_t phi = 0, delta = 0;
+        bool known = solved(phi, delta);
+        if(orNode && known && delta == 0) {
+            // the defender is lost after this move
+            chosen = &move;
+        } else if(!orNode) {
+            if(!known || phi != 0) {
+                position.unmakeMove();
+                return false;
+            }
+            // show the reply that holds out longest: one that isn't mated two plies sooner
+            uint32_t shorterPhi, shorterDelta;
+            if(!chosen || plies < 3 || !lookup(keyFor(position, plies - 3), shorterPhi, shorterDelta) || shorterPhi != 0) {
+                chosen = &move;
+            }
+        }
+        position.unmakeMove();
+        if(orNode && chosen) {
+            break;
+        }
+    }
+    if(!chosen) {
+        return false;
+    }
+    line.push_back(*chosen);
+    position.makeMove(*chosen);
+    bool complete = extractLine(position, plies - 1, line);
+    position.unmakeMove();
+    return complete;
+}
+
+MateResult MateSolver::solve(ChessEngine& position, int maxMoves, uint64_t nodeLimit)
+{
+    auto start = std::chrono::steady_clock::now();
+    std::fill(_tt.begin(), _tt.end(), Entry());
+    _nodes = 0;
+    _nodeLimit = nodeLimit;
+
+    MateResult result;
+    result.status = MateDisproven;
+    for(int moves = 1; moves <= maxMoves; moves++) {
+        int plies = moves * 2 - 1;
+        mid(position, plies, PN_INFINITY, PN_INFINITY);
+        uint32_t phi = PN_INFINITY, delta = 0;
+        lookup(keyFor(position, plies), phi, delta);
+        if(phi == 0) {
+            result.status = MateProven;
+            result.mateIn = moves;
+            result.nodes = _nodes;
+            extractLine(position, plies, result.line);
+            break;
+        }
+        if(delta != 0) {
+            // neither proven nor disproven, so the node budget ran out
+            result.status = MateUnknown;
+            break;
+        }
+    }
+    if(result.status != MateProven) {
+        result.nodes = _nodes;
+    }
+    result.timeMs = (int)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
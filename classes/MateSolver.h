@@ -0,0 +1,65 @@
+#pragma once
+
+#include "ChessEngine.h"
+#include <vector>
+
+//
+// depth-first proof-number (df-pn) search for forced mates
+//
+// unlike the alpha-beta search this doesn't look at every move to a fixed depth,
+// it keeps expanding whichever line is closest to being proven (or disproven), so
+// narrow forcing lines deep in the tree are found quickly.
+//
+// the attacker is the side to move at the root. nodes where the attacker moves are
+// OR nodes (one mating move is enough), nodes where the defender moves are AND nodes
+// (every reply must be mated). proof and disproof numbers are stored from the side
+// to move's point of view as phi/delta:
+//     OR node:  phi = proof number,    delta = disproof number
+//     AND node: phi = disproof number, delta = proof number
+// so phi == 0 means the side to move gets what it wants.
+//
+// the solver has its own transposition table, keyed by position and the number of
+// plies left, so results found with a shorter horizon never leak into a longer one.
+//
+enum MateStatus
+{
+    MateProven,         // mate in mateIn moves or fewer, line holds one forced line
+    MateDisproven,      // no mate within the move limit
+    MateUnknown         // ran out of nodes before deciding
+};
+
+struct MateResult
+{
+    MateStatus status = MateUnknown;
+    int mateIn = 0;
+    std::vector<BitMove> line;
+    uint64_t nodes = 0;
+    int timeMs = 0;
+};
+
+class MateSolver
+{
+public:
+    explicit MateSolver(size_t ttEntries = 1 << 20);
+
+    // look for the shortest mate of at most maxMoves attacker moves, trying 1, 2, ... in turn
+    MateResult solve(ChessEngine& position, int maxMoves, uint64_t nodeLimit);
+
+private:
+    struct Entry
+    {
+        uint64_t key;
+        uint32_t phi;
+        uint32_t delta;
+    };
+
+    void mid(ChessEngine& position, int plies, uint32_t thresholdPhi, uint32_t thresholdDelta);
+    uint64_t keyFor(const ChessEngine& position, int plies) const;
+    bool lookup(uint64_t key, uint32_t& phi, uint32_t& delta) const;
+    void store(uint64_t key, uint32_t phi, uint32_t delta);
+    bool extractLine(ChessEngine& position, int plies, std::vector<BitMove>& line);
+
+    std::vector<Entry> _tt;
+    uint64_t _nodes;
+    uint64_t _nodeLimit;
+};
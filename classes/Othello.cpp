@@ -1,19 +1,26 @@
 #include "Othello.h"
+#include "OthelloPatterns.h"
 #include <iostream>
-
-// Define the 8 directions: N, NE, E, SE, S, SW, W, NW
-const int Othello::DIRECTIONS[8][2] = {
-    {0, -1}, {1, -1}, {1, 0}, {1, 1},
-    {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}
-};
+#include <bit>
 
 Othello::Othello() : Game() {
     _grid = new Grid(8, 8);
     _consecutivePasses = 0;
     _showingHints = false;
+    // the trained evaluation, the hand written one stays in use without it
+    static bool patternsLoaded = othelloLoadPatterns(kOthelloPatternFile);
+    if (!patternsLoaded) {
+        std::cout << "Othello AI: no " << kOthelloPatternFile << ", using the hand written evaluation" << std::endl;
+    }
 }
 
+// time the AI gets for a move
+const int kAIThinkMs = 1000;
+// and for an exact endgame solve before it falls back to the search
+const int kEndgameMs = 10000;
+
 Othello::~Othello() {
+    stopAI();
     delete _grid;
 }
 
@@ -24,21 +31,9 @@ void Othello::setUpBoard() {
 
     _grid->initializeSquares(80, "boardsquare.png");
 
-    // Set up initial four pieces in the center
-    Player* blackPlayer = getPlayerAt(BLACK_PLAYER);
-    Player* whitePlayer = getPlayerAt(WHITE_PLAYER);
-
-    // Standard Othello starting position
-    auto placePiece = [&](int x, int y, Player* player) {
-        Bit* piece = createPiece(player);
-        piece->setPosition(_grid->getSquare(x, y)->getPosition());
-        _grid->getSquare(x, y)->setBit(piece);
-    };
-
-    placePiece(3, 3, whitePlayer);  // White at (3,3)
-    placePiece(4, 4, whitePlayer);  // White at (4,4)
-    placePiece(4, 3, blackPlayer);  // Black at (4,3)
-    placePiece(3, 4, blackPlayer);  // Black at (3,4)
+    // Standard Othello starting position, the sprites follow the bitboards
+    _board = OthelloBoard::start();
+    syncSquares(~0ULL);
 
     if (gameHasAI()) {
         setAIPlayer(AI_PLAYER);
@@ -47,9 +42,14 @@ void Othello::setUpBoard() {
     startGame();
 }
 
+// the disc images come from the shared texture cache, only the first use reads the file
+static const char* discImage(int player) {
+    return player == 0 ? "o.png" : "x.png";
+}
+
 Bit* Othello::createPiece(Player* player) {
     Bit* bit = new Bit();
-    bit->LoadTextureFromFile(player == getPlayerAt(BLACK_PLAYER) ? "o.png" : "x.png");
+    bit->LoadTextureFromFile(discImage(player->playerNumber()));
     bit->setOwner(player);
     return bit;
 }
@@ -64,13 +64,9 @@ bool Othello::actionForEmptyHolder(BitHolder &holder) {
 
     if (!isValidMove(x, y, currentPlayer)) return false;
 
-    // Place the piece
-    Bit* newPiece = createPiece(currentPlayer);
-    newPiece->setPosition(holder.getPosition());
-    holder.setBit(newPiece);
-
-    // Flip all affected pieces
-    flipPieces(x, y, currentPlayer);
+    // Place the piece and flip all affected pieces
+    uint64_t flipped = _board.play(currentPlayer->playerNumber(), y * 8 + x);
+    syncSquares(flipped | (1ULL << (y * 8 + x)), true);
     _consecutivePasses = 0;
 
     // Check if next player has moves
@@ -98,127 +94,67 @@ bool Othello::canBitMoveFromTo(Bit &bit, BitHolder &src, BitHolder &dst) {
 }
 
 bool Othello::isValidMove(int x, int y, Player* player) const {
-    if (!_grid->isValid(x, y) || _grid->getSquare(x, y)->bit()) return false;
-
-    // Check if placing a piece here would flip at least one opponent piece
-    for (int i = 0; i < 8; i++) {
-        if (checkDirection(x, y, DIRECTIONS[i][0], DIRECTIONS[i][1], player) > 0) {
-            return true;
-        }
-    }
-    return false;
-}
-
-int Othello::checkDirection(int x, int y, int dx, int dy, Player* player) const {
-    int count = 0;
-    int nx = x + dx;
-    int ny = y + dy;
-
-    if (!_grid->isValid(nx, ny)) return 0;
-
-    Bit* firstPiece = _grid->getSquare(nx, ny)->bit();
-    if (!firstPiece || firstPiece->getOwner() == player) return 0;
-
-    // Count opponent pieces in this direction
-    while (_grid->isValid(nx, ny)) {
-        Bit* piece = _grid->getSquare(nx, ny)->bit();
-        if (!piece) return 0;
-        if (piece->getOwner() == player) return count;
-        count++;
-        nx += dx;
-        ny += dy;
-    }
-    return 0;
+    if (!_grid->isValid(x, y)) return false;
+    return (_board.moves(player->playerNumber()) >> (y * 8 + x)) & 1;
 }
 
-void Othello::flipPieces(int x, int y, Player* player) {
-    for (int i = 0; i < 8; i++) {
-        int count = checkDirection(x, y, DIRECTIONS[i][0], DIRECTIONS[i][1], player);
-        if (count > 0) {
-            flipInDirection(x, y, DIRECTIONS[i][0], DIRECTIONS[i][1], player, count);
-        }
-    }
-}
-
-void Othello::flipInDirection(int x, int y, int dx, int dy, Player* player, int count) {
-    int nx = x + dx;
-    int ny = y + dy;
-
-    for (int i = 0; i < count; i++) {
-        ChessSquare* square = _grid->getSquare(nx, ny);
-        if (square && square->bit()) {
+//
+// the Grid shows the bitboards: every square in changed gets a sprite for its disc, or none
+//
+void Othello::syncSquares(uint64_t changed, bool animate) {
+    while (changed) {
+        int index = std::countr_zero(changed);
+        changed &= changed - 1;
+        ChessSquare* square = _grid->getSquare(index % 8, index / 8);
+        int player = ((_board.discs[BLACK_PLAYER] >> index) & 1) ? BLACK_PLAYER : ((_board.discs[WHITE_PLAYER] >> index) & 1) ? WHITE_PLAYER : -1;
+        Bit* bit = square->bit();
+        if (player < 0) {
             square->destroyBit();
-            Bit* newPiece = createPiece(player);
-            newPiece->setPosition(square->getPosition());
-            square->setBit(newPiece);
+        } else if (!bit) {
+            Bit* piece = createPiece(getPlayerAt(player));
+            piece->setPosition(square->getPosition());
+            square->setBit(piece);
+        } else if (bit->getOwner() != getPlayerAt(player)) {
+            // a flipped disc keeps its Bit and just changes color
+            if (animate) {
+                bit->flipTo(getPlayerAt(player), discImage(player));
+            } else {
+                bit->setOwner(getPlayerAt(player));
+                bit->LoadTextureFromFile(discImage(player));
+            }
         }
-        nx += dx;
-        ny += dy;
     }
 }
 
 bool Othello::hasValidMove(Player* player) const {
-    bool hasMove = false;
-    _grid->forEachSquare([&](ChessSquare* square, int x, int y) {
-        if (!hasMove && isValidMove(x, y, player)) {
-            hasMove = true;
-        }
-    });
-    return hasMove;
+    return _board.moves(player->playerNumber()) != 0;
 }
 
 std::vector<std::pair<int, int>> Othello::getValidMoves(Player* player) const {
     std::vector<std::pair<int, int>> moves;
-    _grid->forEachSquare([&](ChessSquare* square, int x, int y) {
-        if (isValidMove(x, y, player)) {
-            moves.push_back({x, y});
-        }
-    });
+    uint64_t mask = _board.moves(player->playerNumber());
+    while (mask) {
+        int index = std::countr_zero(mask);
+        mask &= mask - 1;
+        moves.push_back({index % 8, index / 8});
+    }
     return moves;
 }
 
 Player* Othello::checkForWinner() {
-    // Game ends when neither player can move
-    if (_consecutivePasses >= 2 ||
-        (!hasValidMove(getPlayerAt(BLACK_PLAYER)) && !hasValidMove(getPlayerAt(WHITE_PLAYER)))) {
-
+    // Game ends when neither player can move, which includes a full board
+    if (_consecutivePasses >= 2 || _board.gameOver()) {
         int blackCount, whiteCount;
         countPieces(blackCount, whiteCount);
 
         if (blackCount > whiteCount) return getPlayerAt(BLACK_PLAYER);
         if (whiteCount > blackCount) return getPlayerAt(WHITE_PLAYER);
     }
-
-    // Check if board is full
-    bool boardFull = true;
-    _grid->forEachSquare([&boardFull](ChessSquare* square, int x, int y) {
-        if (!square->bit()) boardFull = false;
-    });
-
-    if (boardFull) {
-        int blackCount, whiteCount;
-        countPieces(blackCount, whiteCount);
-        if (blackCount > whiteCount) return getPlayerAt(BLACK_PLAYER);
-        if (whiteCount > blackCount) return getPlayerAt(WHITE_PLAYER);
-    }
-
     return nullptr;
 }
 
 bool Othello::checkForDraw() {
-    if (_consecutivePasses >= 2 ||
-        (!hasValidMove(getPlayerAt(BLACK_PLAYER)) && !hasValidMove(getPlayerAt(WHITE_PLAYER)))) {
-        int blackCount, whiteCount;
-        countPieces(blackCount, whiteCount);
-        return blackCount == whiteCount;
-    }
-
-    bool boardFull = true;
-    _grid->forEachSquare([&boardFull](ChessSquare* square, int x, int y) {
-        if (!square->bit()) boardFull = false;
-    });
-
-    if (boardFull) {
+    if (_consecutivePasses >= 2 || _board.gameOver()) {
         int blackCount, whiteCount;
         countPieces(blackCount, whiteCount);
         return blackCount == whiteCount;
@@ -227,25 +163,16 @@ bool Othello::checkForDraw() {
 }
 
 void Othello::countPieces(int &blackCount, int &whiteCount) const {
-    blackCount = 0;
-    whiteCount = 0;
-
-    _grid->forEachSquare([&](ChessSquare* square, int x, int y) {
-        Bit* piece = square->bit();
-        if (piece) {
-            if (piece->getOwner() == getPlayerAt(BLACK_PLAYER)) {
-                blackCount++;
-            } else {
-                whiteCount++;
-            }
-        }
-    });
+    blackCount = _board.count(BLACK_PLAYER);
+    whiteCount = _board.count(WHITE_PLAYER);
 }
 
 void Othello::stopGame() {
+    stopAI();
     _grid->forEachSquare([](ChessSquare* square, int x, int y) {
         square->destroyBit();
     });
+    _board = OthelloBoard();
     _consecutivePasses = 0;
 }
 
@@ -259,71 +186,86 @@ std::string Othello::initialStateString() {
 }
 
 std::string Othello::stateString() {
-    std::string state;
-    _grid->forEachSquare([&state, this](ChessSquare* square, int x, int y) {
-        Bit* bit = square->bit();
-        if (!bit) {
-            state += '0';
-        } else if (bit->getOwner() == getPlayerAt(BLACK_PLAYER)) {
-            state += '1';
-        } else {
-            state += '2';
+    std::string state(64, '0');
+    for (int index = 0; index < 64; index++) {
+        if ((_board.discs[BLACK_PLAYER] >> index) & 1) {
+            state[index] = '1';
+        } else if ((_board.discs[WHITE_PLAYER] >> index) & 1) {
+            state[index] = '2';
         }
-    });
+    }
     return state;
 }
 
 void Othello::setStateString(const std::string &s) {
     if (s.length() != 64) return;
 
-    int index = 0;
-    _grid->forEachSquare([&](ChessSquare* square, int x, int y) {
-        if (index < s.length()) {
-            char pieceType = s[index++];
-            square->destroyBit();
-
-            if (pieceType == '1') {
-                Bit* piece = createPiece(getPlayerAt(BLACK_PLAYER));
-                piece->setPosition(square->getPosition());
-                square->setBit(piece);
-            } else if (pieceType == '2') {
-                Bit* piece = createPiece(getPlayerAt(WHITE_PLAYER));
-                piece->setPosition(square->getPosition());
-                square->setBit(piece);
-            }
-        }
-    });
+    _board = OthelloBoard();
+    for (int index = 0; index < 64; index++) {
+        if (s[index] == '1') _board.discs[BLACK_PLAYER] |= 1ULL << index;
+        if (s[index] == '2') _board.discs[WHITE_PLAYER] |= 1ULL << index;
+    }
+    syncSquares(~0ULL);
 }
 
 void Othello::updateAI() {
     if (!gameHasAI()) return;
 
     Player* aiPlayer = getCurrentPlayer();
-    std::vector<std::pair<int, int>> validMoves = getValidMoves(aiPlayer);
-
-    if (validMoves.empty()) {
-        _consecutivePasses++;
-        endTurn();
+    if (!_aiTask) {
+        if (!hasValidMove(aiPlayer)) {
+            _consecutivePasses++;
+            endTurn();
+            return;
+        }
+        // search a copy of the position while the UI keeps drawing, the move is played on a later frame
+        _aiState = OthelloState();
+        _aiState.board = _board;
+        _aiState.toMove = aiPlayer->playerNumber();
+        _aiDone = false;
+        _aiTask = std::make_unique<TaskGroup>(ThreadPool::shared(), TaskInteractive);
+        _endgameResult = EndgameResult();
+        // the solver and the search both poll the task's token, so a stop before either starts isn't lost
+        const std::atomic<bool>* cancelled = _aiTask->token().flag();
+        // the Endgame window's slider can change _endgameEmpties while the task runs
+        int endgameEmpties = _endgameEmpties;
+        _aiTask->run([this, cancelled, endgameEmpties]() {
+            if (64 - _aiState.board.count(0) - _aiState.board.count(1) <= endgameEmpties) {
+                _endgameResult = _endgame.solve(_aiState.board, _aiState.toMove, kEndgameMs, true, cancelled);
+                if (*cancelled) return;
+                std::cout << "Endgame: score " << _endgameResult.score << " nodes " << _endgameResult.nodes
+                          << " " << (uint64_t)_endgameResult.nodesPerSecond << " nps" << std::endl;
+                if (_endgameResult.complete && _endgameResult.bestMove >= 0 && _endgameResult.bestMove < 64) {
+                    _aiMove = _endgameResult.bestMove;
+                    _aiDone = true;
+                    return;
+                }
+            }
+            GameSearchLimits limits;
+            limits.timeMs = kAIThinkMs;
+            limits.cancel = cancelled;
+            GameSearchResult<int> result = _search.run(_aiState, limits);
+            std::cout << "Nodes: " << result.nodes << " depth " << result.depth << " score " << result.score << std::endl;
+            _aiMove = result.found ? result.bestMove : OthelloState::Pass;
+            _aiDone = true;
+        });
         return;
     }
+    if (!_aiDone) return;
 
-    // Find move that flips the most pieces
-    int bestX = -1, bestY = -1, maxFlips = 0;
-
-    for (const auto& move : validMoves) {
-        int x = move.first, y = move.second, totalFlips = 0;
-        for (int i = 0; i < 8; i++) {
-            totalFlips += checkDirection(x, y, DIRECTIONS[i][0], DIRECTIONS[i][1], aiPlayer);
-        }
-        if (totalFlips > maxFlips) {
-            maxFlips = totalFlips;
-            bestX = x;
-            bestY = y;
-        }
+    _aiTask.reset();
+    if (_endgameResult.nodes) {
+        _lastEndgame = _endgameResult;
     }
+    if (_aiMove != OthelloState::Pass) {
+        actionForEmptyHolder(*_grid->getSquare(_aiMove % 8, _aiMove / 8));
+    }
+}
 
-    if (bestX >= 0 && bestY >= 0) {
-        actionForEmptyHolder(*_grid->getSquare(bestX, bestY));
+void Othello::stopAI() {
+    if (_aiTask) {
+        _aiTask->cancel();
+        _aiTask.reset();
     }
 }
 
@@ -1,6 +1,11 @@
 #pragma once
 #include "Game.h"
+#include "OthelloState.h"
+#include "OthelloEndgame.h"
+#include "ThreadPool.h"
 #include <vector>
+#include <memory>
+#include <atomic>
 
 // NOTE: This implementation assumes black.png and white.png exist in resources.
 // If not, you can use o.png and x.png, or any other suitable graphics.
@@ -28,20 +33,22 @@ public:
     bool        gameHasAI() override { return true; } // Set to true when AI is implemented
     Grid* getGrid() override { return _grid; }
 
+    // the AI solves the game exactly from this many empty squares down, 0 turns it off
+    int         endgameEmpties() const { return _endgameEmpties; }
+    void        setEndgameEmpties(int empties) { _endgameEmpties = empties; }
+    // the last exact solve the AI played from
+    const EndgameResult& lastEndgame() const { return _lastEndgame; }
+
 private:
     // Player constants
     static const int BLACK_PLAYER = 0;
     static const int WHITE_PLAYER = 1;
 
-    // Direction vectors for checking all 8 directions
-    static const int DIRECTIONS[8][2];
-
     // Helper methods
+    void        stopAI();
     Bit*        createPiece(Player* player);
     bool        isValidMove(int x, int y, Player* player) const;
-    int         checkDirection(int x, int y, int dx, int dy, Player* player) const;
-    void        flipPieces(int x, int y, Player* player);
-    void        flipInDirection(int x, int y, int dx, int dy, Player* player, int count);
+    void        syncSquares(uint64_t changed, bool animate = false);
     bool        hasValidMove(Player* player) const;
     void        countPieces(int &blackCount, int &whiteCount) const;
     std::vector<std::pair<int, int>> getValidMoves(Player* player) const;
@@ -51,10 +58,24 @@ private:
     // Board position helper
     void        getBoardPosition(BitHolder& holder, int &x, int &y) const;
 
-    // Board representation
+    // Board representation, the bitboards are the game and the Grid shows them
     Grid*       _grid;
+    OthelloBoard _board;
 
     // Game state
     int         _consecutivePasses;
     bool        _showingHints;
+
+    // AI search, run as an interactive task on the shared thread pool
+    Search<OthelloState>        _search;
+    OthelloState                _aiState;
+    std::unique_ptr<TaskGroup>  _aiTask;
+    std::atomic<bool>           _aiDone{false};
+    int                         _aiMove = OthelloState::Pass;
+
+    // exact solver for the end of the game, it takes over from _search
+    OthelloEndgame              _endgame;
+    int                         _endgameEmpties = OthelloEndgame::kDefaultEmpties;
+    EndgameResult               _endgameResult;
+    EndgameResult               _lastEndgame;
 };
\ No newline at end of file
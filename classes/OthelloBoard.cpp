@@ -0,0 +1,221 @@
+#include "OthelloBoard.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define OTHELLO_AVX2 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+// MSVC accepts AVX2 intrinsics in any function
+#define AVX2_FUNCTION
+#else
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+#endif
+#endif
+
+// a shift towards a higher square index must not land on the first column after
+// wrapping around from the last one, and the other way round
+constexpr uint64_t kNotFirstColumn = 0xFEFEFEFEFEFEFEFEULL;
+constexpr uint64_t kNotLastColumn = 0x7F7F7F7F7F7F7F7FULL;
+constexpr uint64_t kAll = ~0ULL;
+
+// the four directions that shift left (x + 1, y + 1, x + 1 and y + 1, x - 1 and y + 1),
+// their opposites shift right by the same amounts
+constexpr int kShifts[4] = { 1, 8, 9, 7 };
+constexpr uint64_t kLeftMasks[4] = { kNotFirstColumn, kAll, kNotFirstColumn, kNotLastColumn };
+constexpr uint64_t kRightMasks[4] = { kNotLastColumn, kAll, kNotLastColumn, kNotFirstColumn };
+
+OthelloBoard OthelloBoard::start()
+{
+    OthelloBoard board;
+    board.discs[0] = (1ULL << (3 * 8 + 4)) | (1ULL << (4 * 8 + 3));
+    board.discs[1] = (1ULL << (3 * 8 + 3)) | (1ULL << (4 * 8 + 4));
+    return board;
+}
+
+//
+// Kogge-Stone occluded fill: extends gen along one direction over the squares in pro,
+// doubling the distance each step, so a run of up to seven squares takes three steps
+//
+static inline uint64_t fillLeft(uint64_t gen, uint64_t pro, int shift)
+{
+    gen |= pro & (gen << shift);
+    pro &= pro << shift;
+    gen |= pro & (gen << (2 * shift));
+    pro &= pro << (2 * shift);
+    gen |= pro & (gen << (4 * shift));
+    return gen;
+}
+
+static inline uint64_t fillRight(uint64_t gen, uint64_t pro, int shift)
+{
+    gen |= pro & (gen >> shift);
+    pro &= pro >> shift;
+    gen |= pro & (gen >> (2 * shift));
+    pro &= pro >> (2 * shift);
+    gen |= pro & (gen >> (4 * shift));
+    return gen;
+}
+
+uint64_t OthelloBoard::mobilityScalar(uint64_t player, uint64_t opponent)
+{
+    uint64_t moves = 0;
+    for(int i = 0; i < 4; i++) {
+        // the runs of opponent discs that start next to one of ours, then one square further
+        uint64_t left = fillLeft(player, opponent & kLeftMasks[i], kShifts[i]) & ~player;
+        uint64_t right = fillRight(player, opponent & kRightMasks[i], kShifts[i]) & ~player;
+        moves |= ((left << kShifts[i]) & kLeftMasks[i]) | ((right >> kShifts[i]) & kRightMasks[i]);
+    }
+    return moves & ~(player | opponent);
+}
+
+uint64_t OthelloBoard::flipsScalar(int square, uint64_t player, uint64_t opponent)
+{
+    uint64_t move = 1ULL << square;
+    if((player | opponent) & move) {
+        return 0;
+    }
+    uint64_t flipped = 0;
+    for(int i = 0; i < 4; i++) {
+        // the run of opponent discs from the move is flipped when one of ours closes it
+        uint64_t left = fillLeft(move, opponent & kLeftMasks[i], kShifts[i]);
+        if((left << kShifts[i]) & kLeftMasks[i] & player) {
+            flipped |= left & ~move;
+        }
+        uint64_t right = fillRight(move, opponent & kRightMasks[i], kShifts[i]);
+        if((right >> kShifts[i]) & kRightMasks[i] & player) {
+            flipped |= right & ~move;
+        }
+    }
+    return flipped;
+}
+
+#ifdef OTHELLO_AVX2
+
+// the same fills with the four directions of each side in one register
+
+AVX2_FUNCTION static inline uint64_t orLanes(__m256i value)
+{
+    __m128i half = _mm_or_si128(_mm256_castsi256_si128(value), _mm256_extracti128_si256(value, 1));
+    return (uint64_t)_mm_cvtsi128_si64(half) | (uint64_t)_mm_extract_epi64(half, 1);
+}
+
+AVX2_FUNCTION static uint64_t mobilityAVX2(uint64_t player, uint64_t opponent)
+{
+    const __m256i shift1 = _mm256_set_epi64x(kShifts[3], kShifts[2], kShifts[1], kShifts[0]);
+    const __m256i shift2 = _mm256_add_epi64(shift1, shift1);
+    const __m256i shift4 = _mm256_add_epi64(shift2, shift2);
+    const __m256i leftMasks = _mm256_set_epi64x(kLeftMasks[3], kLeftMasks[2], kLeftMasks[1], kLeftMasks[0]);
+    const __m256i rightMasks = _mm256_set_epi64x(kRightMasks[3], kRightMasks[2], kRightMasks[1], kRightMasks[0]);
+    __m256i own = _mm256_set1_epi64x((long long)player);
+    __m256i other = _mm256_set1_epi64x((long long)opponent);
+
+    __m256i pro = _mm256_and_si256(other, leftMasks);
+    __m256i left = _mm256_or_si256(own, _mm256_and_si256(pro, _mm256_sllv_epi64(own, shift1)));
+    pro = _mm256_and_si256(pro, _mm256_sllv_epi64(pro, shift1));
+    left = _mm256_or_si256(left, _mm256_and_si256(pro, _mm256_sllv_epi64(left, shift2)));
+    pro = _mm256_and_si256(pro, _mm256_sllv_epi64(pro, shift2));
+    left = _mm256_or_si256(left, _mm256_and_si256(pro, _mm256_sllv_epi64(left, shift4)));
+    left = _mm256_and_si256(_mm256_sllv_epi64(_mm256_andnot_si256(own, left), shift1), leftMasks);
+
+    pro = _mm256_and_si256(other, rightMasks);
+    __m256i right = _mm256_or_si256(own, _mm256_and_si256(pro, _mm256_srlv_epi64(own, shift1)));
+    pro = _mm256_and_si256(pro, _mm256_srlv_epi64(pro, shift1));
+    right = _mm256_or_si256(right, _mm256_and_si256(pro, _mm256_srlv_epi64(right, shift2)));
+    pro = _mm256_and_si256(pro, _mm256_srlv_epi64(pro, shift2));
+    right = _mm256_or_si256(right, _mm256_and_si256(pro, _mm256_srlv_epi64(right, shift4)));
+    right = _mm256_and_si256(_mm256_srlv_epi64(_mm256_andnot_si256(own, right), shift1), rightMasks);
+
+    return orLanes(_mm256_or_si256(left, right)) & ~(player | opponent);
+}
+
+AVX2_FUNCTION static uint64_t flipsAVX2(int square, uint64_t player, uint64_t opponent)
+{
+    uint64_t bit = 1ULL << square;
+    if((player | opponent) & bit) {
+        return 0;
+    }
+    const __m256i shift1 = _mm256_set_epi64x(kShifts[3], kShifts[2], kShifts[1], kShifts[0]);
+    const __m256i shift2 = _mm256_add_epi64(shift1, shift1);
+    const __m256i shift4 = _mm256_add_epi64(shift2, shift2);
+    const __m256i leftMasks = _mm256_set_epi64x(kLeftMasks[3], kLeftMasks[2], kLeftMasks[1], kLeftMasks[0]);
+    const __m256i rightMasks = _mm256_set_epi64x(kRightMasks[3], kRightMasks[2], kRightMasks[1], kRightMasks[0]);
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i move = _mm256_set1_epi64x((long long)bit);
+    __m256i own = _mm256_set1_epi64x((long long)player);
+    __m256i other = _mm256_set1_epi64x((long long)opponent);
+
+    __m256i pro = _mm256_and_si256(other, leftMasks);
+    __m256i left = _mm256_or_si256(move, _mm256_and_si256(pro, _mm256_sllv_epi64(move, shift1)));
+    pro = _mm256_and_si256(pro, _mm256_sllv_epi64(pro, shift1));
+    left = _mm256_or_si256(left, _mm256_and_si256(pro, _mm256_sllv_epi64(left, shift2)));
+    pro = _mm256_and_si256(pro, _mm256_sllv_epi64(pro, shift2));
+    left = _mm256_or_si256(left, _mm256_and_si256(pro, _mm256_sllv_epi64(left, shift4)));
+    // keep a direction's run only where the square after it is ours
+    __m256i closed = _mm256_and_si256(_mm256_and_si256(_mm256_sllv_epi64(left, shift1), leftMasks), own);
+    left = _mm256_andnot_si256(_mm256_cmpeq_epi64(closed, zero), _mm256_andnot_si256(move, left));
+
+    pro = _mm256_and_si256(other, rightMasks);
+    __m256i right = _mm256_or_si256(move, _mm256_and_si256(pro, _mm256_srlv_epi64(move, shift1)));
+    pro = _mm256_and_si256(pro, _mm256_srlv_epi64(pro, shift1));
+    right = _mm256_or_si256(right, _mm256_and_si256(pro, _mm256_srlv_epi64(right, shift2)));
+    pro = _mm256_and_si256(pro, _mm256_srlv_epi64(pro, shift2));
+    right = _mm256_or_si256(right, _mm256_and_si256(pro, _mm256_srlv_epi64(right, shift4)));
+    closed = _mm256_and_si256(_mm256_and_si256(_mm256_srlv_epi64(right, shift1), rightMasks), own);
+    right = _mm256_andnot_si256(_mm256_cmpeq_epi64(closed, zero), _mm256_andnot_si256(move, right));
+
+    return orLanes(_mm256_or_si256(left, right));
+}
+
+static bool cpuHasAVX2()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if(info[0] < 7) {
+        return false;
+    }
+    // the OS has to save the wide registers too
+    __cpuid(info, 1);
+    if(!(info[2] & (1 << 27)) || !(info[2] & (1 << 28)) || (_xgetbv(0) & 6) != 6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+static const bool kUseAVX2 = cpuHasAVX2();
+
+#else
+
+static const bool kUseAVX2 = false;
+
+#endif
+
+uint64_t OthelloBoard::mobility(uint64_t player, uint64_t opponent)
+{
+#ifdef OTHELLO_AVX2
+    if(kUseAVX2) {
+        return mobilityAVX2(player, opponent);
+    }
+#endif
+    return mobilityScalar(player, opponent);
+}
+
+uint64_t OthelloBoard::flips(int square, uint64_t player, uint64_t opponent)
+{
+#ifdef OTHELLO_AVX2
+    if(kUseAVX2) {
+        return flipsAVX2(square, player, opponent);
+    }
+#endif
+    return flipsScalar(square, player, opponent);
+}
+
+bool OthelloBoard::usingAVX2()
+{
+    return kUseAVX2;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <bit>
+
+//
+// Othello position as two bitboards, one per player
+//
+// squares are y * 8 + x in Grid order, so bit 0 is the top left corner. player 0 is
+// black and moves first. moves and flips are found for all eight directions at once
+// with parallel prefix (Kogge-Stone) fills instead of walking squares one by one. on
+// x86-64 processors with AVX2 four directions share one 256 bit register, otherwise
+// a scalar version of the same fills is used. the choice is made once at startup.
+//
+struct OthelloBoard
+{
+    uint64_t discs[2] = { 0, 0 };
+
+    static OthelloBoard start();
+
+    uint64_t occupied() const { return discs[0] | discs[1]; }
+    uint64_t empty() const { return ~occupied(); }
+    int count(int player) const { return std::popcount(discs[player]); }
+
+    // squares player can move to
+    uint64_t moves(int player) const { return mobility(discs[player], discs[player ^ 1]); }
+    bool gameOver() const { return !moves(0) && !moves(1); }
+
+    // puts a disc for player on square and turns over the discs it flanks. returns the
+    // discs turned over, 0 for an illegal move, which leaves the board unchanged.
+    uint64_t play(int player, int square)
+    {
+        uint64_t flipped = flips(square, discs[player], discs[player ^ 1]);
+        if(flipped) {
+            discs[player] |= flipped | (1ULL << square);
+            discs[player ^ 1] &= ~flipped;
+        }
+        return flipped;
+    }
+
+    // takes back a play() that returned flipped
+    void undo(int player, int square, uint64_t flipped)
+    {
+        discs[player] &= ~(flipped | (1ULL << square));
+        discs[player ^ 1] |= flipped;
+    }
+
+    static uint64_t mobility(uint64_t player, uint64_t opponent);
+    static uint64_t flips(int square, uint64_t player, uint64_t opponent);
+
+    // the scalar versions, always available
+    static uint64_t mobilityScalar(uint64_t player, uint64_t opponent);
+    static uint64_t flipsScalar(int square, uint64_t player, uint64_t opponent);
+
+    // whether mobility() and flips() run the AVX2 code on this machine
+    static bool usingAVX2();
+};
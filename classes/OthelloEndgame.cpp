@@ -0,0 +1,410 @@
+#include "OthelloEndgame.h"
+#include "ThreadPool.h"
+#include "Search.h"
+#include <mutex>
+#include <bit>
+
+// split the search over the pool this many plies deep, with at least this many empties left
+constexpr int kSplitPlies = 2;
+constexpr int kSplitEmpties = 12;
+// below this many empties moves are ordered by parity instead of by the opponent's replies
+constexpr int kFastestFirstEmpties = 10;
+// the transposition table isn't worth probing this close to the end
+constexpr int kTTEmpties = 7;
+
+constexpr uint64_t kCorners = 0x8100000000000081ULL;
+// the four 4x4 quarters of the board
+constexpr uint64_t kQuadrants[4] = { 0x000000000F0F0F0FULL, 0x00000000F0F0F0F0ULL, 0x0F0F0F0F00000000ULL, 0xF0F0F0F000000000ULL };
+
+struct OthelloEndgame::SplitPoint
+{
+    std::atomic<int> alpha{0};
+    int beta = 0;
+    std::atomic<bool> cutoff{false};
+    std::atomic<uint64_t> nodes{0};
+    const SplitPoint* parent = nullptr;
+    std::mutex mutex;
+    int bestScore = 0;
+    int bestMove = -1;
+};
+
+struct OthelloEndgame::Context
+{
+    uint64_t nodes = 0;
+    const SplitPoint* split = nullptr;
+    bool aborted = false;
+};
+
+static int quadrant(int square)
+{
+    return (square / 8 >= 4 ? 2 : 0) + (square % 8 >= 4 ? 1 : 0);
+}
+
+// the game is over: the margin, with the empty squares going to the winner
+static int finalScore(uint64_t player, uint64_t opponent)
+{
+    int own = std::popcount(player);
+    int other = std::popcount(opponent);
+    int empties = 64 - own - other;
+    int margin = own - other;
+    return margin > 0 ? margin + empties : margin < 0 ? margin - empties : 0;
+}
+
+// one empty square left: whoever can play it does, counted without making the move
+static int solveLast1(uint64_t player, uint64_t opponent, int square, uint64_t& nodes)
+{
+    nodes++;
+    int margin = 2 * std::popcount(player) - 63;
+    if(uint64_t flipped = OthelloBoard::flips(square, player, opponent)) {
+        return margin + 2 * std::popcount(flipped) + 1;
+    }
+    if(uint64_t flipped = OthelloBoard::flips(square, opponent, player)) {
+        return margin - 2 * std::popcount(flipped) - 1;
+    }
+    return margin > 0 ? margin + 1 : margin - 1;
+}
+
+// two to four empties: try each empty square directly, the squares come in parity order
+template<int N>
+static int solveLast(uint64_t player, uint64_t opponent, int alpha, int beta, const int* squares, bool passed, uint64_t& nodes)
+{
+    nodes++;
+    int best = -kSearchInfinity;
+    for(int i = 0; i < N; i++) {
+        uint64_t flipped = OthelloBoard::flips(squares[i], player, opponent);
+        if(!flipped) {
+            continue;
+        }
+        int rest[N - 1];
+        for(int j = 0, k = 0; j < N; j++) {
+            if(j != i) {
+                rest[k++] = squares[j];
+            }
+        }
+        uint64_t nextPlayer = opponent & ~flipped;
+        uint64_t nextOpponent = player | flipped | (1ULL << squares[i]);
+        int score;
+        if constexpr(N == 2) {
+            score = -solveLast1(nextPlayer, nextOpponent, rest[0], nodes);
+        } else {
+            score = -solveLast<N - 1>(nextPlayer, nextOpponent, -beta, -alpha, rest, false, nodes);
+        }
+        if(score > best) {
+            best = score;
+            if(score > alpha) {
+                alpha = score;
+                if(alpha >= beta) {
+                    return best;
+                }
+            }
+        }
+    }
+    if(best == -kSearchInfinity) {
+        if(passed) {
+            return finalScore(player, opponent);
+        }
+        return -solveLast<N>(opponent, player, -beta, -alpha, squares, true, nodes);
+    }
+    return best;
+}
+
+OthelloEndgame::OthelloEndgame(size_t ttEntries)
+{
+    size_t size = 1;
+    while(size * 2 <= ttEntries) {
+        size *= 2;
+    }
+    _tt.reset(new TTEntry[size]);
+    _ttMask = size - 1;
+}
+
+void OthelloEndgame::clear()
+{
+    for(size_t i = 0; i <= _ttMask; i++) {
+        _tt[i].check = 0;
+        _tt[i].data = 0;
+    }
+}
+
+// data: lower bound + 64, upper bound + 64 and the best move, a byte each
+bool OthelloEndgame::probeTT(uint64_t key, int& lower, int& upper, int& move) const
+{
+    const TTEntry& entry = _tt[key & _ttMask];
+    uint64_t data = entry.data.load(std::memory_order_relaxed);
+    if((entry.check.load(std::memory_order_relaxed) ^ data) != key || !data) {
+        return false;
+    }
+    lower = (int)(data & 0xFF) - 64;
+    upper = (int)((data >> 8) & 0xFF) - 64;
+    move = (int)((data >> 16) & 0xFF);
+    return true;
+}
+
+void OthelloEndgame::storeTT(uint64_t key, int score, int alpha, int beta, int move)
+{
+    int lower = score > alpha ? score : -64;
+    int upper = score < beta ? score : 64;
+    uint64_t data = (uint64_t)(lower + 64) | ((uint64_t)(upper + 64) << 8) | ((uint64_t)move << 16);
+    TTEntry& entry = _tt[key & _ttMask];
+    entry.check.store(key ^ data, std::memory_order_relaxed);
+    entry.data.store(data, std::memory_order_relaxed);
+}
+
+bool OthelloEndgame::aborted(Context& context)
+{
+    if(!context.aborted) {
+        if(_timeMs && std::chrono::steady_clock::now() - _start >= std::chrono::milliseconds(_timeMs)) {
+            _stop = true;
+        }
+        if(_cancel && *_cancel) {
+            _stop = true;
+        }
+        context.aborted = _stop;
+        for(const SplitPoint* split = context.split; split && !context.aborted; split = split->parent) {
+            context.aborted = split->cutoff;
+        }
+    }
+    return context.aborted;
+}
+
+int OthelloEndgame::orderMoves(uint64_t player, uint64_t opponent, uint64_t moves, int ttMove, int* squares) const
+{
+    uint64_t empty = ~(player | opponent);
+    bool fastestFirst = std::popcount(empty) > kFastestFirstEmpties;
+    int scores[32];
+    int count = 0;
+    while(moves) {
+        int square = std::countr_zero(moves);
+        moves &= moves - 1;
+        uint64_t bit = 1ULL << square;
+        int score = (bit & kCorners) ? 32 : 0;
+        if(square == ttMove) {
+            score = 1 << 20;
+        } else if(fastestFirst) {
+            uint64_t flipped = OthelloBoard::flips(square, player, opponent);
+            score -= 16 * std::popcount(OthelloBoard::mobility(opponent & ~flipped, player | flipped | bit));
+        } else if(std::popcount(empty & kQuadrants[quadrant(square)]) & 1) {
+            score += 16;
+        }
+        int i = count++;
+        for(; i > 0 && scores[i - 1] < score; i--) {
+            scores[i] = scores[i - 1];
+            squares[i] = squares[i - 1];
+        }
+        scores[i] = score;
+        squares[i] = square;
+    }
+    return count;
+}
+
+int OthelloEndgame::search(uint64_t player, uint64_t opponent, int alpha, int beta, bool passed, int ply, Context& context)
+{
+    if((++context.nodes & 4095) == 0) {
+        aborted(context);
+    }
+    if(context.aborted) {
+        return 0;
+    }
+
+    uint64_t empty = ~(player | opponent);
+    int empties = std::popcount(empty);
+    if(empties <= 4) {
+        // odd quarters first
+        int squares[4];
+        int count = 0;
+        for(int pass = 0; pass < 2; pass++) {
+            for(uint64_t rest = empty; rest; rest &= rest - 1) {
+                int square = std::countr_zero(rest);
+                bool odd = std::popcount(empty & kQuadrants[quadrant(square)]) & 1;
+                if(odd == (pass == 0)) {
+                    squares[count++] = square;
+                }
+            }
+        }
+        switch(empties) {
+            case 4: return solveLast<4>(player, opponent, alpha, beta, squares, passed, context.nodes);
+            case 3: return solveLast<3>(player, opponent, alpha, beta, squares, passed, context.nodes);
+            case 2: return solveLast<2>(player, opponent, alpha, beta, squares, passed, context.nodes);
+            case 1: return solveLast1(player, opponent, squares[0], context.nodes);
+            default: return finalScore(player, opponent);
+        }
+    }
+
+    uint64_t moves = OthelloBoard::mobility(player, opponent);
+    if(!moves) {
+        if(passed) {
+            return finalScore(player, opponent);
+        }
+        return -search(opponent, player, -beta, -alpha, true, ply + 1, context);
+    }
+    if(_parallel && ply < kSplitPlies && empties >= kSplitEmpties && std::popcount(moves) > 1) {
+        return searchSplit(player, opponent, alpha, beta, ply, context, nullptr);
+    }
+
+    uint64_t key = 0;
+    int ttMove = -1;
+    if(empties >= kTTEmpties) {
+        key = zobristKey(player) ^ (zobristKey(opponent ^ 0x5555555555555555ULL) * 3);
+        int lower, upper;
+        if(probeTT(key, lower, upper, ttMove)) {
+            if(lower >= beta) return lower;
+            if(upper <= alpha) return upper;
+            if(lower == upper) return lower;
+        }
+    }
+
+    int squares[32];
+    int count = orderMoves(player, opponent, moves, ttMove, squares);
+    int originalAlpha = alpha;
+    int best = -kSearchInfinity;
+    int bestMove = squares[0];
+    for(int i = 0; i < count; i++) {
+        int square = squares[i];
+        uint64_t flipped = OthelloBoard::flips(square, player, opponent);
+        uint64_t nextPlayer = opponent & ~flipped;
+        uint64_t nextOpponent = player | flipped | (1ULL << square);
+        int score;
+        if(i == 0) {
+            score = -search(nextPlayer, nextOpponent, -beta, -alpha, false, ply + 1, context);
+        } else {
+            // the rest only have to be shown worse, unless one isn't
+            score = -search(nextPlayer, nextOpponent, -alpha - 1, -alpha, false, ply + 1, context);
+            if(score > alpha && score < beta) {
+                score = -search(nextPlayer, nextOpponent, -beta, -alpha, false, ply + 1, context);
+            }
+        }
+        if(context.aborted) {
+            return 0;
+        }
+        if(score > best) {
+            best = score;
+            bestMove = square;
+            if(score > alpha) {
+                alpha = score;
+                if(alpha >= beta) {
+                    break;
+                }
+            }
+        }
+    }
+    if(key) {
+        storeTT(key, best, originalAlpha, beta, bestMove);
+    }
+    return best;
+}
+
+int OthelloEndgame::searchSplit(uint64_t player, uint64_t opponent, int alpha, int beta, int ply, Context& context, int* bestMove)
+{
+    uint64_t key = zobristKey(player) ^ (zobristKey(opponent ^ 0x5555555555555555ULL) * 3);
+    int lower, upper, ttMove = -1;
+    probeTT(key, lower, upper, ttMove);
+
+    int squares[32];
+    int count = orderMoves(player, opponent, OthelloBoard::mobility(player, opponent), ttMove, squares);
+    int originalAlpha = alpha;
+
+    // the first move alone, for a bound to search the others against
+    uint64_t flipped = OthelloBoard::flips(squares[0], player, opponent);
+    int first = -search(opponent & ~flipped, player | flipped | (1ULL << squares[0]), -beta, -alpha, false, ply + 1, context);
+    if(context.aborted) {
+        return 0;
+    }
+
+    SplitPoint split;
+    split.alpha = std::max(alpha, first);
+    split.beta = beta;
+    split.parent = context.split;
+    split.bestScore = first;
+    split.bestMove = squares[0];
+    if(first < beta) {
+        auto searchMove = [&, this](int square) {
+            Context local;
+            local.split = &split;
+            int bound = split.alpha;
+            if(bound >= beta) {
+                return;
+            }
+            uint64_t flips = OthelloBoard::flips(square, player, opponent);
+            uint64_t nextPlayer = opponent & ~flips;
+            uint64_t nextOpponent = player | flips | (1ULL << square);
+            int score = -search(nextPlayer, nextOpponent, -bound - 1, -bound, false, ply + 1, local);
+            if(!local.aborted && score > bound && score < beta) {
+                score = -search(nextPlayer, nextOpponent, -beta, -bound, false, ply + 1, local);
+            }
+            split.nodes += local.nodes;
+            if(local.aborted) {
+                return;
+            }
+            std::lock_guard<std::mutex> lock(split.mutex);
+            if(score > split.bestScore) {
+                split.bestScore = score;
+                split.bestMove = square;
+            }
+            if(score > split.alpha) {
+                split.alpha = score;
+            }
+            if(score >= beta) {
+                split.cutoff = true;
+            }
+        };
+        TaskGroup group(ThreadPool::shared(), TaskInteractive);
+        for(int i = 1; i < count; i++) {
+            int square = squares[i];
+            group.run([&searchMove, square]() { searchMove(square); });
+        }
+        group.wait();
+    }
+    context.nodes += split.nodes;
+    if(aborted(context)) {
+        return 0;
+    }
+    storeTT(key, split.bestScore, originalAlpha, beta, split.bestMove);
+    if(bestMove) {
+        *bestMove = split.bestMove;
+    }
+    return split.bestScore;
+}
+
+EndgameResult OthelloEndgame::solve(const OthelloBoard& board, int player, int timeMs, bool parallel, const std::atomic<bool>* cancel)
+{
+    _start = std::chrono::steady_clock::now();
+    _stop = false;
+    _cancel = cancel;
+    _timeMs = timeMs;
+    _parallel = parallel;
+
+    EndgameResult result;
+    uint64_t own = board.discs[player];
+    uint64_t other = board.discs[player ^ 1];
+    Context context;
+    uint64_t moves = OthelloBoard::mobility(own, other);
+    if(!moves) {
+        if(!OthelloBoard::mobility(other, own)) {
+            result.score = finalScore(own, other);
+        } else {
+            result.bestMove = 64;
+            result.score = -search(other, own, -65, 65, true, 1, context);
+        }
+    } else if(std::popcount(~(own | other)) <= 4 || std::popcount(moves) == 1) {
+        // nothing to split, search each move in turn
+        int alpha = -65;
+        for(uint64_t rest = moves; rest; rest &= rest - 1) {
+            int square = std::countr_zero(rest);
+            uint64_t flipped = OthelloBoard::flips(square, own, other);
+            int score = -search(other & ~flipped, own | flipped | (1ULL << square), -65, -alpha, false, 1, context);
+            if(score > alpha) {
+                alpha = score;
+                result.bestMove = square;
+            }
+        }
+        result.score = alpha;
+    } else {
+        result.score = searchSplit(own, other, -65, 65, 0, context, &result.bestMove);
+    }
+
+    result.complete = !context.aborted;
+    result.nodes = context.nodes;
+    result.timeMs = (int)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _start).count();
+    result.nodesPerSecond = result.nodes * 1000.0 / std::max(1, result.timeMs);
+    return result;
+}
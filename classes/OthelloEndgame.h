@@ -0,0 +1,76 @@
+#pragma once
+
+#include "OthelloBoard.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <cstdint>
+
+//
+// exact Othello endgame solver
+//
+// searches to the end of the game for the final disc margin, empty squares going to the
+// winner. moves are ordered fastest first (the fewest replies for the opponent) while
+// many squares are empty, and by parity near the end: a move into a region of the board
+// with an odd number of empties comes first, so we get the last move there. the last
+// four empties have their own routines that try the empty squares directly instead of
+// generating moves, the very last one just counts flips.
+//
+// the first couple of plies are split over the shared thread pool: the first move is
+// searched alone for a bound, then the others in parallel against it. a cutoff at a
+// split point stops the tasks still searching its other moves.
+//
+
+struct EndgameResult
+{
+    bool complete = false;      // false when stopped or out of time
+    int score = 0;              // final disc margin for the side to move with perfect play
+    int bestMove = -1;          // a square, 64 for a pass, -1 when the game is over
+    uint64_t nodes = 0;
+    int timeMs = 0;
+    double nodesPerSecond = 0;
+};
+
+class OthelloEndgame
+{
+public:
+    // the AI switches to the solver from this many empty squares down
+    static const int kDefaultEmpties = 20;
+
+    explicit OthelloEndgame(size_t ttEntries = 1 << 20);
+
+    // timeMs 0 = until solved. parallel splits the first plies over the shared thread pool.
+    // cancel stops the solve once set, it is never cleared here so it can be set before solve() starts.
+    EndgameResult solve(const OthelloBoard& board, int player, int timeMs = 0, bool parallel = true, const std::atomic<bool>* cancel = nullptr);
+    // safe to call from another thread while solve() runs
+    void stop() { _stop = true; }
+    void clear();
+
+private:
+    struct SplitPoint;
+    struct Context;
+
+    int search(uint64_t player, uint64_t opponent, int alpha, int beta, bool passed, int ply, Context& context);
+    int searchSplit(uint64_t player, uint64_t opponent, int alpha, int beta, int ply, Context& context, int* bestMove);
+    int orderMoves(uint64_t player, uint64_t opponent, uint64_t moves, int ttMove, int* squares) const;
+    bool aborted(Context& context);
+
+    bool probeTT(uint64_t key, int& lower, int& upper, int& move) const;
+    void storeTT(uint64_t key, int score, int alpha, int beta, int move);
+
+    // two words per entry: the key xor the data, and the data, so a torn write by
+    // another thread just reads back as a miss
+    struct TTEntry
+    {
+        std::atomic<uint64_t> check{0};
+        std::atomic<uint64_t> data{0};
+    };
+    std::unique_ptr<TTEntry[]> _tt;
+    size_t _ttMask = 0;
+
+    std::atomic<bool> _stop{false};
+    const std::atomic<bool>* _cancel = nullptr;
+    bool _parallel = true;
+    int _timeMs = 0;
+    std::chrono::steady_clock::time_point _start;
+};
@@ -0,0 +1,128 @@
+#include "OthelloEval.h"
+#include "OthelloPatterns.h"
+#include "Search.h"
+#include <bit>
+
+constexpr uint64_t kFirstColumn = 0x0101010101010101ULL;
+constexpr uint64_t kLastColumn = 0x8080808080808080ULL;
+constexpr uint64_t kFirstRow = 0x00000000000000FFULL;
+constexpr uint64_t kLastRow = 0xFF00000000000000ULL;
+constexpr uint64_t kBorder = kFirstColumn | kLastColumn | kFirstRow | kLastRow;
+constexpr uint64_t kCorners = 0x8100000000000081ULL;
+
+// each corner with its X-square
+static const int kCornerSquares[4][2] = { { 0, 9 }, { 7, 14 }, { 56, 49 }, { 63, 54 } };
+
+struct LineMasks
+{
+    uint64_t rows[8];
+    uint64_t columns[8];
+    uint64_t diagonals[15];         // x - y constant
+    uint64_t antiDiagonals[15];     // x + y constant
+
+    LineMasks() : rows(), columns(), diagonals(), antiDiagonals()
+    {
+        for(int square = 0; square < 64; square++) {
+            int x = square % 8;
+            int y = square / 8;
+            uint64_t bit = 1ULL << square;
+            rows[y] |= bit;
+            columns[x] |= bit;
+            diagonals[x - y + 7] |= bit;
+            antiDiagonals[x + y] |= bit;
+        }
+    }
+};
+
+static const LineMasks kLines;
+
+// the squares on a line, of the given set, that are completely filled
+template<size_t N>
+static uint64_t fullLines(const uint64_t (&lines)[N], uint64_t occupied)
+{
+    uint64_t full = 0;
+    for(uint64_t line : lines) {
+        if((occupied & line) == line) {
+            full |= line;
+        }
+    }
+    return full;
+}
+
+// empty squares next to any of discs
+static uint64_t neighbours(uint64_t discs, uint64_t empty)
+{
+    uint64_t around = ((discs << 1) & ~kFirstColumn) | ((discs >> 1) & ~kLastColumn) | (discs << 8) | (discs >> 8) |
+                      ((discs << 9) & ~kFirstColumn) | ((discs >> 9) & ~kLastColumn) |
+                      ((discs << 7) & ~kLastColumn) | ((discs >> 7) & ~kFirstColumn);
+    return around & empty;
+}
+
+uint64_t othelloStableDiscs(const OthelloBoard& board, int player)
+{
+    uint64_t own = board.discs[player];
+    uint64_t occupied = board.occupied();
+    uint64_t fullRows = fullLines(kLines.rows, occupied);
+    uint64_t fullColumns = fullLines(kLines.columns, occupied);
+    uint64_t fullDiagonals = fullLines(kLines.diagonals, occupied);
+    uint64_t fullAntiDiagonals = fullLines(kLines.antiDiagonals, occupied);
+
+    // grow from the edges until nothing more is added
+    uint64_t stable = 0;
+    while(true) {
+        uint64_t horizontal = kFirstColumn | kLastColumn | fullRows | ((stable << 1) & ~kFirstColumn) | ((stable >> 1) & ~kLastColumn);
+        uint64_t vertical = kFirstRow | kLastRow | fullColumns | (stable << 8) | (stable >> 8);
+        uint64_t diagonal = kBorder | fullDiagonals | ((stable << 9) & ~kFirstColumn) | ((stable >> 9) & ~kLastColumn);
+        uint64_t antiDiagonal = kBorder | fullAntiDiagonals | ((stable << 7) & ~kLastColumn) | ((stable >> 7) & ~kFirstColumn);
+        uint64_t grown = own & horizontal & vertical & diagonal & antiDiagonal;
+        if(grown == stable) {
+            return stable;
+        }
+        stable = grown;
+    }
+}
+
+int othelloFinalScore(const OthelloBoard& board, int player)
+{
+    int margin = board.count(player) - board.count(player ^ 1);
+    if(margin > 0) return kSearchWin + margin;
+    if(margin < 0) return -kSearchWin + margin;
+    return 0;
+}
+
+int othelloEvaluate(const OthelloBoard& board, int player)
+{
+    if(othelloPatternsLoaded()) {
+        return othelloPatternEvaluate(board, player);
+    }
+    return othelloHandEvaluate(board, player);
+}
+
+int othelloHandEvaluate(const OthelloBoard& board, int player)
+{
+    uint64_t own = board.discs[player];
+    uint64_t other = board.discs[player ^ 1];
+    uint64_t empty = board.empty();
+    int empties = std::popcount(empty);
+
+    int mobility = std::popcount(OthelloBoard::mobility(own, other)) - std::popcount(OthelloBoard::mobility(other, own));
+    int potential = std::popcount(neighbours(other, empty)) - std::popcount(neighbours(own, empty));
+    int corners = std::popcount(own & kCorners) - std::popcount(other & kCorners);
+    int xSquares = 0;
+    for(const auto& corner : kCornerSquares) {
+        if((empty >> corner[0]) & 1) {
+            xSquares += (int)((own >> corner[1]) & 1) - (int)((other >> corner[1]) & 1);
+        }
+    }
+    int stable = std::popcount(othelloStableDiscs(board, player)) - std::popcount(othelloStableDiscs(board, player ^ 1));
+
+    // shift the weight from mobility to stability as the board fills up
+    int opening = empties;
+    int ending = 60 - empties;
+    int score = mobility * (40 + opening) +
+                potential * (10 + opening / 3) +
+                corners * 800 -
+                xSquares * 250 +
+                stable * (60 + 2 * ending);
+    return score;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "OthelloBoard.h"
+
+//
+// Othello evaluation for the alpha-beta AI
+//
+// the trained pattern evaluation in OthelloPatterns.h is used once its weights are
+// loaded, otherwise this hand written one.
+//
+// the terms, each as the side to move's count minus the opponent's:
+//   mobility            legal moves now
+//   potential mobility  empty squares next to the opponent's discs, future moves
+//   corners             discs on the corners, which can never be flipped
+//   x-squares           discs diagonally next to an empty corner, which give it away
+//   stable discs        discs that can't be flipped for the rest of the game
+// mobility counts most in the opening and midgame, stable discs near the end.
+//
+
+// discs of player that can never be flipped. conservative: a disc counts when in all
+// four line directions it sits on the edge, next to a stable disc of its own, or on a full line.
+uint64_t othelloStableDiscs(const OthelloBoard& board, int player);
+
+// for player, in roughly hundredths of a disc
+int othelloEvaluate(const OthelloBoard& board, int player);
+int othelloHandEvaluate(const OthelloBoard& board, int player);
+
+// a finished game for player: kSearchWin plus the disc margin for a win, and so on
+int othelloFinalScore(const OthelloBoard& board, int player);
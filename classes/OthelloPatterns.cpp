@@ -0,0 +1,196 @@
+#include "OthelloPatterns.h"
+#include <fstream>
+#include <cstring>
+#include <climits>
+#include <bit>
+
+static const char kPatternMagic[4] = { 'O', 'T', 'P', '1' };
+
+// a run of zeros in the file is this value followed by the run length
+constexpr int16_t kZeroRun = INT16_MIN;
+
+struct PatternInstance
+{
+    int offset;             // of its table within a phase
+    int size;
+    int squares[10];        // most significant digit first
+};
+
+struct PatternTables
+{
+    std::vector<PatternInstance> instances;
+    int weightCount = 0;
+
+    PatternTables()
+    {
+        struct Coord { int x, y; };
+        // one table per pattern, for each of the given rotations of the squares
+        auto add = [this](std::vector<Coord> coords, int rotations) {
+            int size = (int)coords.size();
+            for(int rotation = 0; rotation < rotations; rotation++) {
+                PatternInstance instance;
+                instance.offset = weightCount;
+                instance.size = size;
+                for(int i = 0; i < size; i++) {
+                    instance.squares[i] = coords[i].y * 8 + coords[i].x;
+                    // a quarter turn for the next one
+                    coords[i] = { 7 - coords[i].y, coords[i].x };
+                }
+                instances.push_back(instance);
+            }
+            int entries = 1;
+            for(int i = 0; i < size; i++) {
+                entries *= 3;
+            }
+            weightCount += entries;
+        };
+
+        std::vector<Coord> edge;
+        for(int x = 0; x < 8; x++) {
+            edge.push_back({ x, 0 });
+        }
+        edge.push_back({ 1, 1 });
+        edge.push_back({ 6, 1 });
+        add(edge, 4);
+
+        std::vector<Coord> corner;
+        for(int y = 0; y < 3; y++) {
+            for(int x = 0; x < 3; x++) {
+                corner.push_back({ x, y });
+            }
+        }
+        add(corner, 4);
+
+        for(int row = 1; row <= 3; row++) {
+            std::vector<Coord> line;
+            for(int x = 0; x < 8; x++) {
+                line.push_back({ x, row });
+            }
+            add(line, 4);
+        }
+
+        // the main diagonal comes back onto itself after half a turn
+        for(int length = 8; length >= 4; length--) {
+            std::vector<Coord> diagonal;
+            for(int i = 0; i < length; i++) {
+                diagonal.push_back({ i + 8 - length, i });
+            }
+            add(diagonal, length == 8 ? 2 : 4);
+        }
+
+        // mobility and the constant
+        weightCount += 2;
+    }
+};
+
+static const PatternTables kPatterns;
+static std::vector<int16_t> patternWeights;
+
+int othelloPatternWeightCount()
+{
+    return kPatterns.weightCount;
+}
+
+int othelloPatternInstanceCount()
+{
+    return (int)kPatterns.instances.size();
+}
+
+int othelloPatternFeatures(const OthelloBoard& board, int player, int* indices, int& mobility)
+{
+    uint64_t own = board.discs[player];
+    uint64_t other = board.discs[player ^ 1];
+    int count = 0;
+    for(const PatternInstance& instance : kPatterns.instances) {
+        int index = 0;
+        for(int i = 0; i < instance.size; i++) {
+            int square = instance.squares[i];
+            index = index * 3 + (int)((own >> square) & 1) + 2 * (int)((other >> square) & 1);
+        }
+        indices[count++] = instance.offset + index;
+    }
+    mobility = std::popcount(OthelloBoard::mobility(own, other)) - std::popcount(OthelloBoard::mobility(other, own));
+    return count;
+}
+
+bool othelloPatternsLoaded()
+{
+    return !patternWeights.empty();
+}
+
+void othelloSetPatterns(const std::vector<int16_t>& weights)
+{
+    patternWeights = weights;
+}
+
+int othelloPatternEvaluate(const OthelloBoard& board, int player)
+{
+    int phase = othelloPhase(std::popcount(board.empty()));
+    const int16_t* weights = patternWeights.data() + (size_t)phase * kPatterns.weightCount;
+    int indices[64];
+    int mobility;
+    int count = othelloPatternFeatures(board, player, indices, mobility);
+    int score = weights[kPatterns.weightCount - 2] * mobility + weights[kPatterns.weightCount - 1];
+    for(int i = 0; i < count; i++) {
+        score += weights[indices[i]];
+    }
+    return score;
+}
+
+bool othelloLoadPatterns(const std::string& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    char magic[4];
+    uint32_t phases = 0, count = 0;
+    if(!in.read(magic, sizeof(magic)) || std::memcmp(magic, kPatternMagic, sizeof(magic)) != 0 ||
+       !in.read((char*)&phases, sizeof(phases)) || !in.read((char*)&count, sizeof(count)) ||
+       phases != kOthelloPhases || count != (uint32_t)kPatterns.weightCount) {
+        return false;
+    }
+    std::vector<int16_t> weights;
+    weights.reserve((size_t)phases * count);
+    int16_t value;
+    while(weights.size() < weights.capacity() && in.read((char*)&value, sizeof(value))) {
+        if(value != kZeroRun) {
+            weights.push_back(value);
+            continue;
+        }
+        uint16_t run;
+        if(!in.read((char*)&run, sizeof(run))) {
+            return false;
+        }
+        weights.insert(weights.end(), run, 0);
+    }
+    if(weights.size() != (size_t)phases * count) {
+        return false;
+    }
+    patternWeights = std::move(weights);
+    return true;
+}
+
+bool othelloSavePatterns(const std::string& path, const std::vector<int16_t>& weights)
+{
+    std::ofstream out(path, std::ios::binary);
+    uint32_t phases = kOthelloPhases;
+    uint32_t count = kPatterns.weightCount;
+    out.write(kPatternMagic, sizeof(kPatternMagic));
+    out.write((const char*)&phases, sizeof(phases));
+    out.write((const char*)&count, sizeof(count));
+    // most pattern entries never come up in games, so most weights are zero
+    for(size_t i = 0; i < weights.size();) {
+        int16_t value = weights[i] == kZeroRun ? kZeroRun + 1 : weights[i];
+        if(value != 0) {
+            out.write((const char*)&value, sizeof(value));
+            i++;
+            continue;
+        }
+        uint16_t run = 0;
+        while(i < weights.size() && weights[i] == 0 && run < UINT16_MAX) {
+            run++;
+            i++;
+        }
+        out.write((const char*)&kZeroRun, sizeof(kZeroRun));
+        out.write((const char*)&run, sizeof(run));
+    }
+    return (bool)out;
+}
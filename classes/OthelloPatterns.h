@@ -0,0 +1,60 @@
+#pragma once
+
+#include "OthelloBoard.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+//
+// pattern based Othello evaluation
+//
+// a pattern is a fixed set of squares, like an edge plus its two X-squares or a
+// corner's 3x3 block. each square is empty, the side to move's or the opponent's, so
+// the squares read in order make a base 3 number that indexes a table of weights, one
+// weight for every way the pattern can be filled. a pattern is looked at in each of
+// its rotations (and for the diagonals each distinct line) with the same table.
+//
+// the patterns:
+//   edge + 2X     an edge and the two X-squares next to it       3^10 weights
+//   corner 3x3    the 3x3 block in a corner                      3^9
+//   row 2, 3, 4   the second to fourth line from an edge         3^8 each
+//   diagonal 8    a main diagonal                                3^8
+//   diagonal 7-4  the shorter diagonals                          3^7 .. 3^4
+// plus a weight for the mobility difference and a constant for the side to move.
+//
+// the game is split into phases by the number of empty squares and each phase has
+// its own tables. weights are in hundredths of a disc, so a position's value is the
+// expected final disc margin for the side to move.
+//
+
+constexpr int kOthelloPhases = 6;
+
+// which set of tables a position with this many empties uses
+inline int othelloPhase(int empties)
+{
+    int phase = empties * kOthelloPhases / 61;
+    return phase < kOthelloPhases ? phase : kOthelloPhases - 1;
+}
+
+// number of weights in one phase, the mobility weight and the constant are the last two
+int othelloPatternWeightCount();
+// pattern squares looked at for each position
+int othelloPatternInstanceCount();
+
+// the weight indices (within a phase) that the position uses for player, one per
+// pattern instance, plus the mobility difference. returns the number of indices.
+int othelloPatternFeatures(const OthelloBoard& board, int player, int* indices, int& mobility);
+
+// weights for all phases, kOthelloPhases * othelloPatternWeightCount() of them.
+// the file is a small header followed by the weights with runs of zeros packed.
+bool othelloLoadPatterns(const std::string& path);
+bool othelloSavePatterns(const std::string& path, const std::vector<int16_t>& weights);
+// replaces the loaded weights, for the trainer
+void othelloSetPatterns(const std::vector<int16_t>& weights);
+bool othelloPatternsLoaded();
+
+// for player, in hundredths of a disc. only meaningful once weights are loaded.
+int othelloPatternEvaluate(const OthelloBoard& board, int player);
+
+// where the game looks for the trained weights, relative to the working directory
+constexpr const char* kOthelloPatternFile = "resources/othello.weights";
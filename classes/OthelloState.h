@@ -0,0 +1,107 @@
+#pragma once
+
+#include "OthelloBoard.h"
+#include "OthelloEval.h"
+#include "Search.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <bit>
+
+//
+// Othello position for the AI: the bitboards plus the side to move. it works with both
+// the alpha-beta search in Search.h and the MCTS in MCTS.h.
+// squares are y * 8 + x in Grid order, player 0 is black and moves first
+//
+struct OthelloState
+{
+    typedef int Move;       // a square, or Pass
+
+    static const int Pass = 64;
+
+    OthelloBoard board;
+    int toMove = 0;
+    // discs turned over by each move so far, indexed by the number of discs before it
+    uint64_t flipped[64] = {};
+
+    // from Othello::stateString(): '1' black, '2' white
+    static OthelloState fromString(const std::string& state, int playerToMove)
+    {
+        OthelloState position;
+        position.toMove = playerToMove;
+        for(int square = 0; square < 64; square++) {
+            if(state[square] == '1') position.board.discs[0] |= 1ULL << square;
+            if(state[square] == '2') position.board.discs[1] |= 1ULL << square;
+        }
+        return position;
+    }
+
+    int sideToMove() const { return toMove; }
+
+    int result(int player) const
+    {
+        int own = board.count(player);
+        int other = board.count(player ^ 1);
+        return own > other ? 2 : own == other ? 1 : 0;
+    }
+
+    void generate(std::vector<Move>& moves) const
+    {
+        uint64_t mask = board.moves(toMove);
+        if(!mask) {
+            // a player with no move passes, unless neither side can move
+            if(board.moves(toMove ^ 1)) {
+                moves.push_back(Pass);
+            }
+            return;
+        }
+        while(mask) {
+            moves.push_back(std::countr_zero(mask));
+            mask &= mask - 1;
+        }
+    }
+
+    void make(const Move& move)
+    {
+        if(move != Pass) {
+            uint64_t& flips = flipped[std::popcount(board.occupied())];
+            flips = board.play(toMove, move);
+        }
+        toMove ^= 1;
+    }
+
+    void unmake(const Move& move)
+    {
+        toMove ^= 1;
+        if(move != Pass) {
+            board.undo(toMove, move, flipped[std::popcount(board.occupied()) - 1]);
+        }
+    }
+
+    int evaluate() const
+    {
+        if(!board.moves(toMove) && !board.moves(toMove ^ 1)) {
+            return othelloFinalScore(board, toMove);
+        }
+        return othelloEvaluate(board, toMove);
+    }
+
+    uint64_t hash() const
+    {
+        return zobristKey(board.discs[0]) ^ (zobristKey(board.discs[1] ^ 0x5555555555555555ULL) * 3) ^ (uint64_t)toMove;
+    }
+
+    // moves that leave the opponent few replies first, corners before everything
+    int orderScore(const Move& move) const
+    {
+        if(move == Pass) {
+            return 0;
+        }
+        uint64_t own = board.discs[toMove];
+        uint64_t other = board.discs[toMove ^ 1];
+        uint64_t flips = OthelloBoard::flips(move, own, other);
+        int replies = std::popcount(OthelloBoard::mobility(other & ~flips, own | flips | (1ULL << move)));
+        bool corner = move == 0 || move == 7 || move == 56 || move == 63;
+        return (corner ? 100 : 0) - replies;
+    }
+};
@@ -0,0 +1,67 @@
+#include "RenderList.h"
+#include "Bit.h"
+#include <algorithm>
+
+RenderList &RenderList::shared()
+{
+    static RenderList list;
+    return list;
+}
+
+void RenderList::insert(Bit *bit)
+{
+    // after everything at the same Z, so the bit that changed last draws on top
+    int z = bit->getLocalZOrder();
+    auto position = std::upper_bound(_bits.begin(), _bits.end(), z, [](int z, Bit *other) {
+        return z < other->getLocalZOrder();
+    });
+    _bits.insert(position, bit);
+}
+
+bool RenderList::erase(Bit *bit)
+{
+    auto found = std::find(_bits.begin(), _bits.end(), bit);
+    if (found == _bits.end()) {
+        return false;
+    }
+    _bits.erase(found);
+    return true;
+}
+
+void RenderList::add(Bit *bit)
+{
+    if (std::find(_bits.begin(), _bits.end(), bit) == _bits.end()) {
+        insert(bit);
+    }
+}
+
+void RenderList::remove(Bit *bit)
+{
+    erase(bit);
+    _animating.erase(std::remove(_animating.begin(), _animating.end(), bit), _animating.end());
+}
+
+void RenderList::restack(Bit *bit)
+{
+    if (erase(bit)) {
+        insert(bit);
+    }
+}
+
+void RenderList::animate(Bit *bit)
+{
+    if (std::find(_animating.begin(), _animating.end(), bit) == _animating.end()) {
+        _animating.push_back(bit);
+    }
+}
+
+void RenderList::update()
+{
+    // a bit that comes to rest restacks itself in the list, this set is only pruned after
+    for (size_t i = 0; i < _animating.size(); i++) {
+        _animating[i]->update();
+    }
+    _animating.erase(std::remove_if(_animating.begin(), _animating.end(), [](Bit *bit) {
+        return !bit->getMoving() && !bit->getFlipping();
+    }), _animating.end());
+}
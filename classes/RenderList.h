@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vector>
+
+class Bit;
+
+//
+// the bits on the board in drawing order, kept between frames
+//
+// drawFrame used to look at every square each frame to find the stationary, moving
+// and picked up pieces. instead the bits are kept here sorted by their Z order
+// (the bitz values in Bit.h), bottom first, and the list only changes when a bit is
+// put in a holder, destroyed, picked up or put down, or starts or stops moving. a bit
+// that changes Z goes on top of the others with the same Z.
+//
+// the bits that are moving or flipping are also kept in a set of their own, so
+// update() only touches those each frame.
+//
+// a bit is listed from the time a holder first takes it until it is destroyed. only
+// used from the thread that draws.
+//
+class RenderList
+{
+public:
+    static RenderList &shared();
+
+    // a holder took the bit, nothing happens if it is already listed
+    void add(Bit *bit);
+    // the bit is going away, from the list and the animations
+    void remove(Bit *bit);
+    // the bit's Z order changed
+    void restack(Bit *bit);
+    // the bit started moving or flipping
+    void animate(Bit *bit);
+
+    // Bit::update() for each animating bit, the ones that come to rest drop out
+    void update();
+    bool animating() const { return !_animating.empty(); }
+
+    // bottom to top
+    const std::vector<Bit *> &bits() const { return _bits; }
+
+private:
+    void insert(Bit *bit);
+    bool erase(Bit *bit);
+
+    std::vector<Bit *> _bits;
+    std::vector<Bit *> _animating;
+};
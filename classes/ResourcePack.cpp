@@ -0,0 +1,248 @@
+#include "ResourcePack.h"
+#include "ThreadPool.h"
+#include "stb_image.h"
+#include <filesystem>
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+static const char kPackMagic[4] = { 'R', 'P', 'K', '1' };
+
+// images are placed on shelves across an atlas this wide
+constexpr int kAtlasWidth = 1024;
+
+struct PackHeader
+{
+    char magic[4];
+    uint32_t width;
+    uint32_t height;
+    uint32_t entryCount;
+};
+
+struct PackEntry
+{
+    char name[64];
+    uint32_t x;
+    uint32_t y;
+    uint32_t width;
+    uint32_t height;
+};
+static_assert(sizeof(PackHeader) == 16 && sizeof(PackEntry) == 80, "pack records must stay packed");
+
+static size_t pixelOffset(size_t entryCount)
+{
+    return (sizeof(PackHeader) + entryCount * sizeof(PackEntry) + 15) & ~(size_t)15;
+}
+
+bool buildAtlas(const std::string& directory, Atlas& atlas, ThreadPool* pool)
+{
+    struct Image
+    {
+        AtlasEntry entry;
+        unsigned char* pixels = nullptr;
+    };
+    std::vector<Image> images;
+    std::vector<std::string> paths;
+    std::error_code error;
+    for(const auto& file : std::filesystem::directory_iterator(directory, error)) {
+        if(file.path().extension() == ".png") {
+            Image image;
+            image.entry.name = file.path().filename().string();
+            images.push_back(image);
+            paths.push_back(file.path().string());
+        }
+    }
+    auto decode = [&](size_t begin, size_t end, int) {
+        for(size_t i = begin; i < end; i++) {
+            images[i].pixels = stbi_load(paths[i].c_str(), &images[i].entry.width, &images[i].entry.height, NULL, 4);
+        }
+    };
+    if(pool) {
+        // one image per task, they differ a lot in size
+        TaskGroup group(*pool);
+        for(size_t i = 0; i < images.size(); i++) {
+            group.run([&decode, i]() { decode(i, i + 1, 0); });
+        }
+        group.wait();
+    } else {
+        decode(0, images.size(), 0);
+    }
+    images.erase(std::remove_if(images.begin(), images.end(), [](const Image& image) { return !image.pixels; }), images.end());
+    if(images.empty()) {
+        return false;
+    }
+
+    std::sort(images.begin(), images.end(), [](const Image& a, const Image& b) {
+        return a.entry.height != b.entry.height ? a.entry.height > b.entry.height : a.entry.name < b.entry.name;
+    });
+    atlas.width = kAtlasWidth;
+    for(const Image& image : images) {
+        atlas.width = std::max(atlas.width, image.entry.width + 2);
+    }
+    int x = 0;
+    int y = 0;
+    int shelf = 0;
+    for(Image& image : images) {
+        if(x + image.entry.width + 2 > atlas.width) {
+            x = 0;
+            y += shelf;
+            shelf = 0;
+        }
+        image.entry.x = x + 1;
+        image.entry.y = y + 1;
+        x += image.entry.width + 2;
+        shelf = std::max(shelf, image.entry.height + 2);
+    }
+    atlas.height = y + shelf;
+
+    atlas.pixels.assign((size_t)atlas.width * atlas.height * 4, 0);
+    atlas.entries.clear();
+    for(const Image& image : images) {
+        const AtlasEntry& entry = image.entry;
+        for(int row = -1; row <= entry.height; row++) {
+            int sourceRow = std::clamp(row, 0, entry.height - 1);
+            for(int column = -1; column <= entry.width; column++) {
+                int sourceColumn = std::clamp(column, 0, entry.width - 1);
+                const unsigned char* source = image.pixels + ((size_t)sourceRow * entry.width + sourceColumn) * 4;
+                unsigned char* target = atlas.pixels.data() + ((size_t)(entry.y + row) * atlas.width + entry.x + column) * 4;
+                std::copy(source, source + 4, target);
+            }
+        }
+        stbi_image_free(image.pixels);
+        atlas.entries.push_back(entry);
+    }
+    return true;
+}
+
+bool writeResourcePack(const std::string& path, const Atlas& atlas)
+{
+    std::ofstream out(path, std::ios::binary);
+    PackHeader header;
+    std::memcpy(header.magic, kPackMagic, sizeof(kPackMagic));
+    header.width = atlas.width;
+    header.height = atlas.height;
+    header.entryCount = (uint32_t)atlas.entries.size();
+    out.write((const char*)&header, sizeof(header));
+    for(const AtlasEntry& entry : atlas.entries) {
+        PackEntry record = {};
+        if(entry.name.size() >= sizeof(record.name)) {
+            return false;
+        }
+        std::memcpy(record.name, entry.name.c_str(), entry.name.size());
+        record.x = entry.x;
+        record.y = entry.y;
+        record.width = entry.width;
+        record.height = entry.height;
+        out.write((const char*)&record, sizeof(record));
+    }
+    size_t written = sizeof(header) + atlas.entries.size() * sizeof(PackEntry);
+    static const char kZeros[16] = {};
+    out.write(kZeros, pixelOffset(atlas.entries.size()) - written);
+    out.write((const char*)atlas.pixels.data(), atlas.pixels.size());
+    return (bool)out;
+}
+
+bool ResourcePack::open(const std::string& path)
+{
+    close();
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size;
+    HANDLE mapping = GetFileSizeEx(file, &size) ? CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL) : NULL;
+    const void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if(!view) {
+        if(mapping) CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    _file = file;
+    _mapping = mapping;
+    _size = (size_t)size.QuadPart;
+#else
+    int file = ::open(path.c_str(), O_RDONLY);
+    if(file < 0) {
+        return false;
+    }
+    struct stat info;
+    void* view = fstat(file, &info) == 0 && info.st_size > 0 ? mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, file, 0) : MAP_FAILED;
+    // the mapping keeps the file open on its own
+    ::close(file);
+    if(view == MAP_FAILED) {
+        return false;
+    }
+    _size = info.st_size;
+#endif
+    _data = (const unsigned char*)view;
+
+    PackHeader header;
+    if(_size < sizeof(header)) {
+        close();
+        return false;
+    }
+    std::memcpy(&header, _data, sizeof(header));
+    size_t offset = pixelOffset(header.entryCount);
+    if(std::memcmp(header.magic, kPackMagic, sizeof(kPackMagic)) != 0 || offset > _size ||
+       (_size - offset) / 4 / std::max<size_t>(header.width, 1) < header.height) {
+        close();
+        return false;
+    }
+    for(uint32_t i = 0; i < header.entryCount; i++) {
+        PackEntry record;
+        std::memcpy(&record, _data + sizeof(header) + i * sizeof(record), sizeof(record));
+        record.name[sizeof(record.name) - 1] = 0;
+        AtlasEntry entry;
+        entry.name = record.name;
+        entry.x = record.x;
+        entry.y = record.y;
+        entry.width = record.width;
+        entry.height = record.height;
+        _entries.push_back(entry);
+    }
+    _width = header.width;
+    _height = header.height;
+    _pixels = _data + offset;
+    return true;
+}
+
+unsigned ResourcePack::touch() const
+{
+    unsigned sum = 0;
+    size_t bytes = (size_t)_width * _height * 4;
+    for(size_t i = 0; i < bytes; i += 4096) {
+        sum += _pixels[i];
+    }
+    return sum;
+}
+
+void ResourcePack::close()
+{
+    if(_data) {
+#ifdef _WIN32
+        UnmapViewOfFile(_data);
+        CloseHandle(_mapping);
+        CloseHandle(_file);
+        _file = _mapping = nullptr;
+#else
+        munmap((void*)_data, _size);
+#endif
+    }
+    _data = nullptr;
+    _pixels = nullptr;
+    _size = 0;
+    _width = _height = 0;
+    _entries.clear();
+}
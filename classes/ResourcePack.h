@@ -0,0 +1,81 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+//
+// pre-decoded resource pack
+//
+// the PNGs in resources/ are decoded and packed into one RGBA atlas by a build step
+// (`enginetool pack-resources`) and written out as a single file: a header, an index
+// of where each image sits in the atlas, and the raw pixels. the game memory maps the
+// file and uploads the atlas straight from the mapping, so nothing is decoded when it
+// starts. without a pack the same atlas is built from the PNGs at run time.
+//
+// layout, all little endian:
+//   "RPK1", width, height, entry count      4 x 4 bytes
+//   entries: name[64], x, y, width, height  80 bytes each
+//   pixels, width * height * 4 bytes, starting on a 16 byte boundary
+//
+
+constexpr const char* kResourcePackFile = "resources.pack";
+
+struct AtlasEntry
+{
+    std::string name;
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+};
+
+struct Atlas
+{
+    int width = 0;
+    int height = 0;
+    std::vector<AtlasEntry> entries;
+    std::vector<unsigned char> pixels;     // RGBA rows
+};
+
+class ThreadPool;
+
+// decodes every PNG in directory and packs them onto shelves, tallest first, each with
+// a one pixel border copied from its edge so filtering never blends in a neighbour.
+// with a pool the images are decoded in parallel. false when there were no images.
+bool buildAtlas(const std::string& directory, Atlas& atlas, ThreadPool* pool = nullptr);
+bool writeResourcePack(const std::string& path, const Atlas& atlas);
+
+// a pack file mapped into memory, the pixels are read straight from the mapping
+class ResourcePack
+{
+public:
+    ResourcePack() {}
+    ~ResourcePack() { close(); }
+
+    ResourcePack(const ResourcePack&) = delete;
+    ResourcePack& operator=(const ResourcePack&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    int width() const { return _width; }
+    int height() const { return _height; }
+    const unsigned char* pixels() const { return _pixels; }
+    const std::vector<AtlasEntry>& entries() const { return _entries; }
+    // reads every page of the pixels so the upload doesn't wait on the disk
+    unsigned touch() const;
+
+private:
+    const unsigned char* _data = nullptr;
+    size_t _size = 0;
+#ifdef _WIN32
+    void* _file = nullptr;
+    void* _mapping = nullptr;
+#endif
+    int _width = 0;
+    int _height = 0;
+    const unsigned char* _pixels = nullptr;
+    std::vector<AtlasEntry> _entries;
+};
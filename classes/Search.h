@@ -0,0 +1,354 @@
+#pragma once
+
+#include <concepts>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <cstdint>
+#include <algorithm>
+
+//
+// generic alpha-beta search shared by the games
+//
+// negamax with iterative deepening, a transposition table, killer moves and a time
+// budget. each game describes its positions with a small type:
+//
+//     typedef ... Move;                               default constructible, ==
+//     void generate(std::vector<Move>& moves) const;  appends, none exactly when the game is over
+//     void make(const Move& move);
+//     void unmake(const Move& move);                  undoes the last make of this move
+//     int  evaluate() const;                          for the side to move
+//     uint64_t hash() const;
+//     int  sideToMove() const;                        0 or 1
+//
+// a finished game is evaluated as kSearchWin or more for a win, -kSearchWin or less for a
+// loss. the search shortens wins and lengthens losses by the distance from the root, so
+// the quickest win is preferred. a side can move several times in a row (a multi-jump),
+// the score is only negated when the side to move changes.
+//
+// optionally the position can provide `int orderScore(const Move& move) const`, moves
+// with a higher score are tried first after the transposition table and killer moves.
+//
+
+constexpr int kSearchWin = 1000000;
+constexpr int kSearchInfinity = 2 * kSearchWin;
+constexpr int kSearchMaxPly = 128;
+
+// a well mixed 64 bit key for Zobrist hashing, index is whatever the position
+// numbers its (piece, square) pairs by
+constexpr uint64_t zobristKey(uint64_t index)
+{
+    uint64_t key = (index + 1) * 0x9E3779B97F4A7C15ULL;
+    key = (key ^ (key >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    key = (key ^ (key >> 27)) * 0x94D049BB133111EBULL;
+    return key ^ (key >> 31);
+}
+
+template<typename P>
+concept SearchPosition = requires(P position, const P& constPosition, const typename P::Move& move, std::vector<typename P::Move>& moves) {
+    constPosition.generate(moves);
+    position.make(move);
+    position.unmake(move);
+    { constPosition.evaluate() } -> std::convertible_to<int>;
+    { constPosition.hash() } -> std::convertible_to<uint64_t>;
+    { constPosition.sideToMove() } -> std::convertible_to<int>;
+} && std::default_initializable<typename P::Move> && std::equality_comparable<typename P::Move>;
+
+struct GameSearchLimits
+{
+    int depth = kSearchMaxPly - 1;
+    int timeMs = 0;             // 0 = no time limit
+    uint64_t nodes = 0;         // 0 = no node limit
+    // stops the search once set, polled with the limits and never cleared by the search,
+    // so it can be set before run() starts
+    const std::atomic<bool>* cancel = nullptr;
+};
+
+template<typename Move>
+struct GameSearchResult
+{
+    Move bestMove{};
+    bool found = false;         // false when the game is already over
+    bool exact = false;         // the whole game tree was searched, the score is the result
+    int score = 0;              // for the side to move at the root
+    int depth = 0;              // last completed iteration
+    uint64_t nodes = 0;
+    int timeMs = 0;
+};
+
+template<SearchPosition Position>
+class Search
+{
+public:
+    typedef typename Position::Move Move;
+    typedef std::function<void(const GameSearchResult<Move>&)> IterationCallback;
+
+    // ttEntries is rounded down to a power of two
+    explicit Search(size_t ttEntries = 1 << 18)
+    {
+        size_t size = 1;
+        while(size * 2 <= ttEntries) {
+            size *= 2;
+        }
+        _tt.resize(size);
+    }
+
+    void clear()
+    {
+        std::fill(_tt.begin(), _tt.end(), TTEntry());
+    }
+
+    // safe to call from another thread while run() is searching
+    void stop() { _stop = true; }
+
+    // searches position to the limits and returns it unchanged. onIteration is called
+    // after every completed depth, on the searching thread.
+    GameSearchResult<Move> run(Position& position, const GameSearchLimits& limits, const IterationCallback& onIteration = nullptr)
+    {
+        GameSearchResult<Move> result;
+        std::vector<Move> rootMoves;
+        position.generate(rootMoves);
+        if(rootMoves.empty()) {
+            return result;
+        }
+        result.found = true;
+        result.bestMove = rootMoves[0];
+
+        _limits = limits;
+        _stop = false;
+        _nodes = 0;
+        _start = std::chrono::steady_clock::now();
+        for(auto& killers : _killers) {
+            killers[0] = killers[1] = Move();
+        }
+
+        int side = position.sideToMove();
+        for(int depth = 1; depth <= std::min(limits.depth, kSearchMaxPly - 1); depth++) {
+            checkLimits();
+            if(_stop) {
+                break;
+            }
+            _horizonReached = false;
+            int alpha = -kSearchInfinity;
+            Move best = rootMoves[0];
+            for(const Move& move : rootMoves) {
+                position.make(move);
+                int score = position.sideToMove() == side ? negamax(position, depth - 1, 1, alpha, kSearchInfinity)
+                                                          : -negamax(position, depth - 1, 1, -kSearchInfinity, -alpha);
+                position.unmake(move);
+                if(_stop) {
+                    break;
+                }
+                if(score > alpha) {
+                    alpha = score;
+                    best = move;
+                }
+            }
+            if(_stop) {
+                break;
+            }
+
+            // the best move goes first next time
+            std::rotate(rootMoves.begin(), std::find(rootMoves.begin(), rootMoves.end(), best), std::find(rootMoves.begin(), rootMoves.end(), best) + 1);
+            result.bestMove = best;
+            result.score = alpha;
+            result.depth = depth;
+            result.exact = !_horizonReached;
+            result.nodes = _nodes;
+            result.timeMs = elapsedMs();
+            if(onIteration) {
+                onIteration(result);
+            }
+            // nothing more to learn once every line reached the end of the game, or the game is decided
+            if(result.exact || std::abs(alpha) >= kSearchWin - kSearchMaxPly) {
+                break;
+            }
+            // a deeper iteration takes several times as long, don't start one that can't finish
+            if(_limits.timeMs && result.timeMs * 2 >= _limits.timeMs) {
+                break;
+            }
+        }
+        result.nodes = _nodes;
+        result.timeMs = elapsedMs();
+        return result;
+    }
+
+private:
+    enum Bound : uint8_t
+    {
+        BoundNone,
+        BoundExact,
+        BoundLower,
+        BoundUpper
+    };
+
+    // the depth stored for a subtree searched to the end of the game, good at any depth
+    static const int kCompleteDepth = 127;
+
+    struct TTEntry
+    {
+        uint64_t key = 0;
+        Move move{};
+        int32_t score = 0;
+        int8_t depth = 0;
+        uint8_t bound = BoundNone;
+    };
+
+    int elapsedMs() const
+    {
+        return (int)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _start).count();
+    }
+
+    void checkLimits()
+    {
+        if(_limits.cancel && *_limits.cancel) {
+            _stop = true;
+        }
+        if((_limits.nodes && _nodes >= _limits.nodes) || (_limits.timeMs && elapsedMs() >= _limits.timeMs)) {
+            _stop = true;
+        }
+    }
+
+    int negamax(Position& position, int depth, int ply, int alpha, int beta)
+    {
+        if((++_nodes & 1023) == 0) {
+            checkLimits();
+        }
+        if(_stop) {
+            return 0;
+        }
+
+        std::vector<Move>& moves = _moves[ply];
+        moves.clear();
+        position.generate(moves);
+        if(moves.empty()) {
+            int score = position.evaluate();
+            if(score >= kSearchWin) return score - ply;
+            if(score <= -kSearchWin) return score + ply;
+            return score;
+        }
+        if(depth <= 0 || ply >= kSearchMaxPly - 1) {
+            _horizonReached = true;
+            return position.evaluate();
+        }
+
+        uint64_t key = position.hash();
+        TTEntry& entry = _tt[key & (_tt.size() - 1)];
+        Move ttMove{};
+        bool hasTTMove = false;
+        if(entry.key == key && entry.bound != BoundNone) {
+            ttMove = entry.move;
+            hasTTMove = true;
+            if(entry.depth >= depth) {
+                int score = fromTT(entry.score, ply);
+                if(entry.bound == BoundExact ||
+                   (entry.bound == BoundLower && score >= beta) ||
+                   (entry.bound == BoundUpper && score <= alpha)) {
+                    if(entry.depth < kCompleteDepth) {
+                        _horizonReached = true;
+                    }
+                    return score;
+                }
+            }
+        }
+
+        orderMoves(position, moves, ply, hasTTMove ? &ttMove : nullptr);
+
+        // whether this subtree reaches the end of the game everywhere, kept apart from the rest of the tree
+        bool outerHorizon = _horizonReached;
+        _horizonReached = false;
+
+        int side = position.sideToMove();
+        int originalAlpha = alpha;
+        int bestScore = -kSearchInfinity;
+        Move bestMove = moves[0];
+        for(size_t i = 0; i < moves.size(); i++) {
+            Move move = moves[i];
+            position.make(move);
+            int score = position.sideToMove() == side ? negamax(position, depth - 1, ply + 1, alpha, beta)
+                                                      : -negamax(position, depth - 1, ply + 1, -beta, -alpha);
+            position.unmake(move);
+            if(_stop) {
+                return 0;
+            }
+            if(score > bestScore) {
+                bestScore = score;
+                bestMove = move;
+            }
+            if(score > alpha) {
+                alpha = score;
+            }
+            if(alpha >= beta) {
+                if(!(_killers[ply][0] == move)) {
+                    _killers[ply][1] = _killers[ply][0];
+                    _killers[ply][0] = move;
+                }
+                break;
+            }
+        }
+
+        bool complete = !_horizonReached;
+        _horizonReached = _horizonReached || outerHorizon;
+        entry.key = key;
+        entry.move = bestMove;
+        entry.score = toTT(bestScore, ply);
+        entry.depth = (int8_t)(complete ? kCompleteDepth : std::min(depth, kCompleteDepth - 1));
+        entry.bound = bestScore <= originalAlpha ? BoundUpper : bestScore >= beta ? BoundLower : BoundExact;
+        return bestScore;
+    }
+
+    // transposition table move, then killers, then the position's own ordering
+    void orderMoves(const Position& position, std::vector<Move>& moves, int ply, const Move* ttMove)
+    {
+        std::vector<int>& scores = _scores[ply];
+        scores.resize(moves.size());
+        for(size_t i = 0; i < moves.size(); i++) {
+            int score = 0;
+            if constexpr(requires { { position.orderScore(moves[i]) } -> std::convertible_to<int>; }) {
+                score = position.orderScore(moves[i]);
+            }
+            if(ttMove && moves[i] == *ttMove) score = kSearchInfinity;
+            else if(moves[i] == _killers[ply][0]) score = kSearchWin;
+            else if(moves[i] == _killers[ply][1]) score = kSearchWin - 1;
+            scores[i] = score;
+        }
+        // insertion sort, move lists are short
+        for(size_t i = 1; i < moves.size(); i++) {
+            Move move = moves[i];
+            int score = scores[i];
+            size_t j = i;
+            for(; j > 0 && scores[j - 1] < score; j--) {
+                moves[j] = moves[j - 1];
+                scores[j] = scores[j - 1];
+            }
+            moves[j] = move;
+            scores[j] = score;
+        }
+    }
+
+    // win scores are stored relative to the node, not the root
+    static int toTT(int score, int ply)
+    {
+        if(score >= kSearchWin - kSearchMaxPly) return score + ply;
+        if(score <= -kSearchWin + kSearchMaxPly) return score - ply;
+        return score;
+    }
+
+    static int fromTT(int score, int ply)
+    {
+        if(score >= kSearchWin - kSearchMaxPly) return score - ply;
+        if(score <= -kSearchWin + kSearchMaxPly) return score + ply;
+        return score;
+    }
+
+    std::vector<TTEntry> _tt;
+    std::vector<Move> _moves[kSearchMaxPly];
+    std::vector<int> _scores[kSearchMaxPly];
+    Move _killers[kSearchMaxPly][2];
+    GameSearchLimits _limits;
+    std::atomic<bool> _stop{false};
+    bool _horizonReached = false;
+    uint64_t _nodes = 0;
+    std::chrono::steady_clock::time_point _start;
+};
@@ -1,33 +1,44 @@
 #include "Sprite.h"
+#include "TextureCache.h"
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
-#include <iostream>
-#include <filesystem>
 
-// Simple helper function to load an image into a OpenGL texture with common settings
+// Sprites showing the same file share one texture from the cache
 bool Sprite::LoadTextureFromFile(const char* filename)
 {
-    // Load from file
-    int image_width = 0;
-    int image_height = 0;
-    std::filesystem::path resourcePath = std::filesystem::path("resources") / filename;
-    std::string newFilename = resourcePath.string();
-    unsigned char* image_data = stbi_load(newFilename.c_str(), &image_width, &image_height, NULL, 4);
-    if (image_data == NULL) {
+    CachedTexture texture;
+    if (!TextureCache::shared().acquire(filename, texture)) {
+        releaseTexture();
         _size = ImVec2(0, 0);
-        std::cout << "Failed to load texture: " << newFilename << std::endl;
         return false;
     }
-    _texture = _loadTextureFromMemory(image_data, image_width, image_height);
-    stbi_image_free(image_data);
-    if (_texture == 0) {
-        _size = ImVec2(0, 0);
-        return false;
-    }
-    _size = ImVec2((float)image_width, (float)image_height);
+    // the old texture goes after the new one is held, reloading the same file keeps it alive
+    releaseTexture();
+    _texture = texture.texture;
+    _size = texture.size;
+    _uv0 = texture.uv0;
+    _uv1 = texture.uv1;
     return true;
 }
 
+void Sprite::setTexture(ImTextureID texture, const ImVec2 &size, const ImVec2 &uv0, const ImVec2 &uv1)
+{
+    bool cached = TextureCache::shared().retain(texture);
+    releaseTexture();
+    _texture = cached ? texture : 0;
+    _size = size;
+    _uv0 = uv0;
+    _uv1 = uv1;
+}
+
+void Sprite::releaseTexture()
+{
+    if (_texture) {
+        TextureCache::shared().release(_texture);
+        _texture = 0;
+    }
+}
+
 void Sprite::setHighlighted(bool highlighted)
 {
 	if (highlighted != _highlighted) {
@@ -60,6 +71,12 @@ ImTextureID Sprite::_loadTextureFromMemory(const unsigned char *image_data, int
     return static_cast<ImTextureID>(image_texture);
 }
 
+void Sprite::_freeTexture(ImTextureID texture)
+{
+    GLuint image_texture = (GLuint)texture;
+    glDeleteTextures(1, &image_texture);
+}
+
 #else
 
 // DirectX
@@ -117,5 +134,10 @@ ImTextureID Sprite::_loadTextureFromMemory(const unsigned char *image_data, int
     }
     return reinterpret_cast<ImTextureID>(shaderResourceView);
 }
+
+void Sprite::_freeTexture(ImTextureID texture)
+{
+    reinterpret_cast<ID3D11ShaderResourceView*>(texture)->Release();
+}
 #endif
 
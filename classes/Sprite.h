@@ -16,11 +16,14 @@ public:
         _scale(1),
         _color(1, 1, 1, 1),
         _localZOrder(0),
+        _texture(0),
+        _uv0(0, 0),
+        _uv1(1, 1),
         _highlighted(false)
         { 
             _entityType = EntitySprite;
         };
-    ~Sprite() { if (_retainCount > 0) release(); }
+    ~Sprite() { releaseTexture(); if (_retainCount > 0) release(); }
     
     // set the texture to use for this sprite
     void setPosition(float x, float y)
@@ -66,7 +69,7 @@ public:
         {
             ImGui::SetCursorPos(_location);
             ImVec4 highlight = _highlighted ? ImVec4(1, 1, 0, 1) : ImVec4(0, 0, 0, 0);
-            ImGui::Image((void*)(intptr_t)_texture, _size, ImVec2(0, 0), ImVec2(1, 1), _color, highlight);
+            ImGui::Image((void*)(intptr_t)_texture, _size, _uv0, _uv1, _color, highlight);
         }
     }
 	// is the mouse over this position?
@@ -75,7 +78,16 @@ public:
         return (mousePos.x >= _location.x && mousePos.x <= _location.x + _size.x && mousePos.y >= _location.y && mousePos.y <= _location.y + _size.y);
     }
 
+    // the file's texture from the shared TextureCache, only the first sprite to ask decodes it
     bool LoadTextureFromFile(const char* filename);
+    // share a texture that is already loaded, no file or GPU work. the uvs pick
+    // the image out of an atlas
+    void setTexture(ImTextureID texture, const ImVec2 &size, const ImVec2 &uv0 = ImVec2(0, 0), const ImVec2 &uv1 = ImVec2(1, 1));
+    ImTextureID getTexture() const { return _texture; }
+    const ImVec2 &getSize() const { return _size; }
+    const ImVec2 &getUV0() const { return _uv0; }
+    const ImVec2 &getUV1() const { return _uv1; }
+    const ImVec4 &getColor() const { return _color; }
 	
     // set the highlighted state
 	virtual void	setHighlighted(bool yes);
@@ -102,8 +114,15 @@ protected:
     int _localZOrder;
     // the texture we're going to draw
     ImTextureID _texture;
+    // the part of the texture to draw, all of it unless it's in the atlas
+    ImVec2  _uv0;
+    ImVec2  _uv1;
     // currently highlighted
    	bool	_highlighted;
-    // private platform specific texture loading
-    ImTextureID _loadTextureFromMemory(const unsigned char *image_data, int image_width, int image_height);
+    // gives our reference to the texture back to the cache
+    void releaseTexture();
+    // private platform specific texture loading, used by the TextureCache
+    friend class TextureCache;
+    static ImTextureID _loadTextureFromMemory(const unsigned char *image_data, int image_width, int image_height);
+    static void _freeTexture(ImTextureID texture);
 };
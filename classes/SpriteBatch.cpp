@@ -0,0 +1,65 @@
+#include "SpriteBatch.h"
+#include <algorithm>
+
+void SpriteBatch::add(Sprite &sprite)
+{
+    const ImVec2 &size = sprite.getSize();
+    if (size.x <= 0.0f || size.y <= 0.0f || !sprite.getTexture()) {
+        return;
+    }
+    const ImVec2 &position = sprite.getPosition();
+    Quad quad;
+    quad.texture = sprite.getTexture();
+    quad.min = position;
+    quad.max = ImVec2(position.x + size.x, position.y + size.y);
+    quad.uv0 = sprite.getUV0();
+    quad.uv1 = sprite.getUV1();
+    quad.color = ImGui::ColorConvertFloat4ToU32(sprite.getColor());
+    quad.highlighted = sprite.highlighted();
+    _quads.push_back(quad);
+    _extent = ImVec2(std::max(_extent.x, quad.max.x), std::max(_extent.y, quad.max.y));
+}
+
+void SpriteBatch::flush()
+{
+    if (_quads.empty()) {
+        return;
+    }
+    ImDrawList *drawList = ImGui::GetWindowDrawList();
+    ImVec2 windowPos = ImGui::GetWindowPos();
+    ImVec2 origin = ImVec2(windowPos.x - ImGui::GetScrollX(), windowPos.y - ImGui::GetScrollY());
+
+    // one block of quads for each run of the same texture
+    for (size_t start = 0; start < _quads.size();) {
+        size_t end = start;
+        while (end < _quads.size() && _quads[end].texture == _quads[start].texture) {
+            end++;
+        }
+        int count = (int)(end - start);
+        drawList->PushTexture(ImTextureRef(_quads[start].texture));
+        drawList->PrimReserve(count * 6, count * 4);
+        for (size_t i = start; i < end; i++) {
+            const Quad &quad = _quads[i];
+            drawList->PrimRectUV(ImVec2(origin.x + quad.min.x, origin.y + quad.min.y), ImVec2(origin.x + quad.max.x, origin.y + quad.max.y),
+                                 quad.uv0, quad.uv1, quad.color);
+        }
+        drawList->PopTexture();
+        start = end;
+    }
+
+    // the highlight border ImGui::Image used to draw
+    for (const Quad &quad : _quads) {
+        if (quad.highlighted) {
+            drawList->AddRect(ImVec2(origin.x + quad.min.x, origin.y + quad.min.y), ImVec2(origin.x + quad.max.x, origin.y + quad.max.y),
+                              IM_COL32(255, 255, 0, 255));
+        }
+    }
+    _quads.clear();
+}
+
+ImVec2 SpriteBatch::takeExtent()
+{
+    ImVec2 extent = _extent;
+    _extent = ImVec2(0, 0);
+    return extent;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Sprite.h"
+#include <vector>
+
+//
+// draws many sprites into the current window's ImDrawList in as few draw calls as
+// possible
+//
+// sprites are collected with add() and written out by flush(). consecutive sprites
+// that share a texture go out between one PushTexture and PopTexture as a single
+// reserved block of quads, so a layer whose images all come from the texture atlas
+// is one draw call. paint order is kept. positions are window coordinates, the
+// same as ImGui::SetCursorPos.
+//
+class SpriteBatch
+{
+public:
+    void add(Sprite &sprite);
+    // draws everything added since the last flush into the current window
+    void flush();
+    // bottom right corner of all the sprites flushed so far, and reset it
+    ImVec2 takeExtent();
+
+private:
+    struct Quad
+    {
+        ImTextureID texture;
+        ImVec2 min;
+        ImVec2 max;
+        ImVec2 uv0;
+        ImVec2 uv1;
+        ImU32 color;
+        bool highlighted;
+    };
+
+    std::vector<Quad> _quads;
+    ImVec2 _extent = ImVec2(0, 0);
+};
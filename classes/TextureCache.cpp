@@ -0,0 +1,185 @@
+#include "TextureCache.h"
+#include "Sprite.h"
+#include "ResourcePack.h"
+#include "ThreadPool.h"
+#include "stb_image.h"
+#include <filesystem>
+#include <iostream>
+#include <chrono>
+
+TextureCache& TextureCache::shared()
+{
+    // a preload runs on the shared pool, constructing it first makes it outlive the cache
+    ThreadPool::shared();
+    static TextureCache cache;
+    return cache;
+}
+
+bool TextureCache::acquire(const std::string& name, CachedTexture& texture)
+{
+    if (!_atlasBuilt) {
+        buildAtlas();
+    }
+    auto packed = _atlas.find(name);
+    if (packed != _atlas.end()) {
+        texture = packed->second;
+        return true;
+    }
+
+    auto found = _entries.find(name);
+    if (found != _entries.end()) {
+        found->second.references++;
+        texture = found->second.texture;
+        return true;
+    }
+
+    std::string path = (std::filesystem::path("resources") / name).string();
+    int width = 0;
+    int height = 0;
+    unsigned char* pixels = stbi_load(path.c_str(), &width, &height, NULL, 4);
+    if (pixels == NULL) {
+        std::cout << "Failed to load texture: " << path << std::endl;
+        return false;
+    }
+    _loads++;
+    ImTextureID id = Sprite::_loadTextureFromMemory(pixels, width, height);
+    stbi_image_free(pixels);
+    if (id == 0) {
+        return false;
+    }
+
+    Entry& entry = _entries[name];
+    entry.texture.texture = id;
+    entry.texture.size = ImVec2((float)width, (float)height);
+    entry.references = 1;
+    _names[id] = name;
+    texture = entry.texture;
+    return true;
+}
+
+bool TextureCache::retain(ImTextureID texture)
+{
+    if (texture && texture == _atlasTexture) {
+        return true;
+    }
+    auto found = _names.find(texture);
+    if (found == _names.end()) {
+        return false;
+    }
+    _entries[found->second].references++;
+    return true;
+}
+
+void TextureCache::release(ImTextureID texture)
+{
+    auto found = _names.find(texture);
+    if (found == _names.end()) {
+        return;
+    }
+    auto entry = _entries.find(found->second);
+    if (--entry->second.references > 0) {
+        return;
+    }
+    Sprite::_freeTexture(texture);
+    _entries.erase(entry);
+    _names.erase(found);
+}
+
+// the atlas pixels, ready to upload
+struct TextureCache::PreparedAtlas
+{
+    ResourcePack pack;
+    Atlas decoded;
+    bool fromPack = false;
+    bool ready = false;
+    double ms = 0;
+};
+
+void TextureCache::prepareAtlas(PreparedAtlas& atlas, bool parallel)
+{
+    auto start = std::chrono::steady_clock::now();
+    if (atlas.pack.open((std::filesystem::path("resources") / kResourcePackFile).string())) {
+        atlas.pack.touch();
+        atlas.fromPack = true;
+        atlas.ready = true;
+    } else {
+        atlas.ready = ::buildAtlas("resources", atlas.decoded, parallel ? &ThreadPool::shared() : nullptr);
+    }
+    atlas.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void TextureCache::preload()
+{
+    if (_atlasBuilt || _preload) {
+        return;
+    }
+    _prepared = std::make_unique<PreparedAtlas>();
+    _preloadDone = false;
+    _preload = std::make_unique<TaskGroup>(ThreadPool::shared(), TaskBackground);
+    _preload->run([this]() {
+        prepareAtlas(*_prepared, true);
+        _preloadDone = true;
+    });
+}
+
+void TextureCache::update()
+{
+    if (_preload && _preloadDone) {
+        finishPreload();
+    }
+}
+
+void TextureCache::finishPreload()
+{
+    _preload->wait();
+    _preload.reset();
+    uploadAtlas(*_prepared);
+    _prepared.reset();
+}
+
+void TextureCache::buildAtlas()
+{
+    if (_preload) {
+        finishPreload();
+        return;
+    }
+    PreparedAtlas atlas;
+    prepareAtlas(atlas, false);
+    uploadAtlas(atlas);
+}
+
+void TextureCache::uploadAtlas(PreparedAtlas& atlas)
+{
+    _atlasBuilt = true;
+    if (!atlas.ready) {
+        return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    const unsigned char* pixels = atlas.fromPack ? atlas.pack.pixels() : atlas.decoded.pixels.data();
+    int width = atlas.fromPack ? atlas.pack.width() : atlas.decoded.width;
+    int height = atlas.fromPack ? atlas.pack.height() : atlas.decoded.height;
+    const std::vector<AtlasEntry>& entries = atlas.fromPack ? atlas.pack.entries() : atlas.decoded.entries;
+    if (!atlas.fromPack) {
+        _loads += (int)entries.size();
+    }
+
+    // without an atlas every file is loaded on its own
+    ImTextureID id = Sprite::_loadTextureFromMemory(pixels, width, height);
+    if (id == 0) {
+        return;
+    }
+    _atlasTexture = id;
+    _atlasSize = ImVec2((float)width, (float)height);
+    _atlasFromPack = atlas.fromPack;
+    for (const AtlasEntry& entry : entries) {
+        CachedTexture& texture = _atlas[entry.name];
+        texture.texture = id;
+        texture.size = ImVec2((float)entry.width, (float)entry.height);
+        texture.uv0 = ImVec2((float)entry.x / width, (float)entry.y / height);
+        texture.uv1 = ImVec2((float)(entry.x + entry.width) / width, (float)(entry.y + entry.height) / height);
+    }
+    _atlasMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    _preloadMs = atlas.ms;
+    std::cout << "Texture atlas " << width << "x" << height << " " << (_atlasFromPack ? "mapped from " : "decoded for lack of ")
+              << kResourcePackFile << " in " << _preloadMs << "ms, uploaded in " << _atlasMs << "ms" << std::endl;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "../imgui/imgui.h"
+#include <string>
+#include <unordered_map>
+#include <memory>
+#include <atomic>
+
+//
+// shared, reference counted textures for the sprites
+//
+// there are only a handful of images (the pieces, the board squares) but every piece
+// used to decode its PNG and upload a texture of its own, which were never freed. the
+// cache decodes and uploads each file in resources/ the first time it is asked for
+// and hands out the same texture after that. sprites hold a reference while they
+// show a texture, the last release frees it on the GPU.
+//
+// every PNG in resources/ is packed into one atlas texture the first time the cache
+// is used, from the pre-decoded resources.pack when there is one (ResourcePack.h), and the cached textures of those files are rectangles of it, so a whole
+// board draws from a single texture (see SpriteBatch). the atlas stays for the life
+// of the program. files that aren't in it are loaded and counted on their own.
+//
+// preload() gets the atlas ready on the shared thread pool while the program starts:
+// the pack is read in, or without one the PNGs are decoded in parallel and packed.
+// only the GPU upload is left for the drawing thread, which update() does once the
+// workers are done. an acquire() that comes first waits for them instead.
+//
+// apart from the preload workers, only used from the thread that draws.
+//
+
+class TaskGroup;
+
+struct CachedTexture
+{
+    ImTextureID texture = 0;
+    ImVec2 size = ImVec2(0, 0);
+    ImVec2 uv0 = ImVec2(0, 0);
+    ImVec2 uv1 = ImVec2(1, 1);
+};
+
+class TextureCache
+{
+public:
+    static TextureCache& shared();
+
+    // the texture for a file in resources/, loaded on first use. a successful
+    // acquire takes a reference that is given back with release()
+    bool acquire(const std::string& name, CachedTexture& texture);
+    // another reference to a texture from acquire(), false for any other texture
+    bool retain(ImTextureID texture);
+    // textures that didn't come from the cache are ignored
+    void release(ImTextureID texture);
+
+    // starts getting the atlas ready in the background
+    void preload();
+    // once a frame on the drawing thread, uploads the atlas when the preload is done
+    void update();
+    bool preloading() const { return (bool)_preload; }
+
+    // maps resources.pack or packs every PNG in resources/ into the atlas, the first
+    // acquire does this unless preload() already has
+    void buildAtlas();
+    bool atlasFromPack() const { return _atlasFromPack; }
+    // time spent on the drawing thread for the atlas, and on the workers before it
+    double atlasMs() const { return _atlasMs; }
+    double preloadMs() const { return _preloadMs; }
+    ImTextureID atlasTexture() const { return _atlasTexture; }
+    const ImVec2 &atlasSize() const { return _atlasSize; }
+
+    // textures loaded on their own, the atlas not included
+    int textureCount() const { return (int)_entries.size(); }
+    // files decoded so far, each cache miss is one
+    int loadCount() const { return _loads; }
+
+private:
+    struct PreparedAtlas;
+
+    static void prepareAtlas(PreparedAtlas& atlas, bool parallel);
+    void uploadAtlas(PreparedAtlas& atlas);
+    void finishPreload();
+
+    struct Entry
+    {
+        CachedTexture texture;
+        int references = 0;
+    };
+
+    std::unordered_map<std::string, Entry> _entries;
+    std::unordered_map<ImTextureID, std::string> _names;
+    int _loads = 0;
+
+    bool _atlasBuilt = false;
+    ImTextureID _atlasTexture = 0;
+    ImVec2 _atlasSize = ImVec2(0, 0);
+    bool _atlasFromPack = false;
+    double _atlasMs = 0;
+    double _preloadMs = 0;
+    std::unique_ptr<PreparedAtlas> _prepared;
+    std::unique_ptr<TaskGroup> _preload;
+    std::atomic<bool> _preloadDone{false};
+    std::unordered_map<std::string, CachedTexture> _atlas;
+};
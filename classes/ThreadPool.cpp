@@ -0,0 +1,200 @@
+#include "ThreadPool.h"
+
+// the pool and deque index of the worker running on this thread, and the priority
+// of the task it is running
+static thread_local ThreadPool* tPool = nullptr;
+static thread_local int tWorker = -1;
+static thread_local int tPriority = TaskPriorityCount - 1;
+
+ThreadPool::ThreadPool(int threads, int interactiveWorkers)
+{
+    if(threads <= 0) {
+        threads = std::max(1, (int)std::thread::hardware_concurrency());
+    }
+    _backgroundLimit = std::max(1, threads - interactiveWorkers);
+    for(int i = 0; i < threads; i++) {
+        _workers.push_back(std::make_unique<Worker>());
+    }
+    for(int i = 0; i < threads; i++) {
+        _threads.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+        _stopping = true;
+    }
+    _wake.notify_all();
+    for(auto& thread : _threads) {
+        thread.join();
+    }
+}
+
+ThreadPool& ThreadPool::shared()
+{
+    // one worker is kept for interactive tasks, so the AI's search starts straight away
+    // however much analysis and review is running. at least two, so background work
+    // still gets a worker on a single core machine.
+    static ThreadPool pool(std::max(2, (int)std::thread::hardware_concurrency()), 1);
+    return pool;
+}
+
+bool ThreadPool::onWorkerThread() const
+{
+    return tPool == this;
+}
+
+void ThreadPool::submit(Task task, TaskPriority priority, const CancellationToken& token)
+{
+    int index = onWorkerThread() ? tWorker : (int)(_nextWorker++ % _workers.size());
+    {
+        std::lock_guard<std::mutex> lock(_workers[index]->mutex);
+        _workers[index]->queues[priority].push_back({ std::move(task), token, priority });
+    }
+    _queued[priority]++;
+    // taking the lock orders this with a worker deciding to sleep, so the wakeup isn't lost
+    {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+    }
+    _wake.notify_one();
+}
+
+bool ThreadPool::takeTask(int self, int lowestPriority, bool limitBackground, QueuedTask& task)
+{
+    int count = (int)_workers.size();
+    for(int priority = 0; priority <= lowestPriority; priority++) {
+        if(_queued[priority] <= 0) {
+            continue;
+        }
+        // the slot is taken before looking, so two workers can't both get the last one
+        bool slot = limitBackground && priority == TaskBackground;
+        if(slot && _runningBackground.fetch_add(1) >= _backgroundLimit) {
+            _runningBackground--;
+            continue;
+        }
+        bool found = false;
+        // newest of our own first
+        if(self >= 0) {
+            Worker& worker = *_workers[self];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            auto& queue = worker.queues[priority];
+            if(!queue.empty()) {
+                task = std::move(queue.back());
+                queue.pop_back();
+                found = true;
+            }
+        }
+        // then the oldest of someone else's
+        for(int i = 1; i <= count && !found; i++) {
+            int victim = (self + i + count) % count;
+            if(victim == self) {
+                continue;
+            }
+            Worker& worker = *_workers[victim];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            auto& queue = worker.queues[priority];
+            if(!queue.empty()) {
+                task = std::move(queue.front());
+                queue.pop_front();
+                found = true;
+            }
+        }
+        if(found) {
+            _queued[priority]--;
+            task.holdsBackgroundSlot = slot;
+            return true;
+        }
+        if(slot) {
+            // another worker may have gone to sleep while the slot looked taken
+            _runningBackground--;
+            std::lock_guard<std::mutex> lock(_sleepMutex);
+            _wake.notify_one();
+        }
+    }
+    return false;
+}
+
+void ThreadPool::runTask(QueuedTask& task)
+{
+    int outerPriority = tPriority;
+    tPriority = task.priority;
+    if(!task.token.cancelled()) {
+        task.task();
+    }
+    tPriority = outerPriority;
+    if(task.holdsBackgroundSlot) {
+        _runningBackground--;
+        // a queued background task may have been waiting for the slot
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+        _wake.notify_one();
+    }
+}
+
+bool ThreadPool::canTakeTask() const
+{
+    return _queued[TaskInteractive] > 0 || (_queued[TaskBackground] > 0 && _runningBackground < _backgroundLimit);
+}
+
+bool ThreadPool::runPendingTask()
+{
+    // the waiting task already holds its worker, so running another inline needs no background slot
+    QueuedTask task;
+    if(!takeTask(onWorkerThread() ? tWorker : -1, onWorkerThread() ? tPriority : TaskPriorityCount - 1, false, task)) {
+        return false;
+    }
+    runTask(task);
+    return true;
+}
+
+void ThreadPool::workerLoop(int index)
+{
+    tPool = this;
+    tWorker = index;
+    while(true) {
+        QueuedTask task;
+        if(takeTask(index, TaskPriorityCount - 1, true, task)) {
+            runTask(task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(_sleepMutex);
+        _wake.wait(lock, [this]() { return _stopping || canTakeTask(); });
+        if(_stopping && _queued[TaskInteractive] + _queued[TaskBackground] <= 0) {
+            return;
+        }
+    }
+}
+
+TaskGroup::TaskGroup(ThreadPool& pool, TaskPriority priority) : _pool(pool), _priority(priority)
+{
+}
+
+TaskGroup::~TaskGroup()
+{
+    wait();
+}
+
+void TaskGroup::run(std::function<void()> task)
+{
+    _pending++;
+    // the group's token isn't passed to the pool, a cancelled task still has to count itself done
+    _pool.submit([this, task = std::move(task)]() {
+        if(!_token.cancelled()) {
+            task();
+        }
+        std::lock_guard<std::mutex> lock(_mutex);
+        if(--_pending == 0) {
+            _done.notify_all();
+        }
+    }, _priority);
+}
+
+void TaskGroup::wait()
+{
+    while(_pending > 0 && _pool.onWorkerThread() && _pool.runPendingTask()) {
+    }
+    // the lock also waits out a task that is just signalling, before the group can go away
+    std::unique_lock<std::mutex> lock(_mutex);
+    _done.wait(lock, [this]() { return _pending == 0; });
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <algorithm>
+
+//
+// work stealing thread pool
+//
+// every worker has its own deque for each priority. a task submitted from a worker
+// goes on that worker's deque, other tasks are dealt round robin. a worker takes
+// its newest task first, which is the one most likely still in its cache, and steals
+// the oldest task from another worker when its own deques are empty. interactive
+// tasks (the AI thinking about a move) are always taken before background ones
+// (analysis, game review), whichever deque they are on. priority only orders the
+// queues, so a pool can also keep workers back from background tasks: however much
+// background work is queued, those workers stay free for interactive tasks.
+//
+// tasks are grouped with a TaskGroup to wait for them or cancel the ones that
+// haven't started. a running task can poll the group's token to stop early.
+//
+
+enum TaskPriority
+{
+    TaskInteractive,
+    TaskBackground,
+    TaskPriorityCount
+};
+
+// shared flag, copies all see the same cancellation
+class CancellationToken
+{
+public:
+    CancellationToken() : _cancelled(std::make_shared<std::atomic<bool>>(false)) {}
+
+    void cancel() const { *_cancelled = true; }
+    bool cancelled() const { return *_cancelled; }
+    // the flag itself, for code that polls it without knowing about the pool
+    const std::atomic<bool>* flag() const { return _cancelled.get(); }
+
+private:
+    std::shared_ptr<std::atomic<bool>> _cancelled;
+};
+
+class ThreadPool
+{
+public:
+    typedef std::function<void()> Task;
+
+    // threads <= 0 uses one per core. interactiveWorkers of the threads never run
+    // background tasks, at least one thread always can.
+    explicit ThreadPool(int threads = 0, int interactiveWorkers = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // one pool for the whole program, created on first use
+    static ThreadPool& shared();
+
+    int threadCount() const { return (int)_threads.size(); }
+    bool onWorkerThread() const;
+
+    // a task whose token is cancelled by the time a worker gets to it is dropped
+    void submit(Task task, TaskPriority priority = TaskBackground, const CancellationToken& token = CancellationToken());
+    // runs one queued task on the calling thread, false when there was none. on a
+    // worker only a task as urgent as the one it is running, so an interactive task
+    // waiting on its group never picks up a long background search.
+    bool runPendingTask();
+
+private:
+    struct QueuedTask
+    {
+        Task task;
+        CancellationToken token;
+        TaskPriority priority = TaskBackground;
+        bool holdsBackgroundSlot = false;
+    };
+
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<QueuedTask> queues[TaskPriorityCount];
+    };
+
+    // lowestPriority is the least urgent queue to look in. limitBackground takes a
+    // background task only while fewer than _backgroundLimit are running.
+    bool takeTask(int self, int lowestPriority, bool limitBackground, QueuedTask& task);
+    void runTask(QueuedTask& task);
+    bool canTakeTask() const;
+    void workerLoop(int index);
+
+    std::vector<std::unique_ptr<Worker>> _workers;
+    std::vector<std::thread> _threads;
+    std::mutex _sleepMutex;
+    std::condition_variable _wake;
+    std::atomic<int> _queued[TaskPriorityCount]{};
+    std::atomic<int> _runningBackground{0};
+    int _backgroundLimit = 1;
+    std::atomic<unsigned> _nextWorker{0};
+    std::atomic<bool> _stopping{false};
+};
+
+// a set of tasks to wait for together. waiting from a worker thread runs other
+// queued tasks of the same or higher priority meanwhile, so nested groups don't tie
+// up the pool.
+class TaskGroup
+{
+public:
+    explicit TaskGroup(ThreadPool& pool = ThreadPool::shared(), TaskPriority priority = TaskBackground);
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    void run(std::function<void()> task);
+    // drops the tasks that haven't started, running ones see token().cancelled()
+    void cancel() { _token.cancel(); }
+    void wait();
+
+    const CancellationToken& token() const { return _token; }
+    int pending() const { return _pending; }
+
+private:
+    ThreadPool& _pool;
+    TaskPriority _priority;
+    CancellationToken _token;
+    std::atomic<int> _pending{0};
+    std::mutex _mutex;
+    std::condition_variable _done;
+};
+
+//
+// split [0, count) into one contiguous slice per pool thread and wait for them all.
+// func(begin, end, slice) gets its slice's index for per thread results.
+//
+template <typename Func>
+void parallelFor(ThreadPool& pool, size_t count, Func func)
+{
+    int slices = pool.threadCount();
+    size_t slice = (count + slices - 1) / slices;
+    TaskGroup group(pool);
+    for(int t = 0; t < slices; t++) {
+        size_t begin = t * slice;
+        size_t end = std::min(count, begin + slice);
+        if(begin >= end) {
+            break;
+        }
+        group.run([&func, begin, end, t]() { func(begin, end, t); });
+    }
+    group.wait();
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "Search.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+//
+// tic tac toe position for the alpha-beta search in Search.h
+// cells are y * 3 + x, 0 empty or player + 1 as in TicTacToe::stateString()
+//
+struct TicTacToeState
+{
+    typedef int Move;       // a cell
+
+    char cells[9] = {};
+    int toMove = 0;
+
+    static TicTacToeState fromString(const std::string& state, int playerToMove)
+    {
+        TicTacToeState position;
+        position.toMove = playerToMove;
+        for(int i = 0; i < 9; i++) {
+            position.cells[i] = (char)(state[i] - '0');
+        }
+        return position;
+    }
+
+    bool lineCompleted() const
+    {
+        static const int kWinningTriples[8][3] =  { {0,1,2}, {3,4,5}, {6,7,8},  // rows
+                                                    {0,3,6}, {1,4,7}, {2,5,8},  // cols
+                                                    {0,4,8}, {2,4,6} };         // diagonals
+        for(const auto& triple : kWinningTriples) {
+            if(cells[triple[0]] && cells[triple[0]] == cells[triple[1]] && cells[triple[0]] == cells[triple[2]]) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    int sideToMove() const { return toMove; }
+
+    void generate(std::vector<Move>& moves) const
+    {
+        if(lineCompleted()) {
+            return;
+        }
+        for(int i = 0; i < 9; i++) {
+            if(!cells[i]) {
+                moves.push_back(i);
+            }
+        }
+    }
+
+    void make(const Move& cell)
+    {
+        cells[cell] = (char)(toMove + 1);
+        toMove ^= 1;
+    }
+
+    void unmake(const Move& cell)
+    {
+        cells[cell] = 0;
+        toMove ^= 1;
+    }
+
+    // a completed line was made by the player who just moved
+    int evaluate() const { return lineCompleted() ? -kSearchWin : 0; }
+
+    uint64_t hash() const
+    {
+        uint64_t key = toMove;
+        for(char cell : cells) {
+            key = key * 3 + cell;
+        }
+        return key;
+    }
+};
@@ -0,0 +1,84 @@
+#include "TimeManager.h"
+#include <algorithm>
+#include <cstdlib>
+
+// with no moves to go we assume the game lasts about this many more moves
+constexpr int DEFAULT_MOVES_TO_GO = 30;
+constexpr int DEFAULT_OVERHEAD_MS = 30;
+
+TimeManager::TimeManager()
+{
+    _overheadMs = DEFAULT_OVERHEAD_MS;
+    start(ChessClock());
+}
+
+void TimeManager::start(const ChessClock& clock)
+{
+    int movesToGo = clock.movesToGo > 0 ? std::min(clock.movesToGo, 50) : DEFAULT_MOVES_TO_GO;
+    int available = std::max(0, clock.remainingMs - _overheadMs);
+
+    // the increment comes back after the move, so most of it can be spent now
+    int soft = available / movesToGo + clock.incrementMs * 3 / 4;
+    // never risk more than a slice of the clock on one move, unless it's the last before the time control
+    int hard = std::min(soft * 5, (int)(available * (movesToGo == 1 ? 0.9 : 0.4)));
+    _hardMs = std::max(1, hard);
+    _softMs = std::max(1, std::min(soft, _hardMs));
+
+    _scale = 1.0;
+    _lastBestMove = BitMove();
+    _lastScore = 0;
+    _stableIterations = 0;
+    _start = std::chrono::steady_clock::now();
+}
+
+SearchLimits TimeManager::searchLimits() const
+{
+    SearchLimits limits;
+    limits.timeMs = _hardMs;
+    // shouldStop() decides when to stop starting iterations, not the engine
+    limits.softTimeMs = _hardMs;
+    return limits;
+}
+
+int TimeManager::elapsedMs() const
+{
+    return (int)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _start).count();
+}
+
+bool TimeManager::shouldStop(const SearchResult& iteration)
+{
+    if(std::abs(iteration.score) > MATE_SCORE - MAX_PLY) {
+        return true;
+    }
+
+    if(iteration.depth > 1 && iteration.bestMove == _lastBestMove) {
+        _stableIterations++;
+    } else {
+        _stableIterations = 0;
+    }
+
+    // a best move that keeps changing needs more time, one that has held for a while needs less
+    _scale = 1.0;
+    if(iteration.depth > 1 && _stableIterations == 0) {
+        _scale = 1.6;
+    } else if(_stableIterations >= 4) {
+        _scale = 0.6;
+    } else if(_stableIterations >= 2) {
+        _scale = 0.8;
+    }
+    // so does a score that just dropped, we may be walking into trouble
+    int drop = _lastScore - iteration.score;
+    if(iteration.depth > 1 && drop > 50) {
+        _scale *= 1.5;
+    } else if(iteration.depth > 1 && drop > 20) {
+        _scale *= 1.2;
+    }
+    _scale = std::min(_scale, 3.0);
+
+    _lastBestMove = iteration.bestMove;
+    _lastScore = iteration.score;
+
+    // the next iteration takes a few times longer than everything so far, don't start
+    // it unless it has a chance of finishing inside the scaled limit
+    return elapsedMs() * 2 > scaledLimitMs();
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "ChessEngine.h"
+#include <chrono>
+
+//
+// decides how long the engine may think about a move when playing on a clock
+//
+// start() turns the clock into two budgets: the soft limit is the time we'd like
+// to use, the hard limit is the most we can afford. after every completed
+// iteration the soft limit is stretched when the best move keeps changing or the
+// score drops, and shrunk when the same move has held for several iterations.
+//
+// typical use:
+//     TimeManager time;
+//     time.start(clock);
+//     engine.search(time.searchLimits(), [&](const SearchResult& r) { if(time.shouldStop(r)) engine.stop(); });
+//
+struct ChessClock
+{
+    int remainingMs = 0;
+    int incrementMs = 0;
+    int movesToGo = 0;          // moves until the next time control, 0 = sudden death
+};
+
+class TimeManager
+{
+public:
+    TimeManager();
+
+    // time kept back on every move for the GUI and operating system
+    void setMoveOverhead(int overheadMs) { _overheadMs = overheadMs; }
+
+    void start(const ChessClock& clock);
+    // the limits to search with, the hard limit aborts the search mid-iteration
+    SearchLimits searchLimits() const;
+    // call after every completed iteration, returns true when the search should stop
+    bool shouldStop(const SearchResult& iteration);
+
+    int softLimitMs() const { return _softMs; }
+    int hardLimitMs() const { return _hardMs; }
+    // the soft limit after the last stability adjustment
+    int scaledLimitMs() const { return (int)(_softMs * _scale); }
+    int elapsedMs() const;
+
+private:
+    int _overheadMs;
+    int _softMs;
+    int _hardMs;
+    double _scale;
+    BitMove _lastBestMove;
+    int _lastScore;
+    int _stableIterations;
+    std::chrono::steady_clock::time_point _start;
+};
@@ -137,7 +137,16 @@ int main(int, char**)
         // - When io.WantCaptureMouse is true, do not dispatch mouse input data to your main application, or clear/overwrite your copy of the mouse data.
         // - When io.WantCaptureKeyboard is true, do not dispatch keyboard input data to your main application, or clear/overwrite your copy of the keyboard data.
         // Generally you may always pass all inputs to dear imgui, and hide them from your application based on those two flags.
+#ifdef __EMSCRIPTEN__
         glfwPollEvents();
+#else
+        // Sleep until there is input or the game has something new to show (see FramePacer)
+        double timeout = ClassGame::FrameTimeout();
+        if (timeout > 0)
+            glfwWaitEventsTimeout(timeout);
+        else
+            glfwPollEvents();
+#endif
 
         // Start the Dear ImGui frame
         ImGui_ImplOpenGL3_NewFrame();
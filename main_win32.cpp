@@ -114,6 +114,10 @@ int main(int, char**)
     {
         // Poll and handle messages (inputs, window resize, etc.)
         // See the WndProc() function below for our to dispatch events to the Win32 backend.
+        // Sleep until there is input or the game has something new to show (see FramePacer)
+        double timeout = ClassGame::FrameTimeout();
+        if (timeout > 0)
+            ::MsgWaitForMultipleObjects(0, nullptr, FALSE, (DWORD)(timeout * 1000), QS_ALLINPUT);
         MSG msg;
         while (::PeekMessage(&msg, nullptr, 0U, 0U, PM_REMOVE))
         {
@@ -0,0 +1,145 @@
+#include "EngineTool.h"
+#include "../classes/ChessEngine.h"
+#include "../classes/TimeManager.h"
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <algorithm>
+
+//
+// clock simulation
+//
+// replays recorded games and, at every position, lets the engine think under the
+// time manager as if it were on the clock. the engine's own choice is discarded and
+// the recorded move is played, so every build is measured on the same positions.
+// each side's simulated clock is charged the real time the search took.
+//
+// this runs on one thread on purpose: the point is to measure wall clock usage.
+//
+
+struct ClockStats
+{
+    int moves = 0;
+    int flagged = 0;
+    int cut = 0;            // stopped before half the soft limit
+    int extended = 0;       // ran past the soft limit
+    long long usedMs = 0;
+    int maxMoveMs = 0;
+    int minRemainingMs = 0;
+};
+
+static void printStats(const std::string& name, const ClockStats& stats, int timeMs)
+{
+    std::cout << std::left << std::setw(24) << name << std::right
+              << std::setw(5) << stats.moves << " moves  avg " << std::setw(5) << (stats.moves ? stats.usedMs / stats.moves : 0) << "ms"
+              << "  max " << std::setw(6) << stats.maxMoveMs << "ms"
+              << "  min left " << std::setw(5) << std::fixed << std::setprecision(1) << 100.0 * stats.minRemainingMs / std::max(1, timeMs) << "%"
+              << "  cut " << std::setw(3) << stats.cut << "  extended " << std::setw(3) << stats.extended
+              << (stats.flagged ? "  FLAGGED" : "") << "\n";
+}
+
+int runClock(const ToolArgs& args)
+{
+    auto positional = positionalArgs(args);
+    if(positional.empty()) {
+        std::cerr << "usage: enginetool clock <games.pgn> [options]\n";
+        return 1;
+    }
+    std::vector<PgnGame> games;
+    if(!loadPGN(positional[0], games)) {
+        std::cerr << "can't read " << positional[0] << "\n";
+        return 1;
+    }
+    int timeMs = optionInt(args, "--time", 60000);
+    int incrementMs = optionInt(args, "--inc", 0);
+    int movesToGo = optionInt(args, "--movestogo", 0);
+    int maxGames = optionInt(args, "--games", (int)games.size());
+    int overheadMs = optionInt(args, "--overhead", 30);
+
+    std::cout << "simulating " << std::min(maxGames, (int)games.size()) << " games at " << timeMs << "ms";
+    if(movesToGo) std::cout << " per " << movesToGo << " moves";
+    if(incrementMs) std::cout << " + " << incrementMs << "ms";
+    std::cout << "\n\n";
+
+    auto engine = std::make_unique<ChessEngine>();
+    TimeManager time;
+    time.setMoveOverhead(overheadMs);
+    ClockStats total;
+    total.minRemainingMs = timeMs;
+    for(int g = 0; g < maxGames && g < (int)games.size(); g++) {
+        const PgnGame& game = games[g];
+        auto fen = game.tags.find("FEN");
+        if(!engine->setFEN(fen != game.tags.end() ? fen->second : ChessEngine::startFEN())) {
+            std::cout << "game " << g + 1 << ": bad FEN tag, skipped\n";
+            continue;
+        }
+        engine->clearTranspositionTable();
+
+        ClockStats stats;
+        stats.minRemainingMs = timeMs;
+        int clockMs[2] = { timeMs, timeMs };
+        int movesMade[2] = { 0, 0 };
+        for(const auto& san : game.moves) {
+            BitMove recorded;
+            if(!engine->parseMove(san, recorded)) {
+                std::cout << "game " << g + 1 << ": illegal move " << san << ", stopped there\n";
+                break;
+            }
+            int side = engine->sideToMove() == 1 ? 0 : 1;
+            ChessClock clock;
+            clock.remainingMs = clockMs[side];
+            clock.incrementMs = incrementMs;
+            clock.movesToGo = movesToGo ? movesToGo - movesMade[side] % movesToGo : 0;
+
+            time.start(clock);
+            engine->search(time.searchLimits(), [&](const SearchResult& iteration) {
+                if(time.shouldStop(iteration)) {
+                    engine->stop();
+                }
+            });
+            int used = time.elapsedMs();
+
+            stats.moves++;
+            stats.usedMs += used;
+            stats.maxMoveMs = std::max(stats.maxMoveMs, used);
+            if(used * 2 < time.softLimitMs()) stats.cut++;
+            if(used > time.softLimitMs()) stats.extended++;
+
+            clockMs[side] -= used;
+            stats.minRemainingMs = std::min(stats.minRemainingMs, clockMs[side]);
+            if(clockMs[side] <= 0) {
+                stats.flagged = 1;
+                break;
+            }
+            clockMs[side] += incrementMs;
+            movesMade[side]++;
+            if(movesToGo && movesMade[side] % movesToGo == 0) {
+                clockMs[side] += timeMs;
+            }
+            engine->makeMove(recorded);
+        }
+
+        std::string name = "game " + std::to_string(g + 1);
+        auto white = game.tags.find("White");
+        auto black = game.tags.find("Black");
+        if(white != game.tags.end() && black != game.tags.end()) {
+            name = white->second + " - " + black->second;
+            if(name.length() > 23) {
+                name = name.substr(0, 23);
+            }
+        }
+        printStats(name, stats, timeMs);
+
+        total.moves += stats.moves;
+        total.flagged += stats.flagged;
+        total.cut += stats.cut;
+        total.extended += stats.extended;
+        total.usedMs += stats.usedMs;
+        total.maxMoveMs = std::max(total.maxMoveMs, stats.maxMoveMs);
+        total.minRemainingMs = std::min(total.minRemainingMs, stats.minRemainingMs);
+    }
+    std::cout << "\n";
+    printStats("total", total, timeMs);
+    std::cout << total.flagged << " flagged games\n";
+    return total.flagged ? 2 : 0;
+}
@@ -0,0 +1,345 @@
+#include "EngineTool.h"
+#include "../classes/ChessEngine.h"
+#include <iostream>
+#include <memory>
+#include <chrono>
+#include <algorithm>
+#include <sstream>
+
+//
+// distributed root split search
+//
+// one coordinator and several worker processes talking over a Unix domain socket.
+// at every depth the coordinator hands out the root moves: a worker gets the position
+// after one move, searches it a ply shallower with its own engine and sends back
+// the score, node count and line. the coordinator keeps the best move, adds up
+// the nodes and starts the next depth with the best moves first.
+//
+// workers keep their engine, and so their transposition table, between jobs. every
+// root move is searched with a full window, so the result is the same as one
+// process searching to that depth without pruning at the root.
+//
+// the protocol is one line of text per message:
+//     coordinator -> worker:  search <depth> <fen>
+//                             quit
+//     worker -> coordinator:  result <score> <nodes> <move> <move> ...
+// moves are in coordinate notation and the score is from the worker's side to move.
+//
+// by default the coordinator forks its own workers, so everything runs on this
+// machine. with --spawn 0 it waits for workers started separately with
+// `enginetool worker <socket>`, for example from other containers sharing the socket.
+//
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <poll.h>
+#include <unistd.h>
+#include <signal.h>
+#include <cstring>
+
+// a socket that reads and writes whole lines
+class LineSocket
+{
+public:
+    explicit LineSocket(int fd) : _fd(fd) {}
+    ~LineSocket() { if(_fd >= 0) close(_fd); }
+
+    int fd() const { return _fd; }
+
+    bool send(const std::string& line)
+    {
+        std::string data = line + "\n";
+        size_t sent = 0;
+        while(sent < data.size()) {
+            ssize_t count = write(_fd, data.data() + sent, data.size() - sent);
+            if(count <= 0) {
+                return false;
+            }
+            sent += (size_t)count;
+        }
+        return true;
+    }
+
+    // blocks until a whole line has arrived, false when the other end has gone
+    bool receive(std::string& line)
+    {
+        while(true) {
+            size_t end = _buffer.find('\n');
+            if(end != std::string::npos) {
+                line = _buffer.substr(0, end);
+                _buffer.erase(0, end + 1);
+                return true;
+            }
+            char chunk[4096];
+            ssize_t count = read(_fd, chunk, sizeof(chunk));
+            if(count <= 0) {
+                return false;
+            }
+            _buffer.append(chunk, (size_t)count);
+        }
+    }
+
+private:
+    int _fd;
+    std::string _buffer;
+};
+
+static bool socketAddress(const std::string& path, sockaddr_un& address)
+{
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if(path.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    return true;
+}
+
+static int workerLoop(const std::string& path)
+{
+    sockaddr_un address;
+    if(!socketAddress(path, address)) {
+        std::cerr << "socket path too long\n";
+        return 1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(fd < 0 || connect(fd, (sockaddr*)&address, sizeof(address)) != 0) {
+        std::cerr << "can't connect to " << path << ": " << std::strerror(errno) << "\n";
+        if(fd >= 0) close(fd);
+        return 1;
+    }
+    LineSocket coordinator(fd);
+    auto engine = std::make_unique<ChessEngine>();
+
+    std::string line;
+    while(coordinator.receive(line)) {
+        std::istringstream in(line);
+        std::string command;
+        in >> command;
+        if(command == "quit") {
+            break;
+        }
+        if(command != "search") {
+            continue;
+        }
+        SearchLimits limits;
+        in >> limits.depth;
+        std::string fen;
+        std::getline(in >> std::ws, fen);
+        engine->setFEN(fen);
+
+        std::ostringstream reply;
+        if(limits.depth <= 0 || engine->gameStatus() != GameOngoing) {
+            // nothing to search: a finished game, or the root move was all the depth there was
+            GameStatus status = engine->gameStatus();
+            int score = status == GameCheckmate ? -MATE_SCORE : status == GameOngoing ? engine->evaluate() * engine->sideToMove() : 0;
+            reply << "result " << score << " 1";
+        } else {
+            SearchResult result = engine->search(limits);
+            reply << "result " << result.score << " " << result.nodes;
+            for(const auto& move : result.pv) {
+                reply << " " << ChessEngine::moveToString(move);
+            }
+        }
+        if(!coordinator.send(reply.str())) {
+            break;
+        }
+    }
+    return 0;
+}
+
+int runWorker(const ToolArgs& args)
+{
+    auto positional = positionalArgs(args);
+    if(positional.empty()) {
+        std::cerr << "usage: enginetool worker <socket>\n";
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+    return workerLoop(positional[0]);
+}
+
+struct RootMove
+{
+    BitMove move;
+    int score = 0;
+    uint64_t nodes = 0;
+    std::vector<std::string> line;
+};
+
+int runCoordinator(const ToolArgs& args)
+{
+    auto positional = positionalArgs(args);
+    std::string fen = positional.empty() ? ChessEngine::startFEN() : positional[0];
+    int depth = optionInt(args, "--depth", 8);
+    int spawn = optionInt(args, "--spawn", defaultThreadCount());
+    int workerCount = optionInt(args, "--workers", spawn);
+    std::string path = optionValue(args, "--socket", "/tmp/enginetool-" + std::to_string(getpid()) + ".sock");
+
+    auto position = std::make_unique<ChessEngine>();
+    if(!position->setFEN(fen)) {
+        std::cerr << "bad FEN\n";
+        return 1;
+    }
+    std::vector<RootMove> rootMoves;
+    for(const auto& move : position->generateAllMoves()) {
+        RootMove root;
+        root.move = move;
+        rootMoves.push_back(root);
+    }
+    if(rootMoves.empty() || workerCount < 1) {
+        std::cerr << (rootMoves.empty() ? "no legal moves\n" : "need at least one worker\n");
+        return 1;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    sockaddr_un address;
+    if(!socketAddress(path, address)) {
+        std::cerr << "socket path too long\n";
+        return 1;
+    }
+    unlink(path.c_str());
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(listener < 0 || bind(listener, (sockaddr*)&address, sizeof(address)) != 0 || listen(listener, workerCount) != 0) {
+        std::cerr << "can't listen on " << path << ": " << std::strerror(errno) << "\n";
+        return 1;
+    }
+
+    // fork before any threads exist, the children go straight into the worker loop
+    std::vector<pid_t> children;
+    for(int i = 0; i < spawn; i++) {
+        pid_t pid = fork();
+        if(pid == 0) {
+            close(listener);
+            _exit(workerLoop(path));
+        }
+        if(pid > 0) {
+            children.push_back(pid);
+        }
+    }
+    if(spawn == 0) {
+        std::cout << "waiting for " << workerCount << " workers on " << path << "\n";
+    }
+
+    std::vector<std::unique_ptr<LineSocket>> workers;
+    while((int)workers.size() < workerCount) {
+        int fd = accept(listener, nullptr, nullptr);
+        if(fd < 0) {
+            std::cerr << "accept failed: " << std::strerror(errno) << "\n";
+            break;
+        }
+        workers.push_back(std::make_unique<LineSocket>(fd));
+    }
+    close(listener);
+    unlink(path.c_str());
+
+    auto start = std::chrono::steady_clock::now();
+    uint64_t totalNodes = 0;
+    bool failed = workers.empty();
+    for(int d = 1; d <= depth && !failed; d++) {
+        // hand out the root moves, the best from the last depth first
+        size_t next = 0;
+        size_t finished = 0;
+        std::vector<int> assigned(workers.size(), -1);
+        auto dispatch = [&](size_t w) {
+            if(next >= rootMoves.size()) {
+                return;
+            }
+            position->makeMove(rootMoves[next].move);
+            std::string job = "search " + std::to_string(d - 1) + " " + position->getFEN();
+            position->unmakeMove();
+            if(workers[w]->send(job)) {
+                assigned[w] = (int)next++;
+            }
+        };
+        for(size_t w = 0; w < workers.size(); w++) {
+            dispatch(w);
+        }
+        while(finished < rootMoves.size()) {
+            std::vector<pollfd> fds;
+            for(const auto& worker : workers) {
+                fds.push_back({ worker->fd(), POLLIN, 0 });
+            }
+            if(poll(fds.data(), fds.size(), -1) < 0) {
+                failed = true;
+                break;
+            }
+            for(size_t w = 0; w < workers.size(); w++) {
+                if(!(fds[w].revents & (POLLIN | POLLHUP)) || assigned[w] < 0) {
+                    continue;
+                }
+                std::string reply;
+                if(!workers[w]->receive(reply)) {
+                    std::cerr << "worker " << w << " disconnected\n";
+                    failed = true;
+                    break;
+                }
+                std::istringstream in(reply);
+                std::string word;
+                RootMove& root = rootMoves[assigned[w]];
+                in >> word >> root.score >> root.nodes;
+                // the worker's score is for the other side, and its mates are one ply closer
+                root.score = -root.score;
+                if(root.score > MATE_SCORE - MAX_PLY) root.score--;
+                else if(root.score < -MATE_SCORE + MAX_PLY) root.score++;
+                root.line.clear();
+                while(in >> word) {
+                    root.line.push_back(word);
+                }
+                totalNodes += root.nodes;
+                finished++;
+                assigned[w] = -1;
+                dispatch(w);
+            }
+            if(failed) {
+                break;
+            }
+        }
+        if(failed) {
+            break;
+        }
+
+        std::stable_sort(rootMoves.begin(), rootMoves.end(), [](const RootMove& a, const RootMove& b) { return a.score > b.score; });
+        const RootMove& best = rootMoves[0];
+        int ms = (int)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "depth " << d << "  score " << best.score << "  nodes " << totalNodes << "  time " << ms << "ms  pv "
+                  << ChessEngine::moveToString(best.move);
+        for(const auto& move : best.line) {
+            std::cout << " " << move;
+        }
+        std::cout << "\n";
+    }
+
+    for(auto& worker : workers) {
+        worker->send("quit");
+    }
+    workers.clear();
+    for(pid_t pid : children) {
+        waitpid(pid, nullptr, 0);
+    }
+    if(failed) {
+        return 1;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "bestmove " << ChessEngine::moveToString(rootMoves[0].move) << "  " << totalNodes << " nodes on "
+              << workerCount << " workers (" << (uint64_t)(totalNodes / std::max(seconds, 0.001)) << " nps)\n";
+    return 0;
+}
+
+#else
+
+int runWorker(const ToolArgs& args)
+{
+    std::cerr << "distributed search needs Unix domain sockets, which this platform doesn't have\n";
+    return 1;
+}
+
+int runCoordinator(const ToolArgs& args)
+{
+    return runWorker(args);
+}
+
+#endif
@@ -0,0 +1,89 @@
+#include "EngineTool.h"
+#include "../classes/ChessEngine.h"
+#include "../classes/KPKBitbase.h"
+#include <iostream>
+#include <bit>
+
+//
+// endgame bitbase report
+//
+// building the table happens the first time the search meets a KPK position,
+// this forces it up front so the cost can be seen, and can look up one position.
+// --check probes textbook positions, the stalemate trap and opposition among them,
+// and fails if the table disagrees with any.
+//
+
+struct KPKPosition
+{
+    const char* fen;
+    int result;                 // 1 white wins, -1 black wins, 0 draw
+};
+
+static const KPKPosition kKPKPositions[] = {
+    { "4k3/4P3/4K3/8/8/8/8/8 w - - 0 1",     1 },  // Kd6 forces the king aside
+    { "4k3/4P3/4K3/8/8/8/8/8 b - - 0 1",     0 },  // stalemate
+    { "8/8/4k3/8/4K3/4P3/8/8 w - - 0 1",     0 },  // black has the opposition
+    { "8/8/4k3/8/4K3/4P3/8/8 b - - 0 1",     1 },  // white has it
+    { "k7/8/8/P7/8/8/8/7K w - - 0 1",        0 },  // rook pawn, the king holds the corner
+    { "8/P7/8/8/8/8/7k/K7 b - - 0 1",        1 },  // the king is too far to catch the pawn
+    { "8/8/8/8/8/4k3/4p3/4K3 w - - 0 1",     0 },  // the first two with colors reversed
+    { "8/8/8/8/8/4k3/4p3/4K3 b - - 0 1",    -1 },
+};
+
+// 1, -1 or 0 as above, false when the position isn't king and pawn against king
+static bool probeFEN(const std::string& fen, int& result)
+{
+    ChessEngine position;
+    if(!position.setFEN(fen)) {
+        return false;
+    }
+    uint64_t whitePawns = position.bitboard(WHITE_PAWNS).getData();
+    uint64_t blackPawns = position.bitboard(BLACK_PAWNS).getData();
+    if(std::popcount(position.bitboard(OCCUPANCY).getData()) != 3 || std::popcount(whitePawns | blackPawns) != 1) {
+        return false;
+    }
+    int strongColor = whitePawns ? 1 : -1;
+    int pawn = std::countr_zero(whitePawns | blackPawns);
+    int strongKing = std::countr_zero(position.bitboard(strongColor == 1 ? WHITE_KING : BLACK_KING).getData());
+    int weakKing = std::countr_zero(position.bitboard(strongColor == 1 ? BLACK_KING : WHITE_KING).getData());
+    result = probeKPK(strongColor, strongKing, pawn, weakKing, position.sideToMove()) ? strongColor : 0;
+    return true;
+}
+
+static const char* resultName(int result)
+{
+    return result == 1 ? "white wins" : result == -1 ? "black wins" : "draw";
+}
+
+int runKPK(const ToolArgs& args)
+{
+    const KPKStats& stats = kpkBitbaseStats();
+    std::cout << "KPK bitbase: " << stats.wins << " wins, " << stats.draws << " draws\n";
+    std::cout << "generated in " << stats.generationMs << "ms, " << stats.iterations << " iterations\n";
+    std::cout << "table " << stats.bytes << " bytes (" << stats.workBytes << " bytes while building)\n";
+
+    if(hasOption(args, "--check")) {
+        int failed = 0;
+        for(const KPKPosition& position : kKPKPositions) {
+            int result = 0;
+            if(!probeFEN(position.fen, result) || result != position.result) {
+                std::cout << position.fen << ": " << resultName(result) << ", expected " << resultName(position.result) << "\n";
+                failed++;
+            }
+        }
+        std::cout << (int)std::size(kKPKPositions) - failed << " / " << std::size(kKPKPositions) << " positions correct\n";
+        return failed ? 1 : 0;
+    }
+
+    auto positional = positionalArgs(args);
+    if(positional.empty()) {
+        return 0;
+    }
+    int result = 0;
+    if(!probeFEN(positional[0], result)) {
+        std::cerr << "not a king and pawn against king position\n";
+        return 1;
+    }
+    std::cout << resultName(result) << "\n";
+    return 0;
+}
@@ -0,0 +1,249 @@
+#include "EngineTool.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <cctype>
+
+struct ToolCommand
+{
+    const char* name;
+    int (*run)(const ToolArgs& args);
+    const char* usage;
+};
+
+static const ToolCommand kCommands[] = {
+    { "tune-pack", runTunePack, "tune-pack <positions.txt> <positions.bin>      convert \"FEN result\" lines to the tuner's binary format" },
+    { "tune",      runTune,     "tune <positions.bin> [--threads N] [--iterations N] [--rate R] [--out header]" },
+    { "bench",     runBench,    "bench [depth] [--multipv N] [--verbose]        fixed depth node count signature and nps" },
+    { "perft",     runPerft,    "perft [depth] [--fen FEN] [--divide] | perft --check   count legal move sequences, --check runs the standard positions" },
+    { "epd",       runEpd,      "epd <suite.epd> [--threads N] [--nodes N | --depth N | --movetime ms] [--verbose]" },
+    { "mate",      runMate,     "mate <\"FEN\" | problems.epd> [--moves N] [--nodes N]  prove or disprove mate with df-pn" },
+    { "kpk",       runKPK,      "kpk [\"FEN\"] | kpk --check  build the KPK bitbase, report its cost and optionally probe a position, --check probes textbook positions" },
+    { "distributed", runCoordinator, "distributed [\"FEN\"] [--depth N] [--spawn N] [--workers N] [--socket path]  root split search over worker processes" },
+    { "worker",    runWorker,   "worker <socket>  join a distributed search as a worker" },
+    { "mcts",      runMcts,     "mcts [connect4 | othello | checkers] [--time ms] [--threads N]  MCTS playout rate from 1 to N threads" },
+    { "search",    runGameSearch, "search [tictactoe | connect4 | othello] [--depth N] [--time ms] [--hand]  generic alpha-beta search from the starting position" },
+    { "pool",      runPoolBench, "pool [--tasks N] [--work N] [--threads N]  task throughput of the thread pool against std::async" },
+    { "othello-perft", runOthelloPerft, "othello-perft [depth]  count Othello move sequences with the scalar and AVX2 bitboard code, against the published counts" },
+    { "othello-endgame", runOthelloEndgame, "othello-endgame [empties] [--positions N] [--time ms] [--seed N] [--check]  solve random Othello endgames exactly, serial and parallel, --check compares with minimax up to empties" },
+    { "othello-train", runOthelloTrain, "othello-train [--games N] [--depth N] [--solve empties] [--positions file] [--iterations N] [--out file]  fit the Othello pattern weights from self-play" },
+    { "pack-resources", runPackResources, "pack-resources [directory] [output] [--repeat N] [--threads N] [--quiet]  build the pre-decoded resource pack and time startup with and without it" },
+    { "clock",     runClock,    "clock <games.pgn> [--time ms] [--inc ms] [--movestogo N] [--games N]   replay games on a simulated clock" },
+    { "match",     runMatch,    "match [openings.epd] [--games N] [--threads N] [--nodes N | --depth N | --movetime ms] (add -a/-b to set one side)\n"
+                                "        [--values-a P,N,B,R,Q] [--values-b P,N,B,R,Q] [--elo0 E] [--elo1 E] [--alpha A] [--beta B] [--max-plies N] [--pgn out.pgn]" },
+};
+
+//
+// options are of the form --name value, or a bare --name for flags
+//
+bool hasOption(const ToolArgs& args, const std::string& name)
+{
+    for(const auto& arg : args) {
+        if(arg == name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string optionValue(const ToolArgs& args, const std::string& name, const std::string& defaultValue)
+{
+    for(size_t i = 0; i + 1 < args.size(); i++) {
+        if(args[i] == name) {
+            return args[i + 1];
+        }
+    }
+    return defaultValue;
+}
+
+int optionInt(const ToolArgs& args, const std::string& name, int defaultValue)
+{
+    std::string value = optionValue(args, name, "");
+    return value.empty() ? defaultValue : std::stoi(value);
+}
+
+std::vector<std::string> positionalArgs(const ToolArgs& args)
+{
+    // positional arguments come before any options
+    std::vector<std::string> positional;
+    for(const auto& arg : args) {
+        if(arg.rfind("--", 0) == 0) {
+            break;
+        }
+        positional.push_back(arg);
+    }
+    return positional;
+}
+
+int defaultThreadCount()
+{
+    unsigned int count = std::thread::hardware_concurrency();
+    return count ? (int)count : 1;
+}
+
+static std::string trim(const std::string& text)
+{
+    size_t begin = text.find_first_not_of(" \t\r\n");
+    size_t end = text.find_last_not_of(" \t\r\n");
+    return begin == std::string::npos ? "" : text.substr(begin, end - begin + 1);
+}
+
+bool loadEPD(const std::string& path, std::vector<EpdEntry>& entries)
+{
+    std::ifstream in(path);
+    if(!in) {
+        return false;
+    }
+    std::string line;
+    while(std::getline(in, line)) {
+        if(trim(line).empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream fields(line);
+        std::string placement, side, castling, enPassant;
+        if(!(fields >> placement >> side >> castling >> enPassant)) {
+            continue;
+        }
+        EpdEntry entry;
+        entry.fen = placement + " " + side + " " + castling + " " + enPassant + " 0 1";
+
+        // operations are "opcode operand;" with semicolons allowed inside quotes
+        std::string rest;
+        std::getline(fields, rest);
+        std::string operation;
+        bool quoted = false;
+        for(size_t i = 0; i <= rest.length(); i++) {
+            char c = i < rest.length() ? rest[i] : ';';
+            if(c == '"') {
+                quoted = !quoted;
+            } else if(c == ';' && !quoted) {
+                operation = trim(operation);
+                if(!operation.empty()) {
+                    size_t space = operation.find(' ');
+                    std::string opcode = operation.substr(0, space);
+                    entry.operations[opcode] = space == std::string::npos ? "" : trim(operation.substr(space + 1));
+                }
+                operation.clear();
+            } else {
+                operation += c;
+            }
+        }
+        entries.push_back(entry);
+    }
+    return true;
+}
+
+bool loadPGN(const std::string& path, std::vector<PgnGame>& games)
+{
+    std::ifstream in(path);
+    if(!in) {
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    const std::string text = buffer.str();
+
+    PgnGame game;
+    bool inMoves = false;
+    auto finishGame = [&]() {
+        if(!game.tags.empty() || !game.moves.empty()) {
+            games.push_back(game);
+        }
+        game = PgnGame();
+        inMoves = false;
+    };
+    size_t i = 0;
+    while(i < text.length()) {
+        char c = text[i];
+        if(std::isspace((unsigned char)c)) {
+            i++;
+        } else if(c == '[') {
+            // a tag after the movetext starts the next game, even without a result token
+            if(inMoves) {
+                finishGame();
+            }
+            size_t end = text.find(']', i);
+            std::string tag = text.substr(i + 1, (end == std::string::npos ? text.length() : end) - i - 1);
+            size_t quote = tag.find('"');
+            if(quote != std::string::npos) {
+                size_t close = tag.rfind('"');
+                game.tags[trim(tag.substr(0, quote))] = close > quote ? tag.substr(quote + 1, close - quote - 1) : "";
+            }
+            i = end == std::string::npos ? text.length() : end + 1;
+        } else if(c == '{') {
+            size_t end = text.find('}', i);
+            i = end == std::string::npos ? text.length() : end + 1;
+        } else if(c == ';') {
+            size_t end = text.find('\n', i);
+            i = end == std::string::npos ? text.length() : end + 1;
+        } else if(c == '(') {
+            // skip the variation, which may hold comments and nested variations of its own
+            int depth = 0;
+            for(; i < text.length(); i++) {
+                if(text[i] == '{') {
+                    size_t end = text.find('}', i);
+                    i = end == std::string::npos ? text.length() - 1 : end;
+                } else if(text[i] == '(') {
+                    depth++;
+                } else if(text[i] == ')' && --depth == 0) {
+                    i++;
+                    break;
+                }
+            }
+        } else {
+            size_t end = i;
+            while(end < text.length() && !std::isspace((unsigned char)text[end]) && text[end] != '{' && text[end] != '(' && text[end] != ';') {
+                end++;
+            }
+            std::string token = text.substr(i, end - i);
+            i = end;
+            inMoves = true;
+            if(token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*") {
+                game.result = token;
+                finishGame();
+                continue;
+            }
+            // strip a leading move number ("12." or "12...") and skip NAGs
+            size_t start = 0;
+            while(start < token.length() && (std::isdigit((unsigned char)token[start]) || token[start] == '.')) {
+                start++;
+            }
+            if(start > 0 && start < token.length() && token[start - 1] != '.') {
+                start = 0;
+            }
+            token = token.substr(start);
+            if(!token.empty() && token[0] != '$') {
+                game.moves.push_back(token);
+            }
+        }
+    }
+    finishGame();
+    return true;
+}
+
+static void printUsage()
+{
+    std::cout << "usage: enginetool <command> [arguments]\n\ncommands:\n";
+    for(const auto& command : kCommands) {
+        std::cout << "  " << command.usage << "\n";
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if(argc < 2) {
+        printUsage();
+        return 1;
+    }
+    std::string name = argv[1];
+    ToolArgs args(argv + 2, argv + argc);
+    for(const auto& command : kCommands) {
+        if(name == command.name) {
+            return command.run(args);
+        }
+    }
+    std::cout << "unknown command: " << name << "\n\n";
+    printUsage();
+    return 1;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+
+//
+// enginetool is the headless command line front end for the engine code in classes/
+// each command gets the arguments that follow its name and returns the process exit code
+//
+typedef std::vector<std::string> ToolArgs;
+
+int runTunePack(const ToolArgs& args);
+int runTune(const ToolArgs& args);
+int runMatch(const ToolArgs& args);
+int runPerft(const ToolArgs& args);
+int runEpd(const ToolArgs& args);
+int runClock(const ToolArgs& args);
+int runBench(const ToolArgs& args);
+int runMate(const ToolArgs& args);
+int runKPK(const ToolArgs& args);
+int runCoordinator(const ToolArgs& args);
+int runWorker(const ToolArgs& args);
+int runMcts(const ToolArgs& args);
+int runGameSearch(const ToolArgs& args);
+int runPoolBench(const ToolArgs& args);
+int runOthelloPerft(const ToolArgs& args);
+int runOthelloEndgame(const ToolArgs& args);
+int runOthelloTrain(const ToolArgs& args);
+int runPackResources(const ToolArgs& args);
+
+// helpers shared by the commands
+bool hasOption(const ToolArgs& args, const std::string& name);
+std::string optionValue(const ToolArgs& args, const std::string& name, const std::string& defaultValue);
+int optionInt(const ToolArgs& args, const std::string& name, int defaultValue);
+// the arguments before the first option
+std::vector<std::string> positionalArgs(const ToolArgs& args);
+int defaultThreadCount();
+
+// one position from an EPD file. the fen has the four EPD fields plus "0 1", and
+// operations maps each opcode to its operand with any quotes removed ("bm" -> "Qxf7+ Nd5")
+struct EpdEntry
+{
+    std::string fen;
+    std::map<std::string, std::string> operations;
+};
+bool loadEPD(const std::string& path, std::vector<EpdEntry>& entries);
+
+// one game from a PGN file: the tag pairs and the mainline moves in SAN, with
+// comments, variations, NAGs and move numbers stripped
+struct PgnGame
+{
+    std::map<std::string, std::string> tags;
+    std::vector<std::string> moves;
+    std::string result;
+};
+bool loadPGN(const std::string& path, std::vector<PgnGame>& games);
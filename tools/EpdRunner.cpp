@@ -0,0 +1,176 @@
+#include "EngineTool.h"
+#include "../classes/ChessEngine.h"
+#include "../classes/ThreadPool.h"
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <atomic>
+#include <memory>
+#include <chrono>
+
+//
+// EPD test suite runner
+//
+// every position is searched to the same limit and scored against its "bm" (best
+// move) and "am" (avoid move) operations. positions are handed out to worker
+// threads one at a time, each worker with its own engine, so a long search on
+// one position doesn't hold up the rest.
+//
+// time to solution is when the engine settled on a correct move for good: the
+// first iteration after which every later iteration also picked a correct move.
+//
+
+struct EpdResult
+{
+    std::string id;
+    std::string expected;
+    std::string found;
+    bool valid = false;
+    bool solved = false;
+    int depth = 0;
+    uint64_t nodes = 0;
+    int timeMs = 0;
+    uint64_t solutionNodes = 0;
+    int solutionTimeMs = 0;
+};
+
+// parse a list of SAN moves, returns false if any of them isn't legal here
+static bool parseMoveList(ChessEngine& engine, const std::string& text, std::vector<BitMove>& moves)
+{
+    std::istringstream in(text);
+    std::string san;
+    while(in >> san) {
+        BitMove move;
+        if(!engine.parseMove(san, move)) {
+            return false;
+        }
+        moves.push_back(move);
+    }
+    return true;
+}
+
+static bool contains(const std::vector<BitMove>& moves, const BitMove& move)
+{
+    for(const auto& candidate : moves) {
+        if(candidate == move) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static EpdResult runPosition(ChessEngine& engine, const EpdEntry& entry, const SearchLimits& limits)
+{
+    EpdResult result;
+    auto id = entry.operations.find("id");
+    result.id = id != entry.operations.end() ? id->second : "";
+    auto bm = entry.operations.find("bm");
+    auto am = entry.operations.find("am");
+    result.expected = bm != entry.operations.end() ? bm->second : am != entry.operations.end() ? "not " + am->second : "";
+
+    std::vector<BitMove> bestMoves, avoidMoves;
+    if(!engine.setFEN(entry.fen) || result.expected.empty() ||
+       (bm != entry.operations.end() && !parseMoveList(engine, bm->second, bestMoves)) ||
+       (am != entry.operations.end() && !parseMoveList(engine, am->second, avoidMoves))) {
+        return result;
+    }
+    result.valid = true;
+    auto correct = [&](const BitMove& move) {
+        return (bestMoves.empty() || contains(bestMoves, move)) && !contains(avoidMoves, move);
+    };
+
+    engine.clearTranspositionTable();
+    bool settled = false;
+    SearchResult search = engine.search(limits, [&](const SearchResult& iteration) {
+        if(!correct(iteration.bestMove)) {
+            settled = false;
+        } else if(!settled) {
+            settled = true;
+            result.solutionNodes = iteration.nodes;
+            result.solutionTimeMs = iteration.timeMs;
+        }
+    });
+    result.found = engine.moveToSAN(search.bestMove);
+    result.solved = correct(search.bestMove);
+    result.depth = search.depth;
+    result.nodes = search.nodes;
+    result.timeMs = search.timeMs;
+    return result;
+}
+
+int runEpd(const ToolArgs& args)
+{
+    auto positional = positionalArgs(args);
+    if(positional.empty()) {
+        std::cerr << "usage: enginetool epd <suite.epd> [options]\n";
+        return 1;
+    }
+    std::vector<EpdEntry> entries;
+    if(!loadEPD(positional[0], entries)) {
+        std::cerr << "can't read " << positional[0] << "\n";
+        return 1;
+    }
+
+    // fixed node counts by default so results compare across machines and builds
+    SearchLimits limits;
+    limits.nodes = (hasOption(args, "--depth") || hasOption(args, "--movetime")) ? 0 : 100000;
+    limits.depth = optionInt(args, "--depth", limits.depth);
+    limits.nodes = (uint64_t)optionInt(args, "--nodes", (int)limits.nodes);
+    limits.timeMs = optionInt(args, "--movetime", limits.timeMs);
+    int threads = std::max(1, optionInt(args, "--threads", defaultThreadCount()));
+    bool verbose = hasOption(args, "--verbose");
+
+    std::vector<EpdResult> results(entries.size());
+    std::atomic<size_t> nextPosition(0);
+    auto start = std::chrono::steady_clock::now();
+
+    auto worker = [&]() {
+        auto engine = std::make_unique<ChessEngine>();
+        for(size_t index = nextPosition++; index < entries.size(); index = nextPosition++) {
+            results[index] = runPosition(*engine, entries[index], limits);
+        }
+    };
+    ThreadPool pool(threads);
+    TaskGroup group(pool);
+    for(int t = 0; t < threads; t++) {
+        group.run(worker);
+    }
+    group.wait();
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    int solved = 0, valid = 0;
+    uint64_t totalNodes = 0, solutionNodes = 0;
+    long long solutionTimeMs = 0;
+    for(size_t i = 0; i < results.size(); i++) {
+        const EpdResult& result = results[i];
+        std::string name = result.id.empty() ? std::to_string(i + 1) : result.id;
+        if(!result.valid) {
+            std::cout << std::left << std::setw(16) << name << " skipped, bad position or moves\n";
+            continue;
+        }
+        valid++;
+        totalNodes += result.nodes;
+        if(result.solved) {
+            solved++;
+            solutionNodes += result.solutionNodes;
+            solutionTimeMs += result.solutionTimeMs;
+        }
+        if(verbose || !result.solved) {
+            std::cout << std::left << std::setw(16) << name << (result.solved ? " ok    " : " FAIL  ")
+                      << std::setw(8) << result.found << " expected " << std::setw(16) << result.expected << std::right
+                      << " depth " << std::setw(2) << result.depth << "  nodes " << std::setw(9) << result.nodes;
+            if(result.solved) {
+                std::cout << "  solved after " << result.solutionNodes << " nodes, " << result.solutionTimeMs << "ms";
+            }
+            std::cout << "\n";
+        }
+    }
+
+    std::cout << "\nsolved " << solved << " / " << valid << "\n";
+    std::cout << "total nodes " << totalNodes << " in " << std::fixed << std::setprecision(2) << wallSeconds << "s on "
+              << threads << " threads (" << (uint64_t)(totalNodes / std::max(wallSeconds, 0.001)) << " nps)\n";
+    if(solved) {
+        std::cout << "average time to solution " << solutionTimeMs / solved << "ms, " << solutionNodes / solved << " nodes\n";
+    }
+    return 0;
+}
@@ -0,0 +1,53 @@
+#include "EngineTool.h"
+#include "../classes/Search.h"
+#include "../classes/TicTacToeState.h"
+#include "../classes/Connect4State.h"
+#include "../classes/OthelloState.h"
+#include "../classes/OthelloPatterns.h"
+#include <iostream>
+
+#ifndef ENGINETOOL_SOURCE_DIR
+#define ENGINETOOL_SOURCE_DIR "."
+#endif
+
+//
+// runs the generic alpha-beta search from a game's starting position and prints
+// every completed depth, to compare search changes across the games
+//
+
+template<typename State>
+static void searchGame(State start, const GameSearchLimits& limits)
+{
+    Search<State> search;
+    auto result = search.run(start, limits, [](const GameSearchResult<typename State::Move>& iteration) {
+        std::cout << "depth " << iteration.depth << "  score " << iteration.score << "  nodes " << iteration.nodes
+                  << "  time " << iteration.timeMs << "ms  best " << iteration.bestMove << (iteration.exact ? "  (solved)" : "") << "\n";
+    });
+    std::cout << result.nodes << " nodes " << (uint64_t)(result.nodes * 1000 / std::max(1, result.timeMs)) << " nps\n";
+}
+
+int runGameSearch(const ToolArgs& args)
+{
+    auto positional = positionalArgs(args);
+    std::string game = positional.empty() ? "connect4" : positional[0];
+    GameSearchLimits limits;
+    limits.depth = optionInt(args, "--depth", limits.depth);
+    limits.timeMs = optionInt(args, "--time", 5000);
+
+    if(game == "tictactoe") {
+        searchGame(TicTacToeState(), limits);
+    } else if(game == "connect4") {
+        searchGame(Connect4State(), limits);
+    } else if(game == "othello") {
+        OthelloState start;
+        start.board = OthelloBoard::start();
+        if(!hasOption(args, "--hand") && othelloLoadPatterns(std::string(ENGINETOOL_SOURCE_DIR) + "/" + kOthelloPatternFile)) {
+            std::cout << "pattern evaluation\n";
+        }
+        searchGame(start, limits);
+    } else {
+        std::cerr << "unknown game: " << game << "\n";
+        return 1;
+    }
+    return 0;
+}
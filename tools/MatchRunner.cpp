@@ -0,0 +1,338 @@
+#include "EngineTool.h"
+#include "../classes/ChessEngine.h"
+#include "../classes/ChessEvalParams.h"
+#include "../classes/ThreadPool.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <cmath>
+#include <ctime>
+
+//
+// engine vs engine match runner
+//
+// plays two configurations of the engine against each other on every opening
+// from an EPD file, once with each color, across a pool of worker threads. the
+// match stops early when the sequential probability ratio test accepts either
+// hypothesis: elo0 (the change is no better) or elo1 (the change gains elo1).
+//
+// the two sides are variants inside this binary (search limits and piece
+// values), so a regression check is "old settings as A, new settings as B".
+//
+
+struct MatchSide
+{
+    std::string name;
+    SearchLimits limits;
+    int pieceValues[7];
+};
+
+enum MatchOutcome
+{
+    OutcomeWhiteWins,
+    OutcomeBlackWins,
+    OutcomeDraw
+};
+
+struct MatchGame
+{
+    std::string openingFEN;
+    std::vector<std::string> sanMoves;
+    MatchOutcome outcome;
+    std::string termination;
+    int round;
+    bool aIsWhite;
+};
+
+struct MatchStats
+{
+    int wins = 0;       // from B's point of view, B is the candidate
+    int draws = 0;
+    int losses = 0;
+
+    int games() const { return wins + draws + losses; }
+    double score() const { return games() ? (wins + 0.5 * draws) / games() : 0.5; }
+    // per game variance of the score
+    double variance() const
+    {
+        if(!games()) {
+            return 0.0;
+        }
+        double mean = score();
+        return (wins * (1.0 - mean) * (1.0 - mean) + draws * (0.5 - mean) * (0.5 - mean) + losses * mean * mean) / games();
+    }
+};
+
+static double scoreToElo(double score)
+{
+    score = std::min(std::max(score, 1e-6), 1.0 - 1e-6);
+    return -400.0 * std::log10(1.0 / score - 1.0);
+}
+
+static double eloToScore(double elo)
+{
+    return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+}
+
+//
+// log likelihood ratio of elo1 against elo0, using the normal approximation to the
+// trinomial (win/draw/loss) score distribution
+//
+static double sprtLLR(const MatchStats& stats, double elo0, double elo1)
+{
+    double variance = stats.variance();
+    if(variance <= 0.0) {
+        return 0.0;
+    }
+    double s0 = eloToScore(elo0);
+    double s1 = eloToScore(elo1);
+    return stats.games() * (s1 - s0) * (2.0 * stats.score() - s0 - s1) / (2.0 * variance);
+}
+
+static bool loadOpenings(const std::string& path, std::vector<std::string>& openings)
+{
+    std::vector<EpdEntry> entries;
+    if(!loadEPD(path, entries)) {
+        return false;
+    }
+    ChessEngine check;
+    for(const auto& entry : entries) {
+        if(check.setFEN(entry.fen) && check.gameStatus() == GameOngoing) {
+            openings.push_back(entry.fen);
+        }
+    }
+    return true;
+}
+
+static void parsePieceValues(const std::string& text, int pieceValues[7])
+{
+    // comma separated Pawn..Queen, anything missing keeps the tuned value
+    for(int piece = NoPiece; piece <= King; piece++) {
+        pieceValues[piece] = kPieceValues[piece];
+    }
+    std::istringstream in(text);
+    std::string value;
+    for(int piece = Pawn; piece <= Queen && std::getline(in, value, ','); piece++) {
+        if(!value.empty()) {
+            pieceValues[piece] = std::stoi(value);
+        }
+    }
+}
+
+static SearchLimits parseLimits(const ToolArgs& args, const std::string& suffix, const SearchLimits& base)
+{
+    SearchLimits limits = base;
+    limits.depth = optionInt(args, "--depth" + suffix, limits.depth);
+    limits.nodes = (uint64_t)optionInt(args, "--nodes" + suffix, (int)limits.nodes);
+    limits.timeMs = optionInt(args, "--movetime" + suffix, limits.timeMs);
+    return limits;
+}
+
+static MatchGame playGame(ChessEngine& white, ChessEngine& black, const MatchSide& whiteSide, const MatchSide& blackSide,
+                          const std::string& openingFEN, int maxPlies)
+{
+    MatchGame game;
+    game.openingFEN = openingFEN;
+    white.setPieceValues(whiteSide.pieceValues);
+    black.setPieceValues(blackSide.pieceValues);
+    white.setFEN(openingFEN);
+    black.setFEN(openingFEN);
+    white.clearTranspositionTable();
+    black.clearTranspositionTable();
+
+    // both engines see every move so each keeps the full game history for repetitions
+    for(int ply = 0; ; ply++) {
+        GameStatus status = white.gameStatus();
+        int sideToMove = white.sideToMove();
+        if(status == GameCheckmate) {
+            game.outcome = sideToMove == 1 ? OutcomeBlackWins : OutcomeWhiteWins;
+            game.termination = "checkmate";
+            break;
+        }
+        if(status != GameOngoing) {
+            static const char* kDrawReasons[] = { "", "", "stalemate", "fifty move rule", "threefold repetition", "insufficient material" };
+            game.outcome = OutcomeDraw;
+            game.termination = kDrawReasons[status];
+            break;
+        }
+        if(ply >= maxPlies) {
+            game.outcome = OutcomeDraw;
+            game.termination = "adjudicated after " + std::to_string(maxPlies) + " plies";
+            break;
+        }
+        ChessEngine& mover = sideToMove == 1 ? white : black;
+        const MatchSide& side = sideToMove == 1 ? whiteSide : blackSide;
+        SearchResult result = mover.search(side.limits);
+        game.sanMoves.push_back(white.moveToSAN(result.bestMove));
+        white.makeMove(result.bestMove);
+        black.makeMove(result.bestMove);
+    }
+    return game;
+}
+
+static void writePGN(std::ostream& out, const MatchGame& game, const MatchSide& a, const MatchSide& b)
+{
+    static const char* kResults[] = { "1-0", "0-1", "1/2-1/2" };
+    char date[16];
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y.%m.%d", std::localtime(&now));
+
+    out << "[Event \"enginetool match\"]\n";
+    out << "[Site \"?\"]\n";
+    out << "[Date \"" << date << "\"]\n";
+    out << "[Round \"" << game.round << "\"]\n";
+    out << "[White \"" << (game.aIsWhite ? a.name : b.name) << "\"]\n";
+    out << "[Black \"" << (game.aIsWhite ? b.name : a.name) << "\"]\n";
+    out << "[Result \"" << kResults[game.outcome] << "\"]\n";
+    if(game.openingFEN != ChessEngine::startFEN()) {
+        out << "[SetUp \"1\"]\n";
+        out << "[FEN \"" << game.openingFEN << "\"]\n";
+    }
+    out << "[PlyCount \"" << game.sanMoves.size() << "\"]\n";
+    out << "[Termination \"" << game.termination << "\"]\n\n";
+
+    ChessEngine position;
+    position.setFEN(game.openingFEN);
+    int moveNumber = position.fullMoveNumber();
+    bool whiteToMove = position.sideToMove() == 1;
+    size_t lineLength = 0;
+    for(size_t i = 0; i < game.sanMoves.size(); i++) {
+        std::string token;
+        if(whiteToMove) {
+            token = std::to_string(moveNumber) + ". ";
+        } else if(i == 0) {
+            token = std::to_string(moveNumber) + "... ";
+        }
+        token += game.sanMoves[i];
+        if(lineLength + token.length() > 79) {
+            out << "\n";
+            lineLength = 0;
+        } else if(lineLength) {
+            out << " ";
+            lineLength++;
+        }
+        out << token;
+        lineLength += token.length();
+        if(!whiteToMove) {
+            moveNumber++;
+        }
+        whiteToMove = !whiteToMove;
+    }
+    out << (lineLength ? " " : "") << kResults[game.outcome] << "\n\n";
+}
+
+int runMatch(const ToolArgs& args)
+{
+    auto positional = positionalArgs(args);
+    std::vector<std::string> openings;
+    if(!positional.empty() && !loadOpenings(positional[0], openings)) {
+        std::cerr << "can't read " << positional[0] << "\n";
+        return 1;
+    }
+    if(openings.empty()) {
+        openings.push_back(ChessEngine::startFEN());
+    }
+
+    // with no limits given at all, play fast fixed node games
+    SearchLimits base;
+    base.nodes = (hasOption(args, "--depth") || hasOption(args, "--movetime")) ? 0 : 20000;
+    base = parseLimits(args, "", base);
+
+    MatchSide sides[2];
+    sides[0].name = optionValue(args, "--name-a", "A");
+    sides[1].name = optionValue(args, "--name-b", "B");
+    sides[0].limits = parseLimits(args, "-a", base);
+    sides[1].limits = parseLimits(args, "-b", base);
+    parsePieceValues(optionValue(args, "--values-a", ""), sides[0].pieceValues);
+    parsePieceValues(optionValue(args, "--values-b", ""), sides[1].pieceValues);
+
+    int threads = std::max(1, optionInt(args, "--threads", defaultThreadCount()));
+    int games = optionInt(args, "--games", (int)openings.size() * 2);
+    int maxPlies = optionInt(args, "--max-plies", 400);
+    double elo0 = std::stod(optionValue(args, "--elo0", "0"));
+    double elo1 = std::stod(optionValue(args, "--elo1", "10"));
+    double alpha = std::stod(optionValue(args, "--alpha", "0.05"));
+    double beta = std::stod(optionValue(args, "--beta", "0.05"));
+    double lowerBound = std::log(beta / (1.0 - alpha));
+    double upperBound = std::log((1.0 - beta) / alpha);
+
+    std::ofstream pgn;
+    std::string pgnPath = optionValue(args, "--pgn", "");
+    if(!pgnPath.empty()) {
+        pgn.open(pgnPath);
+        if(!pgn) {
+            std::cerr << "can't write " << pgnPath << "\n";
+            return 1;
+        }
+    }
+
+    std::cout << games << " games, " << openings.size() << " openings, " << threads << " threads, "
+              << "SPRT elo0 " << elo0 << " elo1 " << elo1 << " bounds [" << std::fixed << std::setprecision(2)
+              << lowerBound << ", " << upperBound << "]\n";
+
+    MatchStats stats;
+    std::mutex statsMutex;
+    std::atomic<int> nextGame(0);
+    std::atomic<bool> decided(false);
+    std::string verdict;
+
+    auto worker = [&]() {
+        // each worker owns its engines, the search state isn't shared between threads
+        auto engineA = std::make_unique<ChessEngine>();
+        auto engineB = std::make_unique<ChessEngine>();
+        while(!decided) {
+            int index = nextGame++;
+            if(index >= games) {
+                break;
+            }
+            // game pairs share an opening with the colors swapped
+            bool aIsWhite = (index & 1) == 0;
+            const std::string& opening = openings[(index / 2) % openings.size()];
+            MatchGame game = aIsWhite ? playGame(*engineA, *engineB, sides[0], sides[1], opening, maxPlies)
+                                      : playGame(*engineB, *engineA, sides[1], sides[0], opening, maxPlies);
+            game.round = index + 1;
+            game.aIsWhite = aIsWhite;
+
+            std::lock_guard<std::mutex> lock(statsMutex);
+            if(game.outcome == OutcomeDraw) {
+                stats.draws++;
+            } else if((game.outcome == OutcomeWhiteWins) == aIsWhite) {
+                stats.losses++;
+            } else {
+                stats.wins++;
+            }
+            if(pgn) {
+                writePGN(pgn, game, sides[0], sides[1]);
+            }
+            double llr = sprtLLR(stats, elo0, elo1);
+            std::cout << "game " << std::setw(5) << game.round << "  +" << stats.wins << " =" << stats.draws << " -" << stats.losses
+                      << "  LLR " << std::setprecision(2) << llr << "  (" << game.termination << ")\n";
+            if(!decided && (llr >= upperBound || llr <= lowerBound)) {
+                verdict = llr >= upperBound ? "H1 accepted: B is stronger" : "H0 accepted: B is not stronger";
+                decided = true;
+            }
+        }
+    };
+
+    ThreadPool pool(threads);
+    TaskGroup group(pool);
+    for(int t = 0; t < threads; t++) {
+        group.run(worker);
+    }
+    group.wait();
+
+    // elo difference of B over A with a 95% confidence interval
+    double score = stats.score();
+    double margin = stats.games() ? 1.96 * std::sqrt(stats.variance() / stats.games()) : 0.0;
+    std::cout << "\n" << stats.games() << " games  " << sides[1].name << " vs " << sides[0].name
+              << ": +" << stats.wins << " =" << stats.draws << " -" << stats.losses << "\n";
+    std::cout << "elo " << std::setprecision(1) << scoreToElo(score)
+              << " [" << scoreToElo(score - margin) << ", " << scoreToElo(score + margin) << "]\n";
+    std::cout << "SPRT: " << (verdict.empty() ? "inconclusive" : verdict) << " (LLR " << std::setprecision(2)
+              << sprtLLR(stats, elo0, elo1) << ")\n";
+    return 0;
+}
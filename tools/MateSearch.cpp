@@ -0,0 +1,92 @@
+#include "EngineTool.h"
+#include "../classes/ChessEngine.h"
+#include "../classes/MateSolver.h"
+#include <iostream>
+#include <memory>
+#include <algorithm>
+
+//
+// proof-number mate solver front end
+//
+// takes either a single FEN or an EPD file. EPD positions with a "dm" (direct
+// mate) operation are checked against it: the solver has to find a mate of
+// exactly that length, since it always finds the shortest one.
+//
+
+static std::string describe(ChessEngine& position, const MateResult& result)
+{
+    if(result.status == MateDisproven) {
+        return "no mate";
+    }
+    if(result.status == MateUnknown) {
+        return "unknown (node limit)";
+    }
+    std::string text = "mate in " + std::to_string(result.mateIn) + ":";
+    int made = 0;
+    for(const auto& move : result.line) {
+        text += ' ';
+        text += position.moveToSAN(move);
+        position.makeMove(move);
+        made++;
+    }
+    while(made--) {
+        position.unmakeMove();
+    }
+    return text;
+}
+
+int runMate(const ToolArgs& args)
+{
+    auto positional = positionalArgs(args);
+    if(positional.empty()) {
+        std::cerr << "usage: enginetool mate <\"FEN\" | problems.epd> [--moves N] [--nodes N]\n";
+        return 1;
+    }
+    int maxMoves = optionInt(args, "--moves", 5);
+    uint64_t nodeLimit = (uint64_t)optionInt(args, "--nodes", 10000000);
+
+    std::vector<EpdEntry> entries;
+    const std::string& source = positional[0];
+    if(source.size() > 4 && source.compare(source.size() - 4, 4, ".epd") == 0) {
+        if(!loadEPD(source, entries)) {
+            std::cerr << "can't read " << source << "\n";
+            return 1;
+        }
+    } else {
+        EpdEntry entry;
+        entry.fen = source;
+        entries.push_back(entry);
+    }
+
+    auto position = std::make_unique<ChessEngine>();
+    MateSolver solver;
+    int checked = 0, correct = 0;
+    uint64_t totalNodes = 0;
+    for(size_t i = 0; i < entries.size(); i++) {
+        const EpdEntry& entry = entries[i];
+        auto id = entry.operations.find("id");
+        std::string name = id != entry.operations.end() ? id->second : std::to_string(i + 1);
+        if(!position->setFEN(entry.fen)) {
+            std::cout << name << ": bad FEN\n";
+            continue;
+        }
+        auto dm = entry.operations.find("dm");
+        int expected = dm != entry.operations.end() ? std::stoi(dm->second) : 0;
+        MateResult result = solver.solve(*position, expected ? std::max(expected, maxMoves) : maxMoves, nodeLimit);
+        totalNodes += result.nodes;
+
+        std::cout << name << ": " << describe(*position, result) << "  (" << result.nodes << " nodes, " << result.timeMs << "ms)";
+        if(expected) {
+            checked++;
+            bool ok = result.status == MateProven && result.mateIn == expected;
+            correct += ok ? 1 : 0;
+            std::cout << (ok ? "" : "  expected mate in " + std::to_string(expected));
+        }
+        std::cout << "\n";
+    }
+    if(checked) {
+        std::cout << "\n" << correct << " / " << checked << " mates verified, " << totalNodes << " nodes\n";
+        return correct == checked ? 0 : 2;
+    }
+    return 0;
+}
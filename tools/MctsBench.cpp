@@ -0,0 +1,67 @@
+#include "EngineTool.h"
+#include "../classes/MCTS.h"
+#include "../classes/Connect4State.h"
+#include "../classes/OthelloState.h"
+#include "../classes/CheckersState.h"
+#include <iostream>
+#include <iomanip>
+
+//
+// MCTS scaling report
+//
+// searches the starting position of a game for a fixed time with 1, 2, 4 ... N
+// playout threads and prints the playout rate of each, so the speedup from the
+// tree parallel search can be seen on this machine.
+//
+
+template<typename State>
+static void benchGame(const State& start, int timeMs, int maxThreads)
+{
+    double single = 0;
+    for(int threads = 1; ; threads = std::min(threads * 2, maxThreads)) {
+        MCTSLimits limits;
+        limits.threads = threads;
+        limits.timeMs = timeMs;
+        MCTS<State> mcts;
+        auto result = mcts.search(start, limits);
+        if(threads == 1) {
+            single = result.playoutsPerSecond;
+        }
+        std::cout << std::setw(3) << threads << " threads  " << std::setw(9) << result.playouts << " playouts  "
+                  << std::setw(9) << (uint64_t)result.playoutsPerSecond << "/s  " << std::setw(8) << result.nodes << " nodes  "
+                  << std::fixed << std::setprecision(2) << result.playoutsPerSecond / std::max(1.0, single) << "x\n";
+        if(threads == maxThreads) {
+            break;
+        }
+    }
+}
+
+int runMcts(const ToolArgs& args)
+{
+    auto positional = positionalArgs(args);
+    std::string game = positional.empty() ? "connect4" : positional[0];
+    int timeMs = optionInt(args, "--time", 1000);
+    int maxThreads = std::max(1, optionInt(args, "--threads", defaultThreadCount()));
+
+    if(game == "connect4") {
+        benchGame(Connect4State(), timeMs, maxThreads);
+    } else if(game == "othello") {
+        OthelloState start;
+        start.board = OthelloBoard::start();
+        benchGame(start, timeMs, maxThreads);
+    } else if(game == "checkers") {
+        CheckersState start;
+        for(int square = 0; square < 64; square++) {
+            int x = square % 8;
+            int y = square / 8;
+            if((x + y) % 2 == 1) {
+                start.board[square] = y < 3 ? CheckersState::RedPiece : y > 4 ? CheckersState::YellowPiece : CheckersState::Empty;
+            }
+        }
+        benchGame(start, timeMs, maxThreads);
+    } else {
+        std::cerr << "unknown game: " << game << "\n";
+        return 1;
+    }
+    return 0;
+}
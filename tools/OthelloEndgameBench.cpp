@@ -0,0 +1,128 @@
+#include "EngineTool.h"
+#include "../classes/OthelloEndgame.h"
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <bit>
+
+//
+// Othello endgame solver benchmark: plays random games down to the given number of
+// empty squares and solves each position exactly, once in a single thread and once
+// split over the thread pool. the two scores have to agree. --check also searches
+// every position from 1 empty square up to the given number with a plain minimax
+// and fails if either solve disagrees with it.
+//
+
+static OthelloBoard randomPosition(std::mt19937_64& random, int empties, int& player)
+{
+    while(true) {
+        OthelloBoard board = OthelloBoard::start();
+        player = 0;
+        while(std::popcount(board.empty()) > empties && !board.gameOver()) {
+            uint64_t moves = board.moves(player);
+            if(moves) {
+                for(int skip = (int)(random() % std::popcount(moves)); skip > 0; skip--) {
+                    moves &= moves - 1;
+                }
+                board.play(player, std::countr_zero(moves));
+            }
+            player ^= 1;
+        }
+        // a position the side to move can play from
+        if(std::popcount(board.empty()) == empties && board.moves(player)) {
+            return board;
+        }
+    }
+}
+
+// the whole tree without pruning or a table, slow but hard to get wrong. the score is
+// the solver's: the final disc margin with the empty squares going to the winner.
+static int minimax(uint64_t player, uint64_t opponent, bool passed)
+{
+    uint64_t moves = OthelloBoard::mobility(player, opponent);
+    if(!moves) {
+        if(passed) {
+            int margin = std::popcount(player) - std::popcount(opponent);
+            int empties = std::popcount(~(player | opponent));
+            return margin > 0 ? margin + empties : margin < 0 ? margin - empties : 0;
+        }
+        return -minimax(opponent, player, true);
+    }
+    int best = -65;
+    for(; moves; moves &= moves - 1) {
+        int square = std::countr_zero(moves);
+        uint64_t flipped = OthelloBoard::flips(square, player, opponent);
+        best = std::max(best, -minimax(opponent & ~flipped, player | flipped | (1ULL << square), false));
+    }
+    return best;
+}
+
+static int checkAgainstMinimax(int maxEmpties, int positions, std::mt19937_64& random)
+{
+    OthelloEndgame solver;
+    int failed = 0;
+    for(int empties = 1; empties <= maxEmpties; empties++) {
+        for(int i = 0; i < positions; i++) {
+            int player;
+            OthelloBoard board = randomPosition(random, empties, player);
+            int expected = minimax(board.discs[player], board.discs[player ^ 1], false);
+            solver.clear();
+            int serial = solver.solve(board, player, 0, false).score;
+            solver.clear();
+            int parallel = solver.solve(board, player, 0, true).score;
+            if(serial != expected || parallel != expected) {
+                std::cout << empties << " empties, position " << i + 1 << ": serial " << serial << ", parallel " << parallel
+                          << ", minimax " << expected << "\n";
+                failed++;
+            }
+        }
+    }
+    std::cout << maxEmpties * positions - failed << " / " << maxEmpties * positions << " positions agree with minimax\n";
+    return failed ? 1 : 0;
+}
+
+static void printSolve(const char* name, const EndgameResult& result)
+{
+    std::cout << "  " << std::left << std::setw(9) << name << std::right << "score " << std::setw(3) << std::showpos << result.score
+              << std::noshowpos << "  move " << std::setw(2) << result.bestMove << "  " << std::setw(11) << result.nodes << " nodes  "
+              << std::setw(6) << result.timeMs << "ms  " << std::fixed << std::setprecision(1) << result.nodesPerSecond / 1e6
+              << "M nodes/s" << (result.complete ? "" : "  (out of time)") << "\n";
+}
+
+int runOthelloEndgame(const ToolArgs& args)
+{
+    auto positional = positionalArgs(args);
+    int empties = positional.empty() ? OthelloEndgame::kDefaultEmpties : std::stoi(positional[0]);
+    int positions = optionInt(args, "--positions", 5);
+    int timeMs = optionInt(args, "--time", 0);
+    std::mt19937_64 random(optionInt(args, "--seed", 1));
+    if(hasOption(args, "--check")) {
+        return checkAgainstMinimax(empties, positions, random);
+    }
+
+    OthelloEndgame solver;
+    uint64_t serialNodes = 0, parallelNodes = 0;
+    int serialMs = 0, parallelMs = 0;
+    for(int i = 0; i < positions; i++) {
+        int player;
+        OthelloBoard board = randomPosition(random, empties, player);
+        std::cout << "position " << i + 1 << ", " << empties << " empties, " << (player == 0 ? "black" : "white") << " to move\n";
+        solver.clear();
+        EndgameResult serial = solver.solve(board, player, timeMs, false);
+        printSolve("serial", serial);
+        solver.clear();
+        EndgameResult parallel = solver.solve(board, player, timeMs, true);
+        printSolve("parallel", parallel);
+        if(serial.complete && parallel.complete && serial.score != parallel.score) {
+            std::cout << "scores differ\n";
+            return 1;
+        }
+        serialNodes += serial.nodes;
+        serialMs += serial.timeMs;
+        parallelNodes += parallel.nodes;
+        parallelMs += parallel.timeMs;
+    }
+    std::cout << "total serial " << serialNodes << " nodes " << serialMs << "ms, parallel " << parallelNodes << " nodes "
+              << parallelMs << "ms\n";
+    return 0;
+}
@@ -0,0 +1,67 @@
+#include "EngineTool.h"
+#include "../classes/OthelloBoard.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <bit>
+
+//
+// Othello perft: counts the move sequences of a given length from the starting
+// position, a pass counting as a move, once with the scalar fills and once with
+// whatever the board picked for this machine. the counts have to agree with each
+// other and with the published ones.
+//
+
+// published counts from the starting position, index is the depth
+static const uint64_t kOthelloPerftCounts[] = { 1, 4, 12, 56, 244, 1396, 8200, 55092, 390216, 3005288, 24571284, 212258800 };
+
+template<bool scalar>
+static uint64_t perft(uint64_t player, uint64_t opponent, int depth, bool passed)
+{
+    if(depth == 0) {
+        return 1;
+    }
+    uint64_t moves = scalar ? OthelloBoard::mobilityScalar(player, opponent) : OthelloBoard::mobility(player, opponent);
+    if(!moves) {
+        // two passes in a row end the game
+        return passed ? 1 : perft<scalar>(opponent, player, depth - 1, true);
+    }
+    uint64_t count = 0;
+    while(moves) {
+        int square = std::countr_zero(moves);
+        moves &= moves - 1;
+        uint64_t flipped = scalar ? OthelloBoard::flipsScalar(square, player, opponent) : OthelloBoard::flips(square, player, opponent);
+        count += perft<scalar>(opponent & ~flipped, player | flipped | (1ULL << square), depth - 1, false);
+    }
+    return count;
+}
+
+template<bool scalar>
+static uint64_t timedPerft(const char* name, int depth)
+{
+    OthelloBoard start = OthelloBoard::start();
+    auto begin = std::chrono::steady_clock::now();
+    uint64_t count = perft<scalar>(start.discs[0], start.discs[1], depth, false);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    std::cout << std::left << std::setw(8) << name << std::right << " depth " << depth << "  " << std::setw(12) << count
+              << " leaves  " << std::fixed << std::setprecision(1) << std::setw(8) << seconds * 1000 << "ms  "
+              << std::setprecision(2) << seconds * 1e9 / std::max<uint64_t>(count, 1) << "ns per leaf\n";
+    return count;
+}
+
+int runOthelloPerft(const ToolArgs& args)
+{
+    auto positional = positionalArgs(args);
+    int depth = positional.empty() ? 9 : std::stoi(positional[0]);
+    uint64_t scalar = timedPerft<true>("scalar", depth);
+    uint64_t chosen = timedPerft<false>(OthelloBoard::usingAVX2() ? "avx2" : "default", depth);
+    if(scalar != chosen) {
+        std::cout << "counts differ\n";
+        return 1;
+    }
+    if(depth >= 0 && depth < (int)std::size(kOthelloPerftCounts) && scalar != kOthelloPerftCounts[depth]) {
+        std::cout << "expected " << kOthelloPerftCounts[depth] << "\n";
+        return 1;
+    }
+    return 0;
+}
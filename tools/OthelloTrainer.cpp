@@ -0,0 +1,264 @@
+#include "EngineTool.h"
+#include "../classes/OthelloState.h"
+#include "../classes/OthelloPatterns.h"
+#include "../classes/OthelloEndgame.h"
+#include "../classes/ThreadPool.h"
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+
+#ifndef ENGINETOOL_SOURCE_DIR
+#define ENGINETOOL_SOURCE_DIR "."
+#endif
+
+//
+// trains the Othello pattern weights
+//
+// self-play first: each game opens with a few random moves, goes on with a shallow
+// search using the current evaluation, and is played perfectly by the endgame solver
+// from a fixed number of empties. every position is labelled with the game's final
+// disc margin for its side to move, and is used a second time mirrored along the
+// main diagonal.
+//
+// --positions keeps the self-play positions in a file and reuses them when it exists.
+//
+// then the weights are fitted by least squares: the evaluation is linear in them,
+// so each pass over the positions (split over the pool) adds up the error times
+// every feature, and each weight steps by its sum over the number of positions
+// that use it.
+//
+
+struct TrainingPosition
+{
+    OthelloBoard board;
+    int8_t player;
+    int8_t score;           // final disc margin for player
+};
+
+// the same position reflected in the a1-h8 diagonal
+static uint64_t transpose(uint64_t discs)
+{
+    uint64_t t;
+    t = 0x0F0F0F0F00000000ULL & (discs ^ (discs << 28)); discs ^= t ^ (t >> 28);
+    t = 0x3333000033330000ULL & (discs ^ (discs << 14)); discs ^= t ^ (t >> 14);
+    t = 0x5500550055005500ULL & (discs ^ (discs << 7));  discs ^= t ^ (t >> 7);
+    return discs;
+}
+
+static const char kPositionsMagic[4] = { 'O', 'T', 'S', '1' };
+
+// self-play positions, so the fit can be rerun with other settings without playing again
+static bool savePositions(const std::string& path, const std::vector<TrainingPosition>& positions)
+{
+    std::ofstream out(path, std::ios::binary);
+    uint32_t count = (uint32_t)positions.size();
+    out.write(kPositionsMagic, sizeof(kPositionsMagic));
+    out.write((const char*)&count, sizeof(count));
+    out.write((const char*)positions.data(), positions.size() * sizeof(TrainingPosition));
+    return (bool)out;
+}
+
+static bool loadPositions(const std::string& path, std::vector<TrainingPosition>& positions)
+{
+    std::ifstream in(path, std::ios::binary);
+    char magic[4];
+    uint32_t count = 0;
+    if(!in.read(magic, sizeof(magic)) || std::memcmp(magic, kPositionsMagic, sizeof(magic)) != 0 ||
+       !in.read((char*)&count, sizeof(count))) {
+        return false;
+    }
+    positions.resize(count);
+    return (bool)in.read((char*)positions.data(), count * sizeof(TrainingPosition));
+}
+
+static void playGame(std::mt19937_64& random, Search<OthelloState>& search, OthelloEndgame& endgame, int randomMoves,
+                     int depth, int solveEmpties, std::vector<TrainingPosition>& positions)
+{
+    OthelloBoard board = OthelloBoard::start();
+    int player = 0;
+    size_t first = positions.size();
+    for(int ply = 0; !board.gameOver(); ply++) {
+        uint64_t moves = board.moves(player);
+        if(!moves) {
+            player ^= 1;
+            continue;
+        }
+        int square;
+        if(ply < randomMoves) {
+            for(int skip = (int)(random() % std::popcount(moves)); skip > 0; skip--) {
+                moves &= moves - 1;
+            }
+            square = std::countr_zero(moves);
+        } else {
+            positions.push_back({ board, (int8_t)player, 0 });
+            if(std::popcount(board.empty()) <= solveEmpties) {
+                square = endgame.solve(board, player, 0, false).bestMove;
+            } else {
+                OthelloState state;
+                state.board = board;
+                state.toMove = player;
+                GameSearchLimits limits;
+                limits.depth = depth;
+                square = search.run(state, limits).bestMove;
+            }
+        }
+        board.play(player, square);
+        player ^= 1;
+    }
+
+    int own = board.count(0);
+    int other = board.count(1);
+    int margin = own - other;
+    margin += margin > 0 ? 64 - own - other : margin < 0 ? own + other - 64 : 0;
+    for(size_t i = first; i < positions.size(); i++) {
+        positions[i].score = (int8_t)(positions[i].player == 0 ? margin : -margin);
+    }
+}
+
+int runOthelloTrain(const ToolArgs& args)
+{
+    int threads = optionInt(args, "--threads", defaultThreadCount());
+    ThreadPool pool(threads);
+    int games = optionInt(args, "--games", 2000);
+    int randomMoves = optionInt(args, "--random", 10);
+    int depth = optionInt(args, "--depth", 4);
+    int solveEmpties = optionInt(args, "--solve", 14);
+    int iterations = optionInt(args, "--iterations", 200);
+    double rate = std::stod(optionValue(args, "--rate", "1.5"));
+    std::string outPath = optionValue(args, "--out", std::string(ENGINETOOL_SOURCE_DIR) + "/" + kOthelloPatternFile);
+    std::string weightsPath = optionValue(args, "--weights", outPath);
+    std::string positionsPath = optionValue(args, "--positions", "");
+
+    auto startTime = std::chrono::steady_clock::now();
+    auto elapsed = [&]() {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    };
+
+    std::vector<TrainingPosition> positions;
+    if(positionsPath.empty() || !loadPositions(positionsPath, positions)) {
+        // self-play with whatever the evaluation is now, so each run builds on the last
+        bool trained = othelloLoadPatterns(weightsPath);
+        std::cout << "self-play with the " << (trained ? "pattern" : "hand written") << " evaluation, " << games << " games using "
+                  << pool.threadCount() << " threads" << std::endl;
+        std::vector<std::vector<TrainingPosition>> played(pool.threadCount());
+        parallelFor(pool, games, [&](size_t begin, size_t end, int t) {
+            Search<OthelloState> search(1 << 16);
+            OthelloEndgame endgame(1 << 16);
+            for(size_t game = begin; game < end; game++) {
+                std::mt19937_64 random(game + 1);
+                playGame(random, search, endgame, randomMoves, depth, solveEmpties, played[t]);
+            }
+        });
+        for(auto& part : played) {
+            positions.insert(positions.end(), part.begin(), part.end());
+            part.clear();
+            part.shrink_to_fit();
+        }
+        if(!positionsPath.empty() && !savePositions(positionsPath, positions)) {
+            std::cout << "can't write " << positionsPath << std::endl;
+        }
+    }
+    size_t count = positions.size();
+    for(size_t i = 0; i < count; i++) {
+        TrainingPosition mirrored = positions[i];
+        mirrored.board.discs[0] = transpose(mirrored.board.discs[0]);
+        mirrored.board.discs[1] = transpose(mirrored.board.discs[1]);
+        positions.push_back(mirrored);
+    }
+    std::cout << positions.size() << " positions in " << elapsed() << "s" << std::endl;
+
+    // the features of every position, with the phase folded into the indices
+    const int instances = othelloPatternInstanceCount();
+    const size_t weightCount = othelloPatternWeightCount();
+    const size_t totalWeights = weightCount * kOthelloPhases;
+    std::vector<int32_t> indices(positions.size() * instances);
+    std::vector<int32_t> bases(positions.size());
+    std::vector<int8_t> mobilities(positions.size());
+    std::vector<int8_t> scores(positions.size());
+    parallelFor(pool, positions.size(), [&](size_t begin, size_t end, int t) {
+        for(size_t i = begin; i < end; i++) {
+            const TrainingPosition& position = positions[i];
+            int mobility;
+            int32_t* features = &indices[i * instances];
+            int local[64];
+            othelloPatternFeatures(position.board, position.player, local, mobility);
+            bases[i] = (int32_t)(othelloPhase(std::popcount(position.board.empty())) * weightCount);
+            for(int j = 0; j < instances; j++) {
+                features[j] = bases[i] + local[j];
+            }
+            mobilities[i] = (int8_t)mobility;
+            scores[i] = position.score;
+        }
+    });
+    positions.clear();
+    positions.shrink_to_fit();
+
+    // how much each weight is used, to scale its steps
+    std::vector<double> usage(totalWeights, 0.0);
+    for(size_t i = 0; i < scores.size(); i++) {
+        for(int j = 0; j < instances; j++) {
+            usage[indices[i * instances + j]] += 1;
+        }
+        usage[bases[i] + weightCount - 2] += mobilities[i] * mobilities[i];
+        usage[bases[i] + weightCount - 1] += 1;
+    }
+
+    // weights in discs while fitting, hundredths in the file
+    std::vector<double> weights(totalWeights, 0.0);
+    std::vector<std::vector<double>> partials(pool.threadCount(), std::vector<double>(totalWeights, 0.0));
+    std::vector<double> errors(pool.threadCount(), 0.0);
+    for(int iteration = 1; iteration <= iterations; iteration++) {
+        parallelFor(pool, scores.size(), [&](size_t begin, size_t end, int t) {
+            std::vector<double>& gradient = partials[t];
+            double sum = 0;
+            for(size_t i = begin; i < end; i++) {
+                const int32_t* features = &indices[i * instances];
+                size_t mobilityWeight = bases[i] + weightCount - 2;
+                double eval = weights[mobilityWeight] * mobilities[i] + weights[mobilityWeight + 1];
+                for(int j = 0; j < instances; j++) {
+                    eval += weights[features[j]];
+                }
+                double error = scores[i] - eval;
+                sum += error * error;
+                for(int j = 0; j < instances; j++) {
+                    gradient[features[j]] += error;
+                }
+                gradient[mobilityWeight] += error * mobilities[i];
+                gradient[mobilityWeight + 1] += error;
+            }
+            errors[t] = sum;
+        });
+        double error = 0;
+        for(double part : errors) {
+            error += part;
+        }
+        for(size_t w = 0; w < totalWeights; w++) {
+            double gradient = 0;
+            for(auto& partial : partials) {
+                gradient += partial[w];
+                partial[w] = 0;
+            }
+            // every position has instances + 2 features that all step at once, so each only
+            // takes its share. a little damping keeps rarely seen patterns near zero.
+            weights[w] += rate * gradient / ((usage[w] + 4) * (instances + 2));
+        }
+        if(iteration % 20 == 0 || iteration == 1 || iteration == iterations) {
+            std::cout << "iteration " << iteration << " rms error " << std::sqrt(error / scores.size()) << " discs  " << elapsed() << "s" << std::endl;
+        }
+    }
+
+    std::vector<int16_t> packed(totalWeights);
+    for(size_t w = 0; w < totalWeights; w++) {
+        packed[w] = (int16_t)std::clamp<long>(std::lround(weights[w] * 100), -32000, 32000);
+    }
+    if(!othelloSavePatterns(outPath, packed)) {
+        std::cout << "can't write " << outPath << std::endl;
+        return 1;
+    }
+    std::cout << "wrote " << outPath << std::endl;
+    return 0;
+}
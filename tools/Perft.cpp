@@ -0,0 +1,90 @@
+#include "EngineTool.h"
+#include "../classes/ChessEngine.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+
+//
+// chess perft: counts the legal move sequences of a given length, which checks the
+// move generator and make/unmake against published counts. --check runs the standard
+// positions (chessprogramming.org's perft results) to a depth that takes a few
+// seconds and fails if any count is off.
+//
+
+struct PerftPosition
+{
+    const char* name;
+    const char* fen;
+    int depth;
+    uint64_t count;
+};
+
+static const PerftPosition kPerftPositions[] = {
+    { "start",    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",                 5, 4865609 },
+    { "kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",     4, 4085603 },
+    { "3",        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",                                5, 674624 },
+    { "4",        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",         4, 422333 },
+    { "5",        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",                4, 2103487 },
+    { "6",        "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",  4, 3894594 },
+};
+
+static uint64_t perft(ChessEngine& engine, int depth)
+{
+    std::vector<BitMove> moves = engine.generateAllMoves();
+    if(depth <= 1) {
+        return depth == 1 ? moves.size() : 1;
+    }
+    uint64_t count = 0;
+    for(const BitMove& move : moves) {
+        engine.makeMove(move);
+        count += perft(engine, depth - 1);
+        engine.unmakeMove();
+    }
+    return count;
+}
+
+static uint64_t timedPerft(ChessEngine& engine, const std::string& name, int depth)
+{
+    auto begin = std::chrono::steady_clock::now();
+    uint64_t count = perft(engine, depth);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    std::cout << std::left << std::setw(10) << name << std::right << " depth " << depth << "  " << std::setw(12) << count
+              << " leaves  " << std::fixed << std::setprecision(1) << std::setw(8) << seconds * 1000 << "ms" << std::endl;
+    return count;
+}
+
+int runPerft(const ToolArgs& args)
+{
+    ChessEngine engine;
+    if(hasOption(args, "--check")) {
+        int failed = 0;
+        for(const PerftPosition& position : kPerftPositions) {
+            engine.setFEN(position.fen);
+            uint64_t count = timedPerft(engine, position.name, position.depth);
+            if(count != position.count) {
+                std::cout << "  expected " << position.count << std::endl;
+                failed++;
+            }
+        }
+        std::cout << (int)std::size(kPerftPositions) - failed << " / " << std::size(kPerftPositions) << " positions correct" << std::endl;
+        return failed ? 1 : 0;
+    }
+
+    auto positional = positionalArgs(args);
+    int depth = positional.empty() ? 5 : std::stoi(positional[0]);
+    std::string fen = optionValue(args, "--fen", ChessEngine::startFEN());
+    if(!engine.setFEN(fen)) {
+        std::cout << "bad FEN: " << fen << std::endl;
+        return 1;
+    }
+    // the count below each root move, to narrow a wrong total down
+    if(hasOption(args, "--divide")) {
+        for(const BitMove& move : engine.generateAllMoves()) {
+            engine.makeMove(move);
+            std::cout << ChessEngine::moveToString(move) << ": " << perft(engine, depth - 1) << std::endl;
+            engine.unmakeMove();
+        }
+    }
+    timedPerft(engine, "perft", depth);
+    return 0;
+}
@@ -0,0 +1,99 @@
+#include "EngineTool.h"
+#include "../classes/ThreadPool.h"
+#include <iostream>
+#include <iomanip>
+#include <future>
+#include <chrono>
+
+//
+// thread pool throughput
+//
+// runs the same batch of small tasks through the pool and through std::async, which
+// starts a thread per task, and then a recursive fork-join split that only the pool
+// can do without starting thousands of threads. all three add up the same values,
+// the command fails if their totals differ.
+//
+
+// a little arithmetic that the compiler can't drop
+static uint64_t busyWork(uint64_t seed, int work)
+{
+    uint64_t value = seed | 1;
+    for(int i = 0; i < work; i++) {
+        value ^= value << 13;
+        value ^= value >> 7;
+        value ^= value << 17;
+    }
+    return value;
+}
+
+static void report(const char* name, int tasks, std::chrono::steady_clock::time_point start, uint64_t check)
+{
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << std::left << std::setw(12) << name << std::right << std::setw(10) << tasks << " tasks  "
+              << std::fixed << std::setprecision(1) << std::setw(8) << seconds * 1000 << "ms  "
+              << std::setw(10) << (uint64_t)(tasks / std::max(seconds, 1e-9)) << " tasks/s  (" << (check & 0xFFFF) << ")\n";
+}
+
+// splits [begin, end) in halves until a piece is one task
+static void splitSum(ThreadPool& pool, int begin, int end, int work, std::atomic<uint64_t>& total)
+{
+    if(end - begin == 1) {
+        total += busyWork(begin, work);
+        return;
+    }
+    int middle = (begin + end) / 2;
+    TaskGroup group(pool);
+    group.run([&pool, begin, middle, work, &total]() { splitSum(pool, begin, middle, work, total); });
+    splitSum(pool, middle, end, work, total);
+    group.wait();
+}
+
+int runPoolBench(const ToolArgs& args)
+{
+    int tasks = std::max(1, optionInt(args, "--tasks", 20000));
+    int work = optionInt(args, "--work", 1000);
+    int threads = optionInt(args, "--threads", defaultThreadCount());
+    ThreadPool pool(threads);
+    std::cout << pool.threadCount() << " pool threads, " << work << " steps per task\n";
+
+    uint64_t poolTotal = 0, splitTotal = 0, asyncTotal = 0;
+    {
+        auto start = std::chrono::steady_clock::now();
+        std::atomic<uint64_t> total(0);
+        TaskGroup group(pool);
+        for(int i = 0; i < tasks; i++) {
+            group.run([i, work, &total]() { total += busyWork(i, work); });
+        }
+        group.wait();
+        poolTotal = total;
+        report("pool", tasks, start, total);
+    }
+    {
+        auto start = std::chrono::steady_clock::now();
+        std::atomic<uint64_t> total(0);
+        TaskGroup root(pool);
+        root.run([&]() { splitSum(pool, 0, tasks, work, total); });
+        root.wait();
+        splitTotal = total;
+        report("pool split", tasks, start, total);
+    }
+    {
+        auto start = std::chrono::steady_clock::now();
+        uint64_t total = 0;
+        std::vector<std::future<uint64_t>> futures;
+        futures.reserve(tasks);
+        for(int i = 0; i < tasks; i++) {
+            futures.push_back(std::async(std::launch::async, busyWork, (uint64_t)i, work));
+        }
+        for(auto& future : futures) {
+            total += future.get();
+        }
+        asyncTotal = total;
+        report("std::async", tasks, start, total);
+    }
+    if(poolTotal != asyncTotal || splitTotal != asyncTotal) {
+        std::cout << "totals differ\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,330 @@
+#include "EngineTool.h"
+#include "../classes/ChessEngine.h"
+#include "../classes/ChessEvalParams.h"
+#include "../classes/ThreadPool.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <cctype>
+#include <array>
+#include <algorithm>
+
+#ifndef ENGINETOOL_SOURCE_DIR
+#define ENGINETOOL_SOURCE_DIR "."
+#endif
+
+//
+// Texel tuning of the chess evaluation weights
+//
+// positions are stored in a compact binary file: an 8 byte header ("TXL1" plus a
+// record count) followed by fixed size records. each record packs the board into
+// 4 bits per square, so a million positions is about 34MB.
+//
+// the tuner minimizes the mean squared error between the game result and
+// sigmoid(K * eval) over every position, where K is fitted first so the
+// original weights are as good as they can be.
+//
+
+static const char kTexelMagic[4] = { 'T', 'X', 'L', '1' };
+
+struct TexelRecord
+{
+    uint8_t squares[32];    // two squares per byte, low nibble first. 1-6 white, 9-14 black
+    uint8_t sideToMove;     // 0 white, 1 black
+    uint8_t result;         // 0 black won, 1 draw, 2 white won
+};
+static_assert(sizeof(TexelRecord) == 34, "TexelRecord must stay packed");
+
+// the tuned weights are Pawn..Queen, the king is never traded so its value is fixed
+constexpr int kTunedFirst = Pawn;
+constexpr int kTunedCount = Queen - Pawn + 1;
+
+struct TexelEntry
+{
+    int8_t terms[kTunedCount];
+    uint8_t result;         // same encoding as TexelRecord, halved when scored
+};
+
+static bool parseResult(const std::string& line, uint8_t& result)
+{
+    static const struct { const char* text; uint8_t result; } kResults[] = {
+        { "1/2-1/2", 1 }, { "1-0", 2 }, { "0-1", 0 },
+        { "[0.5]", 1 }, { "[1.0]", 2 }, { "[0.0]", 0 }, { "[1]", 2 }, { "[0]", 0 },
+    };
+    for(const auto& candidate : kResults) {
+        if(line.find(candidate.text) != std::string::npos) {
+            result = candidate.result;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void packRecord(const ChessEngine& engine, uint8_t result, TexelRecord& record)
+{
+    std::memset(&record, 0, sizeof(record));
+    for(int square = 0; square < 64; square++) {
+        char piece = engine.pieceAt(square);
+        ChessPiece type = ChessEngine::pieceType(piece);
+        uint8_t code = type == NoPiece ? 0 : (std::isupper((unsigned char)piece) ? type : type + 8);
+        record.squares[square / 2] |= code << ((square & 1) * 4);
+    }
+    record.sideToMove = engine.sideToMove() == 1 ? 0 : 1;
+    record.result = result;
+}
+
+static void unpackRecord(const TexelRecord& record, ChessEngine& engine)
+{
+    static const char kCodes[] = "0PNBRQK00pnbrqk0";
+    std::string state(64, '0');
+    for(int square = 0; square < 64; square++) {
+        state[square] = kCodes[(record.squares[square / 2] >> ((square & 1) * 4)) & 15];
+    }
+    engine.setStateString(state, record.sideToMove ? -1 : 1);
+}
+
+int runTunePack(const ToolArgs& args)
+{
+    auto files = positionalArgs(args);
+    if(files.size() < 2) {
+        std::cout << "usage: enginetool tune-pack <positions.txt> <positions.bin>" << std::endl;
+        return 1;
+    }
+    std::ifstream in(files[0]);
+    if(!in) {
+        std::cout << "can't open " << files[0] << std::endl;
+        return 1;
+    }
+    std::vector<TexelRecord> records;
+    std::string line;
+    size_t skipped = 0;
+    ChessEngine engine;
+    while(std::getline(in, line)) {
+        uint8_t result;
+        if(!parseResult(line, result) || !engine.setFEN(line)) {
+            skipped++;
+            continue;
+        }
+        records.emplace_back();
+        packRecord(engine, result, records.back());
+    }
+
+    std::ofstream out(files[1], std::ios::binary);
+    uint32_t count = (uint32_t)records.size();
+    out.write(kTexelMagic, sizeof(kTexelMagic));
+    out.write((const char*)&count, sizeof(count));
+    out.write((const char*)records.data(), records.size() * sizeof(TexelRecord));
+    std::cout << "packed " << records.size() << " positions, skipped " << skipped << " lines" << std::endl;
+    return out ? 0 : 1;
+}
+
+static bool loadRecords(const std::string& path, std::vector<TexelRecord>& records)
+{
+    std::ifstream in(path, std::ios::binary);
+    char magic[4];
+    uint32_t count = 0;
+    if(!in.read(magic, sizeof(magic)) || std::memcmp(magic, kTexelMagic, sizeof(magic)) != 0 ||
+       !in.read((char*)&count, sizeof(count))) {
+        return false;
+    }
+    records.resize(count);
+    return (bool)in.read((char*)records.data(), count * sizeof(TexelRecord));
+}
+
+static double sigmoid(double K, double eval)
+{
+    // 10^x written as exp(x * ln 10), pow is the hot spot of the whole tuner
+    return 1.0 / (1.0 + std::exp(-K * eval * 2.302585092994046 / 400.0));
+}
+
+static double linearEval(const TexelEntry& entry, const double* weights)
+{
+    double eval = 0;
+    for(int i = 0; i < kTunedCount; i++) {
+        eval += entry.terms[i] * weights[i];
+    }
+    return eval;
+}
+
+static double meanError(const std::vector<TexelEntry>& entries, const double* weights, double K, ThreadPool& pool)
+{
+    std::vector<double> errors(pool.threadCount(), 0.0);
+    parallelFor(pool, entries.size(), [&](size_t begin, size_t end, int t) {
+        double sum = 0;
+        for(size_t i = begin; i < end; i++) {
+            double diff = entries[i].result * 0.5 - sigmoid(K, linearEval(entries[i], weights));
+            sum += diff * diff;
+        }
+        errors[t] = sum;
+    });
+    double total = 0;
+    for(double error : errors) {
+        total += error;
+    }
+    return total / entries.size();
+}
+
+//
+// coarse to fine search for the K that best fits the untuned weights
+//
+static double fitK(const std::vector<TexelEntry>& entries, const double* weights, ThreadPool& pool)
+{
+    double best = 1.0;
+    double step = 0.5;
+    double bestError = meanError(entries, weights, best, pool);
+    for(int pass = 0; pass < 6; pass++) {
+        for(double K = std::max(0.05, best - step * 5); K <= best + step * 5; K += step) {
+            double error = meanError(entries, weights, K, pool);
+            if(error < bestError) {
+                bestError = error;
+                best = K;
+            }
+        }
+        step /= 5;
+    }
+    return best;
+}
+
+static bool writeHeader(const std::string& path, const double* weights, size_t positions, double K, double error)
+{
+    std::ofstream out(path);
+    if(!out) {
+        return false;
+    }
+    static const char* kNames[] = { "NoPiece", "Pawn", "Knight", "Bishop", "Rook", "Queen", "King (not tuned)" };
+    out << "#pragma once\n\n";
+    out << "//\n";
+    out << "// evaluation weights for the chess engine\n";
+    out << "// this file is written by `enginetool tune` -- rerun the tuner rather than editing by hand\n";
+    out << "// tuned on " << positions << " positions, K = " << K << ", mean squared error " << error << "\n";
+    out << "//\n";
+    out << "constexpr int kPieceValues[7] = {\n";
+    for(int piece = NoPiece; piece <= King; piece++) {
+        int value = kPieceValues[piece];
+        if(piece >= kTunedFirst && piece < kTunedFirst + kTunedCount) {
+            value = (int)std::lround(weights[piece - kTunedFirst]);
+        }
+        std::string number = std::to_string(value) + ",";
+        out << "    " << number << std::string(8 - number.length(), ' ') << "// " << kNames[piece] << "\n";
+    }
+    out << "};\n";
+    return true;
+}
+
+int runTune(const ToolArgs& args)
+{
+    auto files = positionalArgs(args);
+    if(files.empty()) {
+        std::cout << "usage: enginetool tune <positions.bin> [--threads N] [--iterations N] [--rate R] [--out header]" << std::endl;
+        return 1;
+    }
+    int threads = optionInt(args, "--threads", defaultThreadCount());
+    ThreadPool pool(threads);
+    int iterations = optionInt(args, "--iterations", 500);
+    double rate = std::stod(optionValue(args, "--rate", "2.0"));
+    std::string outPath = optionValue(args, "--out", std::string(ENGINETOOL_SOURCE_DIR) + "/classes/ChessEvalParams.h");
+
+    auto startTime = std::chrono::steady_clock::now();
+    auto elapsed = [&]() {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    };
+
+    std::vector<TexelRecord> records;
+    if(!loadRecords(files[0], records) || records.empty()) {
+        std::cout << "can't read positions from " << files[0] << std::endl;
+        return 1;
+    }
+
+    // run every position through the engine's evaluation once. the evaluation is
+    // linear in its weights, so the per piece terms it reports are all the
+    // gradient steps need afterwards.
+    std::vector<TexelEntry> entries(records.size());
+    std::vector<int> mismatches(pool.threadCount(), 0);
+    parallelFor(pool, records.size(), [&](size_t begin, size_t end, int t) {
+        ChessEngine engine;
+        int terms[7];
+        for(size_t i = begin; i < end; i++) {
+            unpackRecord(records[i], engine);
+            engine.evaluationTerms(terms);
+            int linear = 0;
+            for(int piece = Pawn; piece <= King; piece++) {
+                linear += terms[piece] * kPieceValues[piece];
+            }
+            if(linear != engine.evaluate()) {
+                mismatches[t]++;
+            }
+            for(int j = 0; j < kTunedCount; j++) {
+                entries[i].terms[j] = (int8_t)terms[kTunedFirst + j];
+            }
+            entries[i].result = records[i].result;
+        }
+    });
+    records.clear();
+    records.shrink_to_fit();
+    for(int count : mismatches) {
+        if(count) {
+            std::cout << "warning: evaluation is no longer linear in the tuned weights, results will be approximate" << std::endl;
+            break;
+        }
+    }
+    std::cout << "loaded " << entries.size() << " positions in " << elapsed() << "s using " << pool.threadCount() << " threads" << std::endl;
+
+    double weights[kTunedCount];
+    for(int i = 0; i < kTunedCount; i++) {
+        weights[i] = kPieceValues[kTunedFirst + i];
+    }
+    double K = fitK(entries, weights, pool);
+    double error = meanError(entries, weights, K, pool);
+    std::cout << "K = " << K << ", starting error " << error << std::endl;
+
+    // Adam steps on the full batch gradient, the weights are in centipawns
+    const double beta1 = 0.9;
+    const double beta2 = 0.999;
+    double momentum[kTunedCount] = {};
+    double velocity[kTunedCount] = {};
+    const double ln10 = std::log(10.0);
+    for(int iteration = 1; iteration <= iterations; iteration++) {
+        std::vector<std::array<double, kTunedCount>> partials(pool.threadCount());
+        parallelFor(pool, entries.size(), [&](size_t begin, size_t end, int t) {
+            std::array<double, kTunedCount> gradient = {};
+            for(size_t i = begin; i < end; i++) {
+                double s = sigmoid(K, linearEval(entries[i], weights));
+                double scale = (entries[i].result * 0.5 - s) * s * (1.0 - s);
+                for(int j = 0; j < kTunedCount; j++) {
+                    gradient[j] += scale * entries[i].terms[j];
+                }
+            }
+            partials[t] = gradient;
+        });
+        for(int j = 0; j < kTunedCount; j++) {
+            double gradient = 0;
+            for(const auto& partial : partials) {
+                gradient += partial[j];
+            }
+            gradient *= -2.0 * K * ln10 / 400.0 / entries.size();
+            momentum[j] = beta1 * momentum[j] + (1 - beta1) * gradient;
+            velocity[j] = beta2 * velocity[j] + (1 - beta2) * gradient * gradient;
+            double mHat = momentum[j] / (1 - std::pow(beta1, iteration));
+            double vHat = velocity[j] / (1 - std::pow(beta2, iteration));
+            weights[j] -= rate * mHat / (std::sqrt(vHat) + 1e-12);
+        }
+        if(iteration % 50 == 0 || iteration == iterations) {
+            error = meanError(entries, weights, K, pool);
+            std::cout << "iteration " << iteration << " error " << error << " [";
+            for(int j = 0; j < kTunedCount; j++) {
+                std::cout << (j ? " " : "") << std::lround(weights[j]);
+            }
+            std::cout << "] " << elapsed() << "s" << std::endl;
+        }
+    }
+
+    if(!writeHeader(outPath, weights, entries.size(), K, error)) {
+        std::cout << "can't write " << outPath << std::endl;
+        return 1;
+    }
+    std::cout << "wrote " << outPath << std::endl;
+    return 0;
+}